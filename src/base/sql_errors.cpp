@@ -47,6 +47,9 @@ std::ostream &operator <<(std::ostream &out, const SqlErrors::Type type) {
     case SqlErrors::WHERE_CLAUSE_ERROR:
       out << "Error processing WHERE condition";
       break;
+    case SqlErrors::INVALID_FILE_NAME:
+      out << "Unable to open the file";
+      break;
     case SqlErrors::ERROR_TABLE_SCAN:
       out << "Error reading table contents";
       break;
@@ -68,6 +71,9 @@ std::ostream &operator <<(std::ostream &out, const SqlErrors::Type type) {
     case SqlErrors::ERROR_NATURAL_JOIN:
       out << "Error in handling join step";
       break;
+    case SqlErrors::JOIN_TOO_WIDE:
+      out << "Join result has too many columns. Limit: 8";
+      break;
     case SqlErrors::INEXISTENT_TABLE:
       out << "Table does not exist";
       break;
@@ -21,6 +21,7 @@ struct SqlErrors {
     INVALID_SEARCH_CONDITION,
     INVALID_SORT_ATTRIBUTE,
     WHERE_CLAUSE_ERROR,
+    INVALID_FILE_NAME,
 
     ERROR_TABLE_SCAN = 200,
     ERROR_SORT,
@@ -29,6 +30,7 @@ struct SqlErrors {
     ERROR_SELECTION,
     ERROR_CROSS_PRODUCT,
     ERROR_NATURAL_JOIN,
+    JOIN_TOO_WIDE,
 
     INEXISTENT_TABLE = 300,
     TABLE_EXISTS,
@@ -7,24 +7,24 @@ const std::string symbol_list = " ,.()<>=+-*";
 Tokenizer::Tokenizer() {
 }
 
-bool Tokenizer::ReadOneWord(const std::string& list, std::string& word,
-    char& separator, int& leading_spaces) {
+bool Tokenizer::ReadOneWord(const std::string& list, std::size_t position,
+    std::string& word, char& separator, int& leading_spaces) {
   // Intialize so that we never pass the wrong values.
   word.clear();
   separator = '\0';
   leading_spaces = 0;
 
-  std::size_t symbol_position = list.find_first_of(symbol_list);
+  std::size_t symbol_position = list.find_first_of(symbol_list, position);
   if (symbol_position == std::string::npos) {
-    word = list;
+    word = list.substr(position);
     return true;
   }
 
   separator = list[symbol_position];
-  if (symbol_position == 0) {
+  if (symbol_position == position) {
     word = list[symbol_position];
   } else {
-    word = list.substr(0, symbol_position);
+    word = list.substr(position, symbol_position - position);
   }
 
   if (separator == ' ') {
@@ -41,10 +41,11 @@ bool Tokenizer::ReadOneWord(const std::string& list, std::string& word,
   return true;
 }
 
-bool Tokenizer::ReadLiteral(const std::string& input, std::string& literal) {
+bool Tokenizer::ReadLiteral(const std::string& input, std::size_t position,
+    std::string& literal) {
   literal.clear();
-  if (input[0] == '\"') {
-    int it = 0;
+  if (input[position] == '\"') {
+    int it = position;
     do {
       literal.push_back(input[it++]);
     } while (input[it] != '\"' && it < input.length());
@@ -77,3 +78,46 @@ bool Tokenizer::SplitIntoTwo(const std::string& word,
   second = word.substr(position + 1);
   return true;
 }
+
+bool Tokenizer::IsInteger(const std::string& word) {
+  if (word.empty()) {
+    return false;
+  }
+
+  for (char character : word) {
+    if (character < '0' || character > '9') {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void Tokenizer::SplitValues(const std::string& line,
+    std::vector<std::string>& values) {
+  values.clear();
+
+  bool quoted = false;
+  std::size_t start = 0;
+  for (std::size_t position = 0; position <= line.length(); position++) {
+    if (position < line.length() && line[position] == '\"') {
+      quoted = !quoted;
+    }
+
+    if (position == line.length() || (line[position] == ',' && !quoted)) {
+      values.push_back(Trim(line.substr(start, position - start)));
+      start = position + 1;
+    }
+  }
+}
+
+std::string Tokenizer::Trim(const std::string& word) {
+  const char *whitespace = " \t\r\n";
+  std::size_t first = word.find_first_not_of(whitespace);
+  if (first == std::string::npos) {
+    return std::string();
+  }
+
+  std::size_t last = word.find_last_not_of(whitespace);
+  return word.substr(first, last - first + 1);
+}
@@ -2,16 +2,25 @@
 #define SRC_BASE_TOKENIZER_H
 
 #include <string>
+#include <vector>
 
 class Tokenizer {
  public:
   Tokenizer();
 
-  static bool ReadOneWord(const std::string& list, std::string& word,
-      char& separator, int& leading_spaces);
-  static bool ReadLiteral(const std::string& input, std::string& literal);
+  // Read from position on, so a long input is never copied
+  static bool ReadOneWord(const std::string& list, std::size_t position,
+      std::string& word, char& separator, int& leading_spaces);
+  static bool ReadLiteral(const std::string& input, std::size_t position,
+      std::string& literal);
   static bool SplitIntoTwo(const std::string& word, const char& separator,
       std::string& first, std::string& second);
+  // Splits a comma separated line; commas inside "..." are kept
+  static void SplitValues(const std::string& line,
+      std::vector<std::string>& values);
+  static std::string Trim(const std::string& word);
+  // One or more digits
+  static bool IsInteger(const std::string& word);
 };
 
 #endif // SRC_BASE_TOKENIZER_H
@@ -63,6 +63,61 @@ QueryNode::QueryNodeType QueryNode::Type() const {
   return type_;
 }
 
+std::string QueryNode::TypeName() const {
+  switch (type_) {
+    case QUERY_NODE_TYPE_TABLE_SCAN:
+      return "TableScan";
+    case QUERY_NODE_TYPE_SORT:
+      return "Sort";
+    case QUERY_NODE_TYPE_DUPLICATE_ELIMINATION:
+      return "DuplicateElimination";
+    case QUERY_NODE_TYPE_PROJECTION:
+      return "Projection";
+    case QUERY_NODE_TYPE_SELECTION:
+      return "Selection";
+    case QUERY_NODE_TYPE_CROSS_PRODUCT:
+      return "CrossProduct";
+    case QUERY_NODE_TYPE_NATURAL_JOIN:
+      return "NaturalJoin";
+    case QUERY_NODE_TYPE_HASH_JOIN:
+      return "HashJoin";
+    case QUERY_NODE_TYPE_THETA_JOIN:
+      return "ThetaJoin";
+    case QUERY_NODE_TYPE_BAND_JOIN:
+      return "BandJoin";
+    default:
+      return "Unknown";
+  }
+}
+
+std::string QueryNode::Label() const {
+  if (type_ == QUERY_NODE_TYPE_TABLE_SCAN && !table_name_.empty()) {
+    return TypeName() + "(" + table_name_ + ")";
+  }
+
+  if (type_ == QUERY_NODE_TYPE_SORT && !sort_column_.empty()) {
+    return TypeName() + "(" + sort_column_ + ")";
+  }
+
+  if ((type_ == QUERY_NODE_TYPE_NATURAL_JOIN ||
+      type_ == QUERY_NODE_TYPE_HASH_JOIN) && !join_columns_.empty()) {
+    std::string label = TypeName() + "(";
+    for (int index = 0; index < join_columns_.size(); index++) {
+      label += (index == 0 ? "" : ", ") + join_columns_[index].first +
+          " = " + join_columns_[index].second;
+    }
+
+    return label + ")";
+  }
+
+  if (type_ == QUERY_NODE_TYPE_BAND_JOIN && !range_join_.empty()) {
+    return TypeName() + "(" + range_join_[0].first_ + ", " +
+        range_join_[0].second_ + ")";
+  }
+
+  return TypeName();
+}
+
 void QueryNode::SetType(QueryNodeType type) {
   type_ = type;
 }
@@ -77,8 +132,7 @@ void QueryNode::SetTableName(const std::string& table_name) {
 }
 
 void QueryNode::SetSortColumn(const std::string& sort_column) {
-  if (type_ != QueryNode::QUERY_NODE_TYPE_SORT &&
-      type_ != QueryNode::QUERY_NODE_TYPE_NATURAL_JOIN) {
+  if (type_ != QueryNode::QUERY_NODE_TYPE_SORT) {
     DEBUG_MSG("");
     return;
   }
@@ -98,7 +152,8 @@ void QueryNode::SetSelectList(const std::vector<std::string>& select_list) {
 void QueryNode::SetWhereHelper(
     WhereClauseHelperSelect *where_helper) {
   if (type_ != QueryNode::QUERY_NODE_TYPE_SELECTION &&
-      type_ != QueryNode::QUERY_NODE_TYPE_NATURAL_JOIN) {
+      type_ != QueryNode::QUERY_NODE_TYPE_THETA_JOIN &&
+      type_ != QueryNode::QUERY_NODE_TYPE_BAND_JOIN) {
     DEBUG_MSG("");
     return;
   }
@@ -115,6 +170,36 @@ void QueryNode::SetSortForJoin(bool sort_for_join) {
   sort_for_join_ = sort_for_join;
 }
 
+void QueryNode::SetRangeJoin(const RangeJoinAttributes& range_join) {
+  if (type_ != QueryNode::QUERY_NODE_TYPE_BAND_JOIN) {
+    DEBUG_MSG("");
+    return;
+  }
+
+  range_join_ = range_join;
+}
+
+void QueryNode::SetJoinColumns(const JoinAttributes& join_columns) {
+  if (type_ != QueryNode::QUERY_NODE_TYPE_NATURAL_JOIN &&
+      type_ != QueryNode::QUERY_NODE_TYPE_HASH_JOIN) {
+    DEBUG_MSG("");
+    return;
+  }
+
+  join_columns_ = join_columns;
+}
+
+void QueryNode::SetOutputColumns(
+    const std::vector<std::string>& output_columns) {
+  if (type_ != QueryNode::QUERY_NODE_TYPE_HASH_JOIN &&
+      type_ != QueryNode::QUERY_NODE_TYPE_CROSS_PRODUCT) {
+    DEBUG_MSG("");
+    return;
+  }
+
+  output_columns_ = output_columns;
+}
+
 bool QueryNode::TableName(std::string& table_name) {
   if (type_ != QueryNode::QUERY_NODE_TYPE_TABLE_SCAN) {
     DEBUG_MSG("");
@@ -126,8 +211,7 @@ bool QueryNode::TableName(std::string& table_name) {
 }
 
 bool QueryNode::SortColumn(std::string& sort_column) {
-  if (type_ != QueryNode::QUERY_NODE_TYPE_SORT &&
-      type_ != QueryNode::QUERY_NODE_TYPE_NATURAL_JOIN) {
+  if (type_ != QueryNode::QUERY_NODE_TYPE_SORT) {
     DEBUG_MSG("");
     return false;
   }
@@ -148,7 +232,8 @@ bool QueryNode::SelectList(std::vector<std::string>& select_list) {
 
 bool QueryNode::WhereHelper(WhereClauseHelperSelect *&helper) {
   if (type_ != QueryNode::QUERY_NODE_TYPE_SELECTION &&
-      type_ != QueryNode::QUERY_NODE_TYPE_NATURAL_JOIN) {
+      type_ != QueryNode::QUERY_NODE_TYPE_THETA_JOIN &&
+      type_ != QueryNode::QUERY_NODE_TYPE_BAND_JOIN) {
     DEBUG_MSG("");
     return false;
   }
@@ -164,3 +249,36 @@ bool QueryNode::SortForJoin() {
 
   return sort_for_join_;
 }
+
+bool QueryNode::RangeJoin(RangeJoinAttributes& range_join) {
+  if (type_ != QueryNode::QUERY_NODE_TYPE_BAND_JOIN) {
+    DEBUG_MSG("");
+    return false;
+  }
+
+  range_join = range_join_;
+  return true;
+}
+
+bool QueryNode::JoinColumns(JoinAttributes& join_columns) {
+  if (type_ != QueryNode::QUERY_NODE_TYPE_NATURAL_JOIN &&
+      type_ != QueryNode::QUERY_NODE_TYPE_HASH_JOIN) {
+    DEBUG_MSG("");
+    return false;
+  }
+
+  join_columns = join_columns_;
+  return true;
+}
+
+bool QueryNode::OutputColumns(std::vector<std::string>& output_columns) {
+  if (type_ != QueryNode::QUERY_NODE_TYPE_HASH_JOIN &&
+      type_ != QueryNode::QUERY_NODE_TYPE_CROSS_PRODUCT &&
+      type_ != QueryNode::QUERY_NODE_TYPE_THETA_JOIN) {
+    DEBUG_MSG("");
+    return false;
+  }
+
+  output_columns = output_columns_;
+  return true;
+}
@@ -4,7 +4,7 @@
 #include <string>
 #include <vector>
 
-class WhereClauseHelperSelect;
+#include "pqp/where_clause_helper_select.h"
 
 class QueryNode {
  public:
@@ -18,7 +18,10 @@ class QueryNode {
     QUERY_NODE_TYPE_SELECTION,
 
     QUERY_NODE_TYPE_CROSS_PRODUCT = 30,
-    QUERY_NODE_TYPE_NATURAL_JOIN
+    QUERY_NODE_TYPE_NATURAL_JOIN,
+    QUERY_NODE_TYPE_HASH_JOIN,
+    QUERY_NODE_TYPE_THETA_JOIN,
+    QUERY_NODE_TYPE_BAND_JOIN
   };
 
   QueryNode(QueryNodeType type);
@@ -32,6 +35,9 @@ class QueryNode {
   int ChildrenCount() const;
 
   QueryNodeType Type() const;
+  std::string TypeName() const;
+  // The type name with the table of a scan or the column of a sort or join
+  std::string Label() const;
   void SetType(QueryNodeType type);
 
   void SetTableName(const std::string& table_name);
@@ -39,12 +45,21 @@ class QueryNode {
   void SetSelectList(const std::vector<std::string>& select_list);
   void SetWhereHelper(WhereClauseHelperSelect *where_helper);
   void SetSortForJoin(bool sort_for_join);
+  void SetRangeJoin(const RangeJoinAttributes& range_join);
+  // The pairs of columns a join matches, of its left and right input
+  void SetJoinColumns(const JoinAttributes& join_columns);
+  // The columns of its inputs a join of a join tree keeps, all of them when
+  // none are set
+  void SetOutputColumns(const std::vector<std::string>& output_columns);
 
   bool TableName(std::string& table_name);
   bool SortColumn(std::string& sort_column);
   bool SelectList(std::vector<std::string>& select_list);
   bool WhereHelper(WhereClauseHelperSelect *&helper);
   bool SortForJoin();
+  bool RangeJoin(RangeJoinAttributes& range_join);
+  bool JoinColumns(JoinAttributes& join_columns);
+  bool OutputColumns(std::vector<std::string>& output_columns);
 
  private:
   std::string sort_column_;
@@ -52,6 +67,9 @@ class QueryNode {
   std::vector<std::string> select_list_;
   WhereClauseHelperSelect *where_helper_;
   bool sort_for_join_;
+  RangeJoinAttributes range_join_;
+  JoinAttributes join_columns_;
+  std::vector<std::string> output_columns_;
 
   QueryNodeType type_;
   std::vector<QueryNode *> children_;
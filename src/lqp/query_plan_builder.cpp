@@ -5,6 +5,7 @@
 
 #include "base/debug.h"
 #include "base/tokenizer.h"
+#include "lqp/query_plan_explainer.h"
 #include "pqp/query_runner.h"
 #include "pqp/query_runner_factory.h"
 
@@ -17,7 +18,9 @@ QueryPlanBuilder::QueryPlanBuilder(bool distinct,
       select_list_(select_list),
       table_list_(table_list),
       where_node_(where_node),
-      query_node_root_(nullptr) {
+      query_node_root_(nullptr),
+      explain_(false),
+      analyze_(false) {
   where_helper_ = new WhereClauseHelperSelect(
       WhereClauseHelperSelect::WHERE_CLAUSE_HELPER_TYPE_WHERE);
 }
@@ -75,17 +78,29 @@ bool QueryPlanBuilder::Build(SqlErrors::Type& error_code) {
   }
 
   JoinAttributes join_attributes;
+  RangeJoinAttributes range_join_attributes;
   PushCandidates push_candidates;
   if (where_node_) {
     where_helper_->OptimizationCandidates(push_candidates,
-      join_attributes);
+      join_attributes, range_join_attributes);
   }
 
+  SqlErrors::Type join_error_code = SqlErrors::NO_ERROR;
   bool joins_created = createJoins(next_node, join_attributes, push_candidates,
-      sort_node);
+      sort_node, join_error_code);
+  if (join_error_code != SqlErrors::NO_ERROR) {
+    DEBUG_MSG("");
+    error_code = join_error_code;
+    return false;
+  }
+
+  joins_created = joins_created || createBandJoin(next_node,
+      range_join_attributes, push_candidates, sort_node);
 
   if (!joins_created) {
-    if (where_node_) {
+    // A condition across tables is checked by the product that pairs them
+    int theta_join_index = thetaJoinIndex();
+    if (where_node_ && theta_join_index < 0) {
       QueryNode *selection_node = createNode(next_node,
           QueryNode::QUERY_NODE_TYPE_SELECTION);
       selection_node->SetWhereHelper(where_helper_);
@@ -93,14 +108,16 @@ bool QueryPlanBuilder::Build(SqlErrors::Type& error_code) {
     }
 
     if (!createProducts(0, next_node, push_candidates,
-        sort_node)) {
+        sort_node, theta_join_index)) {
       DEBUG_MSG("Failed to create products");
       error_code = SqlErrors::ERROR_SELECTION;
       return false;
     }
   }
 
-  if (sort_node != nullptr && duplication_elimination_node == nullptr) {
+  // An order no join or table gives is made above them, below the duplicate
+  // elimination
+  if (sort_node != nullptr) {
     QueryNode *next_child = next_node->Child(0);
     next_node->RemoveChild(next_child);
     next_node->AppendChild(sort_node);
@@ -109,17 +126,53 @@ bool QueryPlanBuilder::Build(SqlErrors::Type& error_code) {
     sort_node = nullptr;
   }
 
-  if (push_candidates.size() != 0 || (sort_node != nullptr &&
-        duplication_elimination_node == nullptr)) {
+  if (push_candidates.size() != 0 || sort_node != nullptr) {
     DEBUG_MSG("Push candidates(" << push_candidates.size() <<
         ")/sort node(" << (sort_node != nullptr) << ") not empty");
     error_code = SqlErrors::WHERE_CLAUSE_ERROR;
     return false;
   }
 
+  if (explain_) {
+    return explain(error_code);
+  }
+
+  QueryRunnerFactory factory(query_node_root_);
+  QueryRunner *query_runner = factory.Create();
+  bool return_value = sink_ ? query_runner->StartInto(sink_, error_code) :
+      query_runner->Start(error_code);
+
+  query_runner->DeleteTemporaryRelations();
+  delete query_runner;
+  return return_value;
+}
+
+void QueryPlanBuilder::SetSink(QueryResultCallback sink) {
+  sink_ = sink;
+}
+
+void QueryPlanBuilder::SetExplain(bool analyze) {
+  explain_ = true;
+  analyze_ = analyze;
+}
+
+// Private methods
+bool QueryPlanBuilder::explain(SqlErrors::Type& error_code) {
+  QueryPlanExplainer explainer(query_node_root_);
+  if (!analyze_) {
+    explainer.PrintPlan();
+    return true;
+  }
+
+  // The results are dropped, so only the work of the plan is measured
   QueryRunnerFactory factory(query_node_root_);
   QueryRunner *query_runner = factory.Create();
-  bool return_value = query_runner->Start(error_code);
+  bool return_value = query_runner->StartInto(
+      [](QueryRunner *child, TupleBatch& tuples) { return true; },
+      error_code);
+  if (return_value) {
+    explainer.PrintRun(query_runner);
+  }
 
   query_runner->DeleteTemporaryRelations();
   delete query_runner;
@@ -138,7 +191,8 @@ QueryNode *QueryPlanBuilder::createNode(QueryNode *parent,
 }
 
 bool QueryPlanBuilder::createProducts(const int index, QueryNode *parent,
-    PushCandidates& push_candidates, QueryNode *&sort_node) {
+    PushCandidates& push_candidates, QueryNode *&sort_node,
+    const int theta_join_index) {
   if (index >= table_list_.size()) {
     return true;
   } else if (index < 0) {
@@ -164,8 +218,12 @@ bool QueryPlanBuilder::createProducts(const int index, QueryNode *parent,
     return true;
   }
 
-  QueryNode *product_node = createNode(parent,
+  QueryNode *product_node = createNode(parent, index == theta_join_index ?
+      QueryNode::QUERY_NODE_TYPE_THETA_JOIN :
       QueryNode::QUERY_NODE_TYPE_CROSS_PRODUCT);
+  if (index == theta_join_index) {
+    product_node->SetWhereHelper(where_helper_);
+  }
 
   std::pair<QueryNode *, QueryNode *> node_endings = std::make_pair(
       nullptr, nullptr);
@@ -182,33 +240,271 @@ bool QueryPlanBuilder::createProducts(const int index, QueryNode *parent,
       next_child, QueryNode::QUERY_NODE_TYPE_TABLE_SCAN);
   table_scan_node->SetTableName(table_list_[index]);
 
-  return createProducts(index + 1, product_node, push_candidates, sort_node);
+  return createProducts(index + 1, product_node, push_candidates, sort_node,
+      theta_join_index);
+}
+
+int QueryPlanBuilder::thetaJoinIndex() const {
+  if (where_node_ == nullptr || table_list_.size() < 2) {
+    return -1;
+  }
+
+  std::vector<std::string> table_names;
+  where_helper_->ReferencedTables(table_names);
+  if (table_names.size() < 2) {
+    return -1;
+  }
+
+  int theta_join_index = table_list_.size();
+  for (auto table_name : table_names) {
+    auto table_position = std::find(table_list_.begin(), table_list_.end(),
+        table_name);
+    if (table_position == table_list_.end()) {
+      DEBUG_MSG("");
+      return -1;
+    }
+
+    theta_join_index = std::min<int>(theta_join_index,
+        table_position - table_list_.begin());
+  }
+
+  return theta_join_index;
 }
 
 bool QueryPlanBuilder::createJoins(QueryNode *parent,
     JoinAttributes join_attributes, PushCandidates& push_candidates,
-    QueryNode *&sort_node) {
-  if (join_attributes.size() > 1) {
-    DEBUG_MSG("Join works with one column name");
+    QueryNode *&sort_node, SqlErrors::Type& error_code) {
+  if (join_attributes.empty() || table_list_.size() < 2) {
     return false;
   }
 
-  if (table_list_.size() != 2) {
+  // The merge join sorts both tables on the join column, which is only worth
+  // it when the result is wanted in that order; otherwise a hash join reads
+  // the tables once when the smaller one fits in memory, and three times
+  // when it partitions them. The ORDER BY is then done above the join.
+  std::vector<std::string> join_attribute_names;
+  bool sort_consumed = false;
+  if (table_list_.size() == 2 &&
+      validateJoinAttributes(join_attributes, join_attribute_names) &&
+      sort_node != nullptr) {
+    std::string table_name_sort, attribute_name_sort;
+    Tokenizer::SplitIntoTwo(sort_column_, '.',
+        table_name_sort, attribute_name_sort);
+    for (int index = 0; index < table_list_.size(); index++) {
+      sort_consumed = sort_consumed || table_name_sort == "*" ||
+          (table_name_sort == table_list_[index] &&
+          attribute_name_sort == join_attribute_names[index]);
+    }
+  }
+
+  // Every join below the top one may run next to a temporary relation the
+  // one above writes its result to
+  int memory = StorageAdapter::Get()->MainMemorySize();
+  bool hash_joinable = memory >= std::max<int>(3, table_list_.size());
+  if (!sort_consumed && !hash_joinable && join_attribute_names.empty()) {
+    DEBUG_MSG("Not enough memory for a join of " << table_list_.size() <<
+        " tables");
     return false;
   }
 
-  std::string join_attribute_name;
-  if (!validateJoinAttributes(join_attributes, join_attribute_name)) {
-    DEBUG_MSG("Invalid join attributes");
+  // The merge join keeps every column of both tables, where a hash join
+  // keeps only those used above it
+  int merge_join_width = join_attribute_names.empty() ? 0 :
+      tableColumns(table_list_[0]).size() +
+      tableColumns(table_list_[1]).size();
+  if (merge_join_width > MAX_NUM_OF_FIELDS_IN_RELATION) {
+    if (!hash_joinable) {
+      ERROR_MSG("A join of " << table_list_[0] << " and " << table_list_[1] <<
+          " has " << merge_join_width << " columns");
+      error_code = SqlErrors::JOIN_TOO_WIDE;
+      return false;
+    }
+
+    sort_consumed = false;
+  }
+
+  // The factors pushed down to a table are out of the condition, and those
+  // left other than the equalities are checked on the joined tuples
+  bool selection_above =
+      where_node_->Child(0)->ChildrenCount() > join_attributes.size();
+  if (selection_above) {
+    QueryNode *selection_node = createNode(parent,
+        QueryNode::QUERY_NODE_TYPE_SELECTION);
+    selection_node->SetWhereHelper(where_helper_);
+    parent = selection_node;
+  }
+
+  if (sort_consumed || !hash_joinable) {
+    return createMergeJoin(parent, join_attribute_names, push_candidates,
+        sort_node);
+  }
+
+  // Every equality is checked by the hash join of the later of its tables,
+  // so the selection needs only the columns of the other factors
+  if (selection_above) {
+    where_helper_->DropJoinFactors();
+  }
+
+  // A left deep tree, joining the tables in the order of the FROM clause
+  // but taking the first one with an equality on the tables joined so far
+  // before those without, which are joined by a cross product
+  std::vector<std::string> joined_tables = { table_list_[0] };
+  std::vector<std::string> remaining_tables(table_list_.begin() + 1,
+      table_list_.end());
+  std::vector<QueryNode *> join_nodes;
+  QueryNode *tree_node = createTableBranch(table_list_[0], push_candidates);
+  while (!remaining_tables.empty()) {
+    auto next_table = remaining_tables.begin();
+    JoinAttributes join_columns;
+    for (auto table = remaining_tables.begin();
+        table != remaining_tables.end() && join_columns.empty(); table++) {
+      next_table = table;
+      for (auto& join_attribute : join_attributes) {
+        std::string table_name_first, attribute_name_first;
+        Tokenizer::SplitIntoTwo(join_attribute.first, '.',
+            table_name_first, attribute_name_first);
+        std::string table_name_second, attribute_name_second;
+        Tokenizer::SplitIntoTwo(join_attribute.second, '.',
+            table_name_second, attribute_name_second);
+
+        bool first_joined = std::find(joined_tables.begin(),
+            joined_tables.end(), table_name_first) != joined_tables.end();
+        bool second_joined = std::find(joined_tables.begin(),
+            joined_tables.end(), table_name_second) != joined_tables.end();
+        if (first_joined && table_name_second == *table) {
+          join_columns.push_back(join_attribute);
+        } else if (second_joined && table_name_first == *table) {
+          join_columns.push_back(std::make_pair(join_attribute.second,
+              join_attribute.first));
+        }
+      }
+    }
+
+    if (join_columns.empty()) {
+      next_table = remaining_tables.begin();
+    }
+
+    QueryNode *join_node = createNode(nullptr, join_columns.empty() ?
+        QueryNode::QUERY_NODE_TYPE_CROSS_PRODUCT :
+        QueryNode::QUERY_NODE_TYPE_HASH_JOIN);
+    if (!join_columns.empty()) {
+      join_node->SetJoinColumns(join_columns);
+    }
+
+    join_node->AppendChild(tree_node);
+    join_node->AppendChild(createTableBranch(*next_table, push_candidates));
+    tree_node = join_node;
+    join_nodes.push_back(join_node);
+
+    joined_tables.push_back(*next_table);
+    remaining_tables.erase(next_table);
+  }
+
+  parent->AppendChild(tree_node);
+  if (!setOutputColumns(join_nodes, joined_tables, selection_above)) {
+    DEBUG_MSG("");
+    error_code = SqlErrors::JOIN_TOO_WIDE;
     return false;
   }
 
+  return true;
+}
+
+bool QueryPlanBuilder::setOutputColumns(
+    const std::vector<QueryNode *>& join_nodes,
+    const std::vector<std::string>& joined_tables,
+    const bool selection_above) const {
+  // The columns each join keeps are those needed by the joins above it,
+  // gathered from the top of the tree down
+  bool all_columns = select_list_.size() == 1 && select_list_[0] == "*";
+  std::vector<std::vector<std::string> > needed_columns(join_nodes.size());
+  std::vector<std::string> columns = select_list_;
+  if (!sort_column_.empty()) {
+    columns.push_back(sort_column_);
+  }
+
+  if (selection_above) {
+    std::vector<std::string> where_columns;
+    where_helper_->ReferencedColumns(where_columns);
+    columns.insert(columns.end(), where_columns.begin(), where_columns.end());
+  }
+
+  for (int index = join_nodes.size() - 1; index >= 0; index--) {
+    needed_columns[index] = columns;
+    JoinAttributes join_columns;
+    if (join_nodes[index]->JoinColumns(join_columns)) {
+      for (auto& join_column : join_columns) {
+        columns.push_back(join_column.first);
+      }
+    }
+  }
+
+  // Then the columns of each join are those of its inputs it keeps, or the
+  // first of them when it keeps none, as a relation has at least one
+  std::vector<std::string> input_columns = tableColumns(joined_tables[0]);
+  for (int index = 0; index < join_nodes.size(); index++) {
+    std::vector<std::string> table_columns =
+        tableColumns(joined_tables[index + 1]);
+    input_columns.insert(input_columns.end(), table_columns.begin(),
+        table_columns.end());
+
+    std::vector<std::string> output_columns;
+    for (auto& column : input_columns) {
+      if (all_columns || std::find(needed_columns[index].begin(),
+          needed_columns[index].end(), column) !=
+          needed_columns[index].end()) {
+        output_columns.push_back(column);
+      }
+    }
+
+    if (output_columns.empty() && !input_columns.empty()) {
+      output_columns.push_back(input_columns[0]);
+    }
+
+    if (output_columns.size() > MAX_NUM_OF_FIELDS_IN_RELATION) {
+      ERROR_MSG("A join of " << index + 2 << " tables keeps " <<
+          output_columns.size() << " columns");
+      return false;
+    }
+
+    if (!all_columns) {
+      join_nodes[index]->SetOutputColumns(output_columns);
+    }
+
+    input_columns = output_columns;
+  }
+
+  return true;
+}
+
+std::vector<std::string> QueryPlanBuilder::tableColumns(
+    const std::string& table) const {
+  std::vector<std::string> columns;
+  Relation *relation = StorageAdapter::Get()->GetRelation(table);
+  if (relation == nullptr) {
+    return columns;
+  }
+
+  for (auto& field_name : relation->getSchemaRef().getFieldNames()) {
+    columns.push_back(table + "." + field_name);
+  }
+
+  return columns;
+}
+
+bool QueryPlanBuilder::createMergeJoin(QueryNode *parent,
+    const std::vector<std::string>& join_attribute_names,
+    PushCandidates& push_candidates, QueryNode *&sort_node) {
   QueryNode *join_node = createNode(parent,
       QueryNode::QUERY_NODE_TYPE_NATURAL_JOIN);
-  join_node->SetWhereHelper(where_helper_);
-  join_node->SetSortColumn(join_attribute_name);
-
-  for (auto table : table_list_) {
+  JoinAttributes join_columns = { std::make_pair(
+      table_list_[0] + "." + join_attribute_names[0],
+      table_list_[1] + "." + join_attribute_names[1]) };
+  join_node->SetJoinColumns(join_columns);
+
+  for (int index = 0; index < table_list_.size(); index++) {
+    const std::string& table = table_list_[index];
+    const std::string& join_attribute_name = join_attribute_names[index];
     QueryNode *next_node = join_node;
     std::pair<QueryNode *, QueryNode *> node_endings = std::make_pair(
         nullptr, nullptr);
@@ -246,14 +542,97 @@ bool QueryPlanBuilder::createJoins(QueryNode *parent,
   return true;
 }
 
+QueryNode *QueryPlanBuilder::createTableBranch(const std::string& table,
+    PushCandidates& push_candidates) {
+  std::pair<QueryNode *, QueryNode *> node_endings = std::make_pair(
+      nullptr, nullptr);
+  QueryNode *no_sort_node = nullptr;
+  createPushCandidateNodes(push_candidates, no_sort_node, table,
+      node_endings);
+
+  QueryNode *table_scan_node = createNode(node_endings.second,
+      QueryNode::QUERY_NODE_TYPE_TABLE_SCAN);
+  table_scan_node->SetTableName(table);
+  return node_endings.first != nullptr ? node_endings.first : table_scan_node;
+}
+
+bool QueryPlanBuilder::createBandJoin(QueryNode *parent,
+    const RangeJoinAttributes& range_join_attributes,
+    PushCandidates& push_candidates, QueryNode *&sort_node) {
+  if (table_list_.size() != 2 || range_join_attributes.empty()) {
+    return false;
+  }
+
+  // The result comes in no useful order, and DISTINCT needs its sort below
+  // the duplicate elimination
+  if (sort_node != nullptr && distinct_) {
+    return false;
+  }
+
+  // Each table is sorted in two passes, on sublists of a memory load, and
+  // a merge of no more sublists than main memory blocks
+  int memory = StorageAdapter::Get()->MainMemorySize();
+  for (auto table : table_list_) {
+    Relation *relation = StorageAdapter::Get()->GetRelation(table);
+    if (relation == nullptr || relation->getNumOfBlocks() > memory * memory) {
+      DEBUG_MSG("Table too large to sort for a band join: " << table);
+      return false;
+    }
+  }
+
+  for (auto& range_join_attribute : range_join_attributes) {
+    if (range_join_attribute.first_ != range_join_attributes[0].first_ ||
+        range_join_attribute.second_ != range_join_attributes[0].second_) {
+      DEBUG_MSG("Band join works with one pair of columns");
+      return false;
+    }
+  }
+
+  QueryNode *join_node = createNode(parent,
+      QueryNode::QUERY_NODE_TYPE_BAND_JOIN);
+  join_node->SetWhereHelper(where_helper_);
+  join_node->SetRangeJoin(range_join_attributes);
+
+  std::vector<std::string> join_columns = {
+      range_join_attributes[0].first_,
+      range_join_attributes[0].second_
+  };
+  for (int index = 0; index < table_list_.size(); index++) {
+    std::string table_name, attribute_name;
+    Tokenizer::SplitIntoTwo(join_columns[index], '.',
+        table_name, attribute_name);
+
+    QueryNode *next_node = join_node;
+    std::pair<QueryNode *, QueryNode *> node_endings = std::make_pair(
+        nullptr, nullptr);
+    QueryNode *join_sort_node = createNode(nullptr,
+        QueryNode::QUERY_NODE_TYPE_SORT);
+    join_sort_node->SetSortColumn(attribute_name);
+    join_sort_node->SetSortForJoin(true);
+    createPushCandidateNodes(push_candidates, join_sort_node,
+        table_list_[index], node_endings);
+    if (node_endings.first != nullptr) {
+      next_node->AppendChild(node_endings.first);
+      next_node = node_endings.second;
+    }
+
+    QueryNode *table_scan_node = createNode(next_node,
+        QueryNode::QUERY_NODE_TYPE_TABLE_SCAN);
+    table_scan_node->SetTableName(table_list_[index]);
+  }
+
+  return true;
+}
+
 bool QueryPlanBuilder::validateJoinAttributes(
-    const JoinAttributes join_attributes, std::string& join_attribute_name) {
+    const JoinAttributes join_attributes,
+    std::vector<std::string>& join_attribute_names) {
   if (join_attributes.empty()) {
     DEBUG_MSG("Empty join attributes");
     return false;
   }
 
-  join_attribute_name.clear();
+  join_attribute_names.clear();
   for (auto candidate_pair : join_attributes) {
     std::string table_name_first, attribute_name_first;
     Tokenizer::SplitIntoTwo(candidate_pair.first, '.',
@@ -265,20 +644,23 @@ bool QueryPlanBuilder::validateJoinAttributes(
 
     if (table_name_first == table_name_second) {
       DEBUG_MSG("");
+      join_attribute_names.clear();
       return false;
     }
 
-    if (attribute_name_first != attribute_name_second) {
-      DEBUG_MSG("");
-      return false;
+    // The columns are kept in the order of the tables in the FROM clause
+    if (table_name_first != table_list_[0]) {
+      std::swap(attribute_name_first, attribute_name_second);
     }
 
-    if (join_attribute_name.empty()) {
-      join_attribute_name = attribute_name_first;
+    if (join_attribute_names.empty()) {
+      join_attribute_names = { attribute_name_first, attribute_name_second };
     }
 
-    if (join_attribute_name != attribute_name_first) {
+    if (join_attribute_names[0] != attribute_name_first ||
+        join_attribute_names[1] != attribute_name_second) {
       DEBUG_MSG("");
+      join_attribute_names.clear();
       return false;
     }
   }
@@ -8,6 +8,7 @@
 #include "base/sql_errors.h"
 #include "lqp/query_node.h"
 #include "parser/sql_node.h"
+#include "pqp/query_runner.h"
 #include "pqp/where_clause_helper_select.h"
 
 class QueryPlanBuilder {
@@ -18,17 +19,53 @@ class QueryPlanBuilder {
   virtual ~QueryPlanBuilder();
 
   bool Build(SqlErrors::Type& error_code);
+  // The results go to sink instead of being printed
+  void SetSink(QueryResultCallback sink);
+  // Prints the plan instead of running it; with analyze the plan runs,
+  // without printing the results, and is printed with what it did
+  void SetExplain(bool analyze);
 
  private:
+  bool explain(SqlErrors::Type& error_code);
   QueryNode *createNode(QueryNode *parent,
       const QueryNode::QueryNodeType product_type);
   bool createProducts(const int index, QueryNode *parent,
-      PushCandidates& push_candidates, QueryNode *&sort_node);
+      PushCandidates& push_candidates, QueryNode *&sort_node,
+      const int theta_join_index);
+  // The product the WHERE condition is checked in, the one of the first
+  // table it uses, or -1 when the condition uses fewer than two tables
+  int thetaJoinIndex() const;
+  // Joins the tables on the equalities of their columns, in a left deep
+  // tree of hash joins, or with a merge join of two tables when the result
+  // is wanted in the order of the join column
   bool createJoins(QueryNode *parent, JoinAttributes join_attributes,
+      PushCandidates& push_candidates, QueryNode *&sort_node,
+      SqlErrors::Type& error_code);
+  bool createMergeJoin(QueryNode *parent,
+      const std::vector<std::string>& join_attribute_names,
+      PushCandidates& push_candidates, QueryNode *&sort_node);
+  // Each join of the tree keeps the columns of the select list, of the
+  // condition checked above the tree and of the joins above it; false when
+  // one still has more than a relation can hold
+  bool setOutputColumns(const std::vector<QueryNode *>& join_nodes,
+      const std::vector<std::string>& joined_tables,
+      const bool selection_above) const;
+  // The columns of a table, named with the table
+  std::vector<std::string> tableColumns(const std::string& table) const;
+  // The factors pushed down to the table over its scan
+  QueryNode *createTableBranch(const std::string& table,
+      PushCandidates& push_candidates);
+
+  // Joins two tables on comparisons of the same pair of INT columns, with
+  // both tables sorted on their column
+  bool createBandJoin(QueryNode *parent,
+      const RangeJoinAttributes& range_join_attributes,
       PushCandidates& push_candidates, QueryNode *&sort_node);
 
+  // The column of each of two tables every equality is on, when they are
+  // all on the same pair
   bool validateJoinAttributes(const JoinAttributes join_attributes,
-      std::string& join_attribute_name);
+      std::vector<std::string>& join_attribute_names);
   void createPushCandidateNodes(PushCandidates& push_candidates,
       QueryNode *&sort_node,
       const std::string table_name,
@@ -43,6 +80,9 @@ class QueryPlanBuilder {
   SqlNode *where_node_;
   QueryNode *query_node_root_;
   WhereClauseHelperSelect *where_helper_;
+  QueryResultCallback sink_;
+  bool explain_;
+  bool analyze_;
 };
 
 #endif // SRC_LQP_QUERY_PLAN_BUILDER_H
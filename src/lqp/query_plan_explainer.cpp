@@ -0,0 +1,142 @@
+#include "lqp/query_plan_explainer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+#include "base/debug.h"
+#include "pqp/where_clause_helper_select.h"
+
+QueryPlanExplainer::QueryPlanExplainer(QueryNode *root)
+  : root_(root),
+    storage_adapter_(StorageAdapter::Get()) {
+  if (root_ != nullptr) {
+    estimate(root_);
+  }
+}
+
+QueryPlanExplainer::~QueryPlanExplainer() {
+}
+
+void QueryPlanExplainer::PrintPlan() const {
+  if (root_ != nullptr) {
+    printNode(root_, 0);
+  }
+}
+
+void QueryPlanExplainer::PrintRun(QueryRunner *root) const {
+  if (root != nullptr) {
+    printRunner(root, 0);
+  }
+}
+
+// Private methods
+double QueryPlanExplainer::estimate(QueryNode *node) {
+  std::vector<double> inputs;
+  for (auto child : node->Children()) {
+    inputs.push_back(estimate(child));
+  }
+
+  double tuples = inputs.empty() ? 0 : inputs[0];
+  switch (node->Type()) {
+    case QueryNode::QUERY_NODE_TYPE_TABLE_SCAN: {
+      std::string table_name;
+      if (node->TableName(table_name)) {
+        tuples = storage_adapter_->RelationTupleSize(table_name);
+      }
+
+      break;
+    }
+    case QueryNode::QUERY_NODE_TYPE_SELECTION: {
+      WhereClauseHelperSelect *where_helper = nullptr;
+      if (node->WhereHelper(where_helper) && where_helper != nullptr) {
+        tuples *= where_helper->Selectivity();
+      }
+
+      break;
+    }
+    case QueryNode::QUERY_NODE_TYPE_DUPLICATE_ELIMINATION:
+      tuples /= 2;
+      break;
+    case QueryNode::QUERY_NODE_TYPE_CROSS_PRODUCT:
+      for (int index = 1; index < inputs.size(); index++) {
+        tuples *= inputs[index];
+      }
+
+      break;
+    case QueryNode::QUERY_NODE_TYPE_THETA_JOIN:
+    case QueryNode::QUERY_NODE_TYPE_BAND_JOIN: {
+      for (int index = 1; index < inputs.size(); index++) {
+        tuples *= inputs[index];
+      }
+
+      WhereClauseHelperSelect *where_helper = nullptr;
+      if (node->WhereHelper(where_helper) && where_helper != nullptr) {
+        tuples *= where_helper->Selectivity();
+      }
+
+      break;
+    }
+    case QueryNode::QUERY_NODE_TYPE_NATURAL_JOIN:
+    case QueryNode::QUERY_NODE_TYPE_HASH_JOIN:
+      // Each tuple of the larger input is taken to match one of the other
+      if (inputs.size() == 2) {
+        tuples = std::min(inputs[0], inputs[1]);
+      }
+
+      break;
+    default:
+      break;
+  }
+
+  estimates_[node] = tuples;
+  return tuples;
+}
+
+void QueryPlanExplainer::printNode(QueryNode *node, const int depth) const {
+  ERROR_MSG(std::string(2 * depth, ' ') << node->Label() << " (" <<
+      estimateText(node) << ")");
+  for (auto child : node->Children()) {
+    printNode(child, depth + 1);
+  }
+}
+
+void QueryPlanExplainer::printRunner(QueryRunner *runner,
+    const int depth) const {
+  const RunnerStats& stats = runner->Stats();
+  unsigned long tuples_in = 0;
+  for (auto child : runner->ChildRunners()) {
+    tuples_in += child->Stats().tuples;
+  }
+
+  DiskAccessStats disk_stats = storage_adapter_->IoOperatorStats(
+      runner->IoTag());
+
+  std::ostringstream line;
+  line << std::string(2 * depth, ' ') << runner->Label() << " (" <<
+      estimateText(runner->Node()) << ") (actual rows=" << stats.tuples <<
+      " in=" << tuples_in << " batches=" << stats.batches <<
+      " runs=" << stats.runs <<
+      " blocks read=" << disk_stats.blocks_read <<
+      " written=" << disk_stats.blocks_written <<
+      " memory=" << storage_adapter_->IoOperatorMemoryBlocks(
+          runner->IoTag()) <<
+      std::fixed << std::setprecision(2) <<
+      " time=" << stats.wall_time << " ms" <<
+      " disk=" << disk_stats.time << " ms)";
+  ERROR_MSG(line.str());
+
+  for (auto child : runner->ChildRunners()) {
+    printRunner(child, depth + 1);
+  }
+}
+
+std::string QueryPlanExplainer::estimateText(QueryNode *node) const {
+  auto estimate = estimates_.find(node);
+  if (estimate == estimates_.end()) {
+    return "rows=?";
+  }
+
+  return "rows=" + std::to_string(std::llround(estimate->second));
+}
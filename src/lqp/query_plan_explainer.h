@@ -0,0 +1,38 @@
+#ifndef SRC_LQP_QUERY_PLAN_EXPLAINER_H
+#define SRC_LQP_QUERY_PLAN_EXPLAINER_H
+
+#include <map>
+#include <string>
+
+#include "lqp/query_node.h"
+#include "pqp/query_runner.h"
+#include "storage/storage_adapter.h"
+
+// Prints a query plan for EXPLAIN, one operator per line under its parent,
+// with the number of tuples it is estimated to produce. The estimates follow
+// the textbook rules: a table scan produces the tuples of the table, a
+// selection the fraction its condition keeps, a product the product of its
+// inputs, a join on a key the smaller input and a duplicate elimination half
+// of its input. For EXPLAIN ANALYZE the plan that ran is printed with what
+// every operator did.
+class QueryPlanExplainer {
+ public:
+  // The estimates are made here, before the plan runs
+  QueryPlanExplainer(QueryNode *root);
+  virtual ~QueryPlanExplainer();
+
+  void PrintPlan() const;
+  void PrintRun(QueryRunner *root) const;
+
+ private:
+  double estimate(QueryNode *node);
+  void printNode(QueryNode *node, const int depth) const;
+  void printRunner(QueryRunner *runner, const int depth) const;
+  std::string estimateText(QueryNode *node) const;
+
+  QueryNode *root_;
+  std::map<QueryNode *, double> estimates_;
+  StorageAdapter *storage_adapter_;
+};
+
+#endif // SRC_LQP_QUERY_PLAN_EXPLAINER_H
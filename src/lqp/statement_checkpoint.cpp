@@ -0,0 +1,31 @@
+#include "lqp/statement_checkpoint.h"
+
+#include "base/debug.h"
+
+StatementCheckpoint::StatementCheckpoint(const SqlNode *root_node)
+  : Statement(root_node) {
+}
+
+StatementCheckpoint::~StatementCheckpoint() {
+}
+
+void StatementCheckpoint::Execute(SqlErrors::Type& error_code) {
+  if (RootNode() == nullptr ||
+      RootNode()->Type() != SqlNode::NODE_TYPE_CHECKPOINT_STATEMENT) {
+    DEBUG_MSG("");
+    error_code = SqlErrors::UNACCEPTABLE_STATEMENT;
+    return;
+  }
+
+  std::string file_name;
+  if (!RootNode()->Child(0)->FileName(file_name)) {
+    DEBUG_MSG("");
+    error_code = SqlErrors::INVALID_FILE_NAME;
+    return;
+  }
+
+  if (!Storage()->SaveImage(file_name)) {
+    ERROR_MSG("Unable to write the image: " << file_name);
+    error_code = SqlErrors::INVALID_FILE_NAME;
+  }
+}
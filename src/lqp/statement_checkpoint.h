@@ -0,0 +1,18 @@
+#ifndef SRC_LQP_STATEMENT_CHECKPOINT_H
+#define SRC_LQP_STATEMENT_CHECKPOINT_H
+
+#include "lqp/statement.h"
+#include "parser/sql_node.h"
+
+// CHECKPOINT TO "file": writes every table and its blocks to an image file,
+// which --restore= starts a later run from without running the statements
+// that filled the tables again.
+class StatementCheckpoint : public Statement {
+ public:
+  StatementCheckpoint(const SqlNode *root_node);
+  virtual ~StatementCheckpoint();
+
+  void Execute(SqlErrors::Type& error_code) override;
+};
+
+#endif // SRC_LQP_STATEMENT_CHECKPOINT_H
@@ -2,10 +2,12 @@
 
 #include <memory>
 
+#include "lqp/statement_checkpoint.h"
 #include "lqp/statement_create_table.h"
 #include "lqp/statement_delete.h"
 #include "lqp/statement_drop_table.h"
 #include "lqp/statement_insert.h"
+#include "lqp/statement_load.h"
 #include "lqp/statement_select.h"
 
 StatementFactory::StatementFactory(SqlNode *root)
@@ -19,6 +21,8 @@ Statement *StatementFactory::Create() const {
 
   SqlNode::NodeType node_type = root_->Type();
   switch (node_type) {
+    case SqlNode::NODE_TYPE_CHECKPOINT_STATEMENT:
+      return new StatementCheckpoint(root_);
     case SqlNode::NODE_TYPE_CREATE_TABLE_STATEMENT:
       return new StatementCreateTable(root_);
     case SqlNode::NODE_TYPE_DELETE_STATEMENT:
@@ -27,8 +31,15 @@ Statement *StatementFactory::Create() const {
       return new StatementDropTable(root_);
     case SqlNode::NODE_TYPE_INSERT_STATEMENT:
       return new StatementInsert(root_);
+    case SqlNode::NODE_TYPE_LOAD_STATEMENT:
+      return new StatementLoad(root_);
     case SqlNode::NODE_TYPE_SELECT_STATEMENT:
       return new StatementSelect(root_);
+    case SqlNode::NODE_TYPE_EXPLAIN_STATEMENT: {
+      StatementSelect *statement = new StatementSelect(root_->Child(0));
+      statement->SetExplain(root_->Data() == "ANALYZE");
+      return statement;
+    }
     default:
       return nullptr;
   }
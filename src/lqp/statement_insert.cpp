@@ -1,6 +1,11 @@
 #include "lqp/statement_insert.h"
 
+#include <algorithm>
+
 #include "base/debug.h"
+#include "lqp/statement_select.h"
+#include "pqp/insert_sink.h"
+#include "pqp/tuple_batch.h"
 
 StatementInsert::StatementInsert(const SqlNode *root_node)
   : Statement(root_node) {
@@ -30,24 +35,165 @@ void StatementInsert::Execute(SqlErrors::Type& error_code) {
     return;
   }
 
+  SqlNode *tuples_node = RootNode()->Child(2);
+  if (tuples_node->ChildrenCount() > 0 && tuples_node->Child(0)->Type() ==
+      SqlNode::NODE_TYPE_SELECT_STATEMENT) {
+    insertSelected(table_name, error_code);
+  } else {
+    insertValues(table_name, error_code);
+  }
+}
+
+bool StatementInsert::SetTables(const std::vector<std::string> tables) {
+  if (tables.size() != 1) {
+    DEBUG_MSG("");
+    return false;
+  }
+
+  return Statement::SetTables(tables);
+}
+
+// Private methods
+void StatementInsert::insertValues(const std::string& table_name,
+    SqlErrors::Type& error_code) {
   if (!RootNode()->Child(2)->InsertTuples(values_)) {
     DEBUG_MSG("");
     error_code = SqlErrors::INVALID_VALUES;
     return;
   }
 
-  if (!Storage()->CreateTupleAndAppend(table_name,
+  if (!Storage()->CreateTuplesAndAppend(table_name,
       field_names_, values_)) {
     DEBUG_MSG("");
     error_code = SqlErrors::UNKNOWN_ERROR;
   }
 }
 
-bool StatementInsert::SetTables(const std::vector<std::string> tables) {
-  if (tables.size() != 1) {
+void StatementInsert::insertSelected(const std::string& table_name,
+    SqlErrors::Type& error_code) {
+  Relation *relation = Storage()->GetRelation(table_name);
+  if (relation == nullptr) {
+    DEBUG_MSG("");
+    error_code = SqlErrors::INEXISTENT_TABLE;
+    return;
+  }
+
+  // Like the values of an INSERT, the result has to fill every field
+  std::vector<enum FIELD_TYPE> field_types;
+  for (auto field_name : field_names_) {
+    enum FIELD_TYPE field_type;
+    if (!Storage()->IsValidColumnName(table_name, field_name) ||
+        !Storage()->AttributeType(table_name, field_name, field_type)) {
+      DEBUG_MSG("");
+      error_code = SqlErrors::INVALID_ATTRIBUTES;
+      return;
+    }
+
+    field_types.push_back(field_type);
+  }
+
+  if (field_names_.size() != relation->getSchemaRef().getNumOfFields()) {
+    DEBUG_MSG("Invalid fields for relation");
+    error_code = SqlErrors::INVALID_ATTRIBUTES;
+    return;
+  }
+
+  std::vector<std::string> tables;
+  for (auto child : RootNode()->Child(2)->Child(0)->Children()) {
+    if (child->Type() == SqlNode::NODE_TYPE_TABLE_LIST) {
+      child->TableList(tables);
+    }
+  }
+
+  if (std::find(tables.begin(), tables.end(), table_name) == tables.end()) {
+    runSelect(relation, true, error_code);
+    return;
+  }
+
+  // Scanning the relation while appending to it would read the new tuples
+  // too, so its result is collected in a temporary relation first
+
+  std::string temporary_name;
+  if (!Storage()->CreateDummyRelation("Insert_", field_names_, field_types,
+      temporary_name)) {
     DEBUG_MSG("");
+    error_code = SqlErrors::UNKNOWN_ERROR;
+    return;
+  }
+
+  if (runSelect(Storage()->GetRelation(temporary_name), false, error_code) &&
+      !copyTuples(temporary_name, relation)) {
+    DEBUG_MSG("");
+    error_code = SqlErrors::UNKNOWN_ERROR;
+  }
+
+  Storage()->DeleteDummyRelation(temporary_name);
+}
+
+bool StatementInsert::runSelect(Relation *relation, const bool staging,
+    SqlErrors::Type& error_code) {
+  // A failed conversion rejects the whole statement, so a result converted
+  // is only copied to the relation once all of it was
+  InsertSink sink(relation, field_names_);
+  sink.SetStaging(staging);
+  StatementSelect statement_select(RootNode()->Child(2)->Child(0));
+  statement_select.SetSink(sink.Callback());
+  statement_select.Execute(error_code);
+
+  if (sink.Mismatched()) {
+    DEBUG_MSG("");
+    error_code = SqlErrors::INVALID_VALUES;
     return false;
   }
 
-  return Statement::SetTables(tables);
+  if (error_code != SqlErrors::NO_ERROR) {
+    DEBUG_MSG("");
+    return false;
+  }
+
+  if (!statement_select.Succeeded()) {
+    DEBUG_MSG("");
+    error_code = SqlErrors::UNKNOWN_ERROR;
+    return false;
+  }
+
+  std::string staging_relation_name = sink.StagingRelationName();
+  if (!staging_relation_name.empty() &&
+      !copyTuples(staging_relation_name, relation)) {
+    DEBUG_MSG("");
+    error_code = SqlErrors::UNKNOWN_ERROR;
+    return false;
+  }
+
+  return true;
+}
+
+bool StatementInsert::copyTuples(const std::string& source_name,
+    Relation *relation) {
+  Relation *source = Storage()->GetRelation(source_name);
+  InsertSink sink(relation, field_names_);
+
+  int block_count = Storage()->RelationBlockSize(source);
+  std::vector<Block *> blocks;
+  for (int start_index = 0; start_index < block_count;
+      start_index += blocks.size()) {
+    if (!Storage()->ReadRelationBlocks(source, start_index, 0,
+        Storage()->MainMemorySize(), blocks)) {
+      DEBUG_MSG("");
+      return false;
+    }
+
+    TupleBatch tuples(blocks);
+    bool appended = sink.Append(nullptr, tuples);
+    for (auto block : blocks) {
+      block->clear();
+    }
+
+    if (!appended) {
+      DEBUG_MSG("");
+      return false;
+    }
+  }
+
+  return true;
 }
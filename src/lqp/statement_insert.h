@@ -15,8 +15,17 @@ class StatementInsert : public Statement {
   virtual bool SetTables(const std::vector<std::string> tables) override;
 
  private:
+  void insertValues(const std::string& table_name,
+      SqlErrors::Type& error_code);
+  void insertSelected(const std::string& table_name,
+      SqlErrors::Type& error_code);
+  bool runSelect(Relation *relation, const bool staging,
+      SqlErrors::Type& error_code);
+  bool copyTuples(const std::string& source_name, Relation *relation);
+
   std::vector<std::string> field_names_;
-  std::vector<std::string> values_;
+  // One value list per row
+  TupleList values_;
 };
 
 #endif // SRC_LQP_STATEMENT_INSERT_H
@@ -0,0 +1,98 @@
+#include "lqp/statement_load.h"
+
+#include <fstream>
+
+#include "base/debug.h"
+#include "base/tokenizer.h"
+
+const int load_batch_rows = 4096;
+
+StatementLoad::StatementLoad(const SqlNode *root_node)
+  : Statement(root_node) {
+}
+
+StatementLoad::~StatementLoad() {
+}
+
+void StatementLoad::Execute(SqlErrors::Type& error_code) {
+  if (RootNode() == nullptr ||
+      RootNode()->Type() != SqlNode::NODE_TYPE_LOAD_STATEMENT) {
+    DEBUG_MSG("");
+    error_code = SqlErrors::UNACCEPTABLE_STATEMENT;
+    return;
+  }
+
+  std::string table_name;
+  if (!RootNode()->Child(0)->TableName(table_name)) {
+    DEBUG_MSG("");
+    error_code = SqlErrors::INVALID_TABLE_NAME;
+    return;
+  }
+
+  std::vector<std::string> field_names;
+  if (!Storage()->RelationFieldNames(table_name, field_names)) {
+    DEBUG_MSG("");
+    error_code = SqlErrors::INEXISTENT_TABLE;
+    return;
+  }
+
+  std::string file_name;
+  std::ifstream load_file;
+  if (RootNode()->Child(1)->FileName(file_name)) {
+    load_file.open(file_name);
+  }
+
+  if (!load_file.is_open()) {
+    ERROR_MSG("Unable to open file: " << file_name);
+    error_code = SqlErrors::INVALID_FILE_NAME;
+    return;
+  }
+
+  // A batch is checked as a whole, so a bad row stops the load before its
+  // batch is appended; the batches before it stay
+  TupleList rows;
+  rows.reserve(load_batch_rows);
+  std::string line;
+  int line_number = 0;
+  bool end_of_file = false;
+  while (!end_of_file) {
+    end_of_file = !std::getline(load_file, line);
+    line_number++;
+
+    if (!end_of_file) {
+      line = Tokenizer::Trim(line);
+      if (line.empty()) {
+        continue;
+      }
+
+      rows.emplace_back();
+      Tokenizer::SplitValues(line, rows.back());
+      if (rows.back().size() != field_names.size()) {
+        ERROR_MSG("Wrong number of values on line " << line_number <<
+            " of " << file_name);
+        error_code = SqlErrors::INVALID_VALUES;
+        return;
+      }
+    }
+
+    if (rows.size() == load_batch_rows || (end_of_file && !rows.empty())) {
+      if (!Storage()->CreateTuplesAndAppend(table_name, field_names, rows)) {
+        ERROR_MSG("Invalid values before line " << line_number <<
+            " of " << file_name);
+        error_code = SqlErrors::INVALID_VALUES;
+        return;
+      }
+
+      rows.clear();
+    }
+  }
+}
+
+bool StatementLoad::SetTables(const std::vector<std::string> tables) {
+  if (tables.size() != 1) {
+    DEBUG_MSG("");
+    return false;
+  }
+
+  return Statement::SetTables(tables);
+}
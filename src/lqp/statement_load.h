@@ -0,0 +1,21 @@
+#ifndef SRC_LQP_STATEMENT_LOAD_H
+#define SRC_LQP_STATEMENT_LOAD_H
+
+#include "lqp/statement.h"
+#include "parser/sql_node.h"
+
+// LOAD "file" INTO table: appends one tuple per line of the file, with the
+// values comma separated in the order of the table fields and written as in
+// INSERT. The file is read and appended in batches of rows.
+class StatementLoad : public Statement {
+ public:
+  StatementLoad(const SqlNode *root_node);
+  virtual ~StatementLoad();
+
+  void Execute(SqlErrors::Type& error_code) override;
+
+ protected:
+  virtual bool SetTables(const std::vector<std::string> tables) override;
+};
+
+#endif // SRC_LQP_STATEMENT_LOAD_H
@@ -9,7 +9,10 @@
 StatementSelect::StatementSelect(const SqlNode *root_node)
   : Statement(root_node),
     distinct_(false),
-    where_node_(nullptr) {
+    where_node_(nullptr),
+    explain_(false),
+    analyze_(false),
+    succeeded_(false) {
 }
 
 StatementSelect::~StatementSelect() {
@@ -81,10 +84,33 @@ void StatementSelect::Execute(SqlErrors::Type& error_code) {
 
   QueryPlanBuilder query_plan_builder(distinct_, sort_column_,
       select_list_, table_list_, where_node_);
+  if (sink_) {
+    query_plan_builder.SetSink(sink_);
+  }
+
+  if (explain_) {
+    query_plan_builder.SetExplain(analyze_);
+  }
+
   if (!query_plan_builder.Build(error_code)) {
     DEBUG_MSG("");
     return;
   }
+
+  succeeded_ = true;
+}
+
+void StatementSelect::SetSink(QueryResultCallback sink) {
+  sink_ = sink;
+}
+
+void StatementSelect::SetExplain(bool analyze) {
+  explain_ = true;
+  analyze_ = analyze;
+}
+
+bool StatementSelect::Succeeded() const {
+  return succeeded_;
 }
 
 bool StatementSelect::validateLists(SqlErrors::Type& error_code) const {
@@ -3,6 +3,7 @@
 
 #include "lqp/statement.h"
 #include "parser/sql_node.h"
+#include "pqp/query_runner.h"
 
 class StatementSelect : public Statement {
  public:
@@ -10,6 +11,13 @@ class StatementSelect : public Statement {
   virtual ~StatementSelect();
 
   void Execute(SqlErrors::Type& error_code) override;
+  // The results go to sink instead of being printed
+  void SetSink(QueryResultCallback sink);
+  // Prints the plan instead of the results; with analyze the plan is run
+  // and printed with what every operator did
+  void SetExplain(bool analyze);
+  // Whether Execute() ran the query into the sink to the end
+  bool Succeeded() const;
 
  private:
   bool validateLists(SqlErrors::Type& error_code) const;
@@ -19,6 +27,10 @@ class StatementSelect : public Statement {
   std::vector<std::string> table_list_;
   SqlNode *where_node_;
   std::string sort_column_;
+  QueryResultCallback sink_;
+  bool explain_;
+  bool analyze_;
+  bool succeeded_;
 };
 
 #endif // SRC_LQP_STATEMENT_SELECT_H
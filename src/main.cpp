@@ -20,25 +20,35 @@ int main(int argc, char *argv[]) {
   QueryManager *query_manager = QueryManager::Get();
 
   std::ifstream command_file;
-  std::istream *input_stream;
-  if (argc > 1) {
+  std::istream *input_stream = &std::cin;
+  for (int index = 1; index < argc; index++) {
+    if (std::string(argv[index]).compare(0, 2, "--") == 0) {
+      query_manager->SetArgument(argv[index]);
+      continue;
+    }
+
+    if (command_file.is_open()) {
+      ERROR_MSG("Ignoring extra command file: " << argv[index]);
+      continue;
+    }
+
     std::ios_base::iostate mask = command_file.exceptions() | std::ios::failbit;
     command_file.exceptions(mask);
     try {
-      command_file.open(argv[1]);
+      command_file.open(argv[index]);
     }
     catch (std::ios_base::failure& e) {
       ERROR_MSG("Unable to open file; check the path. Error: " << e.what());
       return 1;
     }
 
+    // Reaching the end of the file sets the failbit too
+    command_file.exceptions(std::ios::goodbit);
     input_stream = &command_file;
+  }
 
-    if (argc == 3) {
-      query_manager->SetArgument(argv[2]);
-    }
-  } else {
-    input_stream = &std::cin;
+  if (!query_manager->Initialize()) {
+    return 1;
   }
 
   std::string user_command;
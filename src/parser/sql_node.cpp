@@ -290,18 +290,39 @@ bool SqlNode::ValueList(std::vector<std::string>& value_list) const {
   return true;
 }
 
-bool SqlNode::InsertTuples(std::vector<std::string>& tuples) const {
+bool SqlNode::InsertTuples(
+    std::vector<std::vector<std::string> >& tuples) const {
   if (type_ != NODE_TYPE_INSERT_TUPLES || children_.size() <= 0) {
     DEBUG_MSG("");
     return false;
   }
 
-  if (children_[0]->Type() == NODE_TYPE_VALUE_LIST) {
-    return children_[0]->ValueList(tuples);
+  tuples.reserve(children_.size());
+  for (auto value_list : children_) {
+    if (value_list->Type() != NODE_TYPE_VALUE_LIST) {
+      DEBUG_MSG("");
+      return false;
+    }
+
+    tuples.emplace_back();
+    if (!value_list->ValueList(tuples.back())) {
+      DEBUG_MSG("");
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool SqlNode::FileName(std::string& file_name) const {
+  // The name is kept as the literal it was written as
+  if (type_ != NODE_TYPE_FILE_NAME || data_.length() < 2) {
+    DEBUG_MSG("");
+    return false;
   }
 
-  DEBUG_MSG("");
-  return false;
+  file_name = data_.substr(1, data_.length() - 2);
+  return !file_name.empty();
 }
 
 bool SqlNode::ValidateSearchCondition() const {
@@ -15,6 +15,9 @@ class SqlNode {
     NODE_TYPE_SELECT_STATEMENT,
     NODE_TYPE_DELETE_STATEMENT,
     NODE_TYPE_INSERT_STATEMENT,
+    NODE_TYPE_LOAD_STATEMENT,
+    NODE_TYPE_EXPLAIN_STATEMENT,
+    NODE_TYPE_CHECKPOINT_STATEMENT,
 
     NODE_TYPE_TABLE_LIST = 20,
     NODE_TYPE_TABLE_NAME,
@@ -36,7 +39,9 @@ class SqlNode {
     NODE_TYPE_BOOLEAN_TERM,
     NODE_TYPE_BOOLEAN_FACTOR,
     NODE_TYPE_EXPRESSION,
-    NODE_TYPE_TERM
+    NODE_TYPE_TERM,
+
+    NODE_TYPE_FILE_NAME = 70
   };
 
   SqlNode(NodeType type, std::string data = "");
@@ -65,7 +70,9 @@ class SqlNode {
   bool AttributeList(std::vector<std::string>& attribute_list) const;
   bool Value(std::string& value) const;
   bool ValueList(std::vector<std::string>& value_list) const;
-  bool InsertTuples(std::vector<std::string>& tuples) const;
+  // One value list per row
+  bool InsertTuples(std::vector<std::vector<std::string> >& tuples) const;
+  bool FileName(std::string& file_name) const;
   bool ValidateSearchCondition() const;
 
  private:
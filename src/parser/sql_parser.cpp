@@ -33,17 +33,15 @@ bool SqlParser::readWord(std::string& word) {
 
   char separator = '\0';
   int leading_spaces = 0;
-  if (!Tokenizer::ReadOneWord(
-      std::string(input_query_.substr(current_query_position_)), word,
+  if (!Tokenizer::ReadOneWord(input_query_, current_query_position_, word,
       separator, leading_spaces)) {
     DEBUG_MSG("");
     return false;
   }
 
   if (!word.compare(" ")) {
-    return Tokenizer::ReadOneWord(
-        std::string(input_query_.substr(current_query_position_ + 1)), word,
-        separator, leading_spaces);
+    return Tokenizer::ReadOneWord(input_query_, current_query_position_ + 1,
+        word, separator, leading_spaces);
   }
 
   return true;
@@ -57,8 +55,7 @@ bool SqlParser::consumeWord(std::string& word) {
 
   char separator = '\0';
   int leading_spaces = 0;
-  if (!Tokenizer::ReadOneWord(
-      std::string(input_query_.substr(current_query_position_)), word,
+  if (!Tokenizer::ReadOneWord(input_query_, current_query_position_, word,
       separator, leading_spaces)) {
     DEBUG_MSG("");
     return false;
@@ -84,8 +81,8 @@ bool SqlParser::consumeLiteral(std::string& literal) {
   }
 
   consumeSpaceCharacters();
-  if (Tokenizer::ReadLiteral(
-      std::string(input_query_.substr(current_query_position_)), literal)) {
+  if (Tokenizer::ReadLiteral(input_query_, current_query_position_,
+      literal)) {
     current_query_position_ += literal.length();
     return true;
   }
@@ -106,7 +103,7 @@ bool SqlParser::isTableName(const std::string& table_name) {
 }
 
 bool SqlParser::isInteger(const std::string& integer) {
-  return std::regex_match(integer, std::regex("^[0-9]+$"));
+  return Tokenizer::IsInteger(integer);
 }
 
 bool SqlParser::isCompOp(const std::string& comp_op) {
@@ -114,7 +111,7 @@ bool SqlParser::isCompOp(const std::string& comp_op) {
 }
 
 bool SqlParser::isOperatorSign(const std::string& sign) {
-  return std::regex_match(sign, std::regex("^[+-*]$"));
+  return std::regex_match(sign, std::regex("^[-+*]$"));
 }
 
 bool SqlParser::isEndOfStatement() {
@@ -166,6 +163,21 @@ bool SqlParser::handleStatement(SqlNode *node) {
         node, SqlNode::NODE_TYPE_INSERT_STATEMENT));
   }
 
+  if (!first_word.compare("LOAD")) {
+    return handleLoadStatement(createNodeAndAppendAsChild(
+        node, SqlNode::NODE_TYPE_LOAD_STATEMENT));
+  }
+
+  if (!first_word.compare("EXPLAIN")) {
+    return handleExplainStatement(createNodeAndAppendAsChild(
+        node, SqlNode::NODE_TYPE_EXPLAIN_STATEMENT));
+  }
+
+  if (!first_word.compare("CHECKPOINT")) {
+    return handleCheckpointStatement(createNodeAndAppendAsChild(
+        node, SqlNode::NODE_TYPE_CHECKPOINT_STATEMENT));
+  }
+
   DEBUG_MSG("");
 	return false;
 }
@@ -355,6 +367,77 @@ bool SqlParser::handleInsertStatement(SqlNode *node) {
   return isEndOfStatement();
 }
 
+bool SqlParser::handleLoadStatement(SqlNode *node) {
+  std::string word;
+  if (!consumeWord(word) || word.compare("LOAD")) {
+    DEBUG_MSG("");
+    return false;
+  }
+
+  std::string file_name;
+  if (!consumeLiteral(file_name)) {
+    DEBUG_MSG("");
+    return false;
+  }
+
+  if (!consumeWord(word) || word.compare("INTO")) {
+    DEBUG_MSG("");
+    return false;
+  }
+
+  if (!handleTableName(createNodeAndAppendAsChild(
+      node, SqlNode::NODE_TYPE_TABLE_NAME))) {
+    DEBUG_MSG("");
+    return false;
+  }
+
+  createNodeAndAppendAsChild(node, SqlNode::NODE_TYPE_FILE_NAME, file_name);
+  return isEndOfStatement();
+}
+
+bool SqlParser::handleExplainStatement(SqlNode *node) {
+  std::string word;
+  if (!consumeWord(word) || word.compare("EXPLAIN")) {
+    DEBUG_MSG("");
+    return false;
+  }
+
+  if (readWord(word) && !word.compare("ANALYZE")) {
+    consumeWord(word);
+    node->SetData(word);
+  }
+
+  if (!readWord(word) || word.compare("SELECT")) {
+    DEBUG_MSG("");
+    return false;
+  }
+
+  return handleSelectStatement(createNodeAndAppendAsChild(
+      node, SqlNode::NODE_TYPE_SELECT_STATEMENT));
+}
+
+bool SqlParser::handleCheckpointStatement(SqlNode *node) {
+  std::string word;
+  if (!consumeWord(word) || word.compare("CHECKPOINT")) {
+    DEBUG_MSG("");
+    return false;
+  }
+
+  if (!consumeWord(word) || word.compare("TO")) {
+    DEBUG_MSG("");
+    return false;
+  }
+
+  std::string file_name;
+  if (!consumeLiteral(file_name)) {
+    DEBUG_MSG("");
+    return false;
+  }
+
+  createNodeAndAppendAsChild(node, SqlNode::NODE_TYPE_FILE_NAME, file_name);
+  return isEndOfStatement();
+}
+
 bool SqlParser::handleAttributeTypeList(SqlNode *node) {
   if (!handleAttributeName(createNodeAndAppendAsChild(
       node, SqlNode::NODE_TYPE_ATTRIBUTE_NAME))) {
@@ -442,21 +525,24 @@ bool SqlParser::handleInsertTuples(SqlNode *node) {
   if (readWord(word) && !word.compare("VALUES")) {
     consumeWord(word);
 
-    if (!consumeWord(word) || word.compare("(")) {
-      DEBUG_MSG("");
-      return false;
-    }
+    // One value list per row, separated by ','
+    do {
+      if (!consumeWord(word) || word.compare("(")) {
+        DEBUG_MSG("");
+        return false;
+      }
 
-    if (!handleValueList(createNodeAndAppendAsChild(
-        node, SqlNode::NODE_TYPE_VALUE_LIST))) {
-      DEBUG_MSG("");
-      return false;
-    }
+      if (!handleValueList(createNodeAndAppendAsChild(
+          node, SqlNode::NODE_TYPE_VALUE_LIST))) {
+        DEBUG_MSG("");
+        return false;
+      }
 
-    if (!consumeWord(word) || word.compare(")")) {
-      DEBUG_MSG("");
-      return false;
-    }
+      if (!consumeWord(word) || word.compare(")")) {
+        DEBUG_MSG("");
+        return false;
+      }
+    } while (readWord(word) && !word.compare(",") && consumeWord(word));
 
     return true;
   }
@@ -574,7 +660,7 @@ bool SqlParser::handleExpression(SqlNode *node) {
       return false;
     }
 
-    if (handleOperatorSign(node)) {
+    if (!handleOperatorSign(node)) {
       DEBUG_MSG("");
       return false;
     }
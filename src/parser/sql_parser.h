@@ -32,6 +32,9 @@ class SqlParser {
   bool handleSelectStatement(SqlNode *node);
   bool handleDeleteStatement(SqlNode *node);
   bool handleInsertStatement(SqlNode *node);
+  bool handleLoadStatement(SqlNode *node);
+  bool handleExplainStatement(SqlNode *node);
+  bool handleCheckpointStatement(SqlNode *node);
   bool handleAttributeTypeList(SqlNode *node);
   bool handleDataType(SqlNode *node);
   bool handleSelectList(SqlNode *node);
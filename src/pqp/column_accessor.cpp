@@ -0,0 +1,111 @@
+#include "pqp/column_accessor.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "base/debug.h"
+
+ColumnAccessor::ColumnAccessor()
+  : schema_(nullptr),
+    offset_(-1),
+    type_(FIELD_TYPE()) {
+}
+
+bool ColumnAccessor::Bind(const Schema& schema,
+    const std::string& column_name) {
+  if (!schema.fieldNameExists(column_name)) {
+    DEBUG_MSG("Column not in schema: " << column_name);
+    *this = ColumnAccessor();
+    return false;
+  }
+
+  return Bind(schema, schema.getFieldOffset(column_name));
+}
+
+bool ColumnAccessor::Bind(const Schema& schema, int offset) {
+  if (offset < 0 || offset >= schema.getNumOfFields()) {
+    DEBUG_MSG("Offset out of bound: " << offset);
+    *this = ColumnAccessor();
+    return false;
+  }
+
+  schema_ = &schema;
+  offset_ = offset;
+  type_ = schema.getFieldType(offset);
+  return true;
+}
+
+bool ColumnAccessor::IsBoundTo(const Schema& schema) const {
+  return schema_ == &schema;
+}
+
+int ColumnAccessor::Offset() const {
+  return offset_;
+}
+
+enum FIELD_TYPE ColumnAccessor::Type() const {
+  return type_;
+}
+
+int ColumnAccessor::Integer(const Tuple& tuple) const {
+  return tuple.getField(offset_).integer;
+}
+
+Str20 ColumnAccessor::String(const Tuple& tuple) const {
+  return tuple.getField(offset_).str;
+}
+
+std::string ColumnAccessor::Value(const Tuple& tuple) const {
+  if (type_ == INT) {
+    int value = Integer(tuple);
+    if (value == -1) {
+      return "NULL";
+    }
+
+    return std::to_string(value);
+  }
+
+  return *String(tuple);
+}
+
+bool ColumnAccessor::Less(const Tuple& first, const ColumnAccessor& other,
+    const Tuple& second) const {
+  if (type_ == INT) {
+    return Integer(first) < other.Integer(second);
+  }
+
+  return compareStrings(String(first), other.String(second), true) < 0;
+}
+
+bool ColumnAccessor::Equal(const Tuple& first, const ColumnAccessor& other,
+    const Tuple& second) const {
+  if (type_ == INT) {
+    return Integer(first) == other.Integer(second);
+  }
+
+  return compareStrings(String(first), other.String(second), false) == 0;
+}
+
+// Private methods
+int ColumnAccessor::compareStrings(const Str20& first, const Str20& second,
+    bool null_as_empty) {
+  int first_length = first.length;
+  int second_length = second.length;
+  if (null_as_empty) {
+    if (first_length == 4 && memcmp(first.chars, "NULL", 4) == 0) {
+      first_length = 0;
+    }
+
+    if (second_length == 4 && memcmp(second.chars, "NULL", 4) == 0) {
+      second_length = 0;
+    }
+  }
+
+  int result = memcmp(first.chars, second.chars,
+      std::min(first_length, second_length));
+  if (result != 0) {
+    return result;
+  }
+
+  return first_length - second_length;
+}
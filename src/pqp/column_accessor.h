@@ -0,0 +1,47 @@
+#ifndef SRC_PQP_COLUMN_ACCESSOR_H
+#define SRC_PQP_COLUMN_ACCESSOR_H
+
+#include <string>
+
+#include "storage/storage_manager_headers.h"
+
+// One column of a schema, resolved to its offset and type when it is bound, so
+// reading it from a tuple needs no name lookup. The accessor remembers the
+// schema it was bound to (see Tuple::getSchemaRef()); a runner checks
+// IsBoundTo() with the schema of each tuple and binds again only when the
+// schema changes. The schema has to outlive the binding.
+class ColumnAccessor {
+ public:
+  ColumnAccessor();
+
+  bool Bind(const Schema& schema, const std::string& column_name);
+  bool Bind(const Schema& schema, int offset);
+  bool IsBoundTo(const Schema& schema) const;
+
+  int Offset() const;
+  enum FIELD_TYPE Type() const;
+
+  int Integer(const Tuple& tuple) const;
+  Str20 String(const Tuple& tuple) const;
+  // The value as it is printed and compared in a WHERE clause: an INT of -1
+  // is "NULL"
+  std::string Value(const Tuple& tuple) const;
+
+  // Compare the column of first with the column other binds in second. Less()
+  // orders a "NULL" string as an empty one; Equal() compares the values as
+  // they are.
+  bool Less(const Tuple& first, const ColumnAccessor& other,
+      const Tuple& second) const;
+  bool Equal(const Tuple& first, const ColumnAccessor& other,
+      const Tuple& second) const;
+
+ private:
+  static int compareStrings(const Str20& first, const Str20& second,
+      bool null_as_empty);
+
+  const Schema *schema_;
+  int offset_;
+  enum FIELD_TYPE type_;
+};
+
+#endif // SRC_PQP_COLUMN_ACCESSOR_H
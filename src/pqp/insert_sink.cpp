@@ -0,0 +1,140 @@
+#include "pqp/insert_sink.h"
+
+#include <algorithm>
+
+#include "base/debug.h"
+
+InsertSink::InsertSink(Relation *relation,
+    const std::vector<std::string>& field_names)
+  : relation_(relation),
+    field_names_(field_names),
+    mismatched_(false),
+    staging_(false),
+    storage_adapter_(StorageAdapter::Get()) {
+}
+
+InsertSink::~InsertSink() {
+  if (!staging_relation_name_.empty()) {
+    storage_adapter_->DeleteDummyRelation(staging_relation_name_);
+  }
+}
+
+QueryResultCallback InsertSink::Callback() {
+  return std::bind(&InsertSink::Append, this, std::placeholders::_1,
+      std::placeholders::_2);
+}
+
+bool InsertSink::Append(QueryRunner *child, TupleBatch& tuples) {
+  if (relation_ == nullptr) {
+    DEBUG_MSG("Relation is null");
+    return false;
+  }
+
+  for (const Tuple& tuple : tuples) {
+    const Schema& schema = tuple.getSchemaRef();
+    if ((columns_.empty() || !columns_[0].IsBoundTo(schema)) &&
+        !bind(schema)) {
+      DEBUG_MSG("");
+      mismatched_ = true;
+      return false;
+    }
+
+    Tuple insert_tuple = relation_->createTuple();
+    for (int index = 0; index < columns_.size(); index++) {
+      bool set = false;
+      if (converted_[index]) {
+        set = storage_adapter_->SetTupleField(insert_tuple, offsets_[index],
+            columns_[index].Value(tuple));
+        mismatched_ = !set;
+      } else if (columns_[index].Type() == INT) {
+        set = insert_tuple.setField(offsets_[index],
+            columns_[index].Integer(tuple));
+      } else {
+        set = insert_tuple.setField(offsets_[index],
+            *columns_[index].String(tuple));
+      }
+
+      if (!set) {
+        DEBUG_MSG("");
+        return false;
+      }
+    }
+
+    if (!storage_adapter_->AppendTuple(relation_, insert_tuple)) {
+      DEBUG_MSG("");
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool InsertSink::Mismatched() const {
+  return mismatched_;
+}
+
+void InsertSink::SetStaging(bool staging) {
+  staging_ = staging;
+}
+
+std::string InsertSink::StagingRelationName() const {
+  return staging_relation_name_;
+}
+
+// Private methods
+bool InsertSink::bind(const Schema& schema) {
+  const Schema& relation_schema = relation_->getSchemaRef();
+  if (schema.getNumOfFields() != field_names_.size() ||
+      relation_schema.getNumOfFields() != field_names_.size()) {
+    ERROR_MSG("Expected " << relation_schema.getNumOfFields() <<
+        " values, got " << schema.getNumOfFields());
+    return false;
+  }
+
+  columns_.assign(field_names_.size(), ColumnAccessor());
+  offsets_.clear();
+  converted_.clear();
+  for (int index = 0; index < field_names_.size(); index++) {
+    if (!relation_schema.fieldNameExists(field_names_[index])) {
+      ERROR_MSG("Invalid attribute name: " << field_names_[index]);
+      return false;
+    }
+
+    int offset = relation_schema.getFieldOffset(field_names_[index]);
+    if (!columns_[index].Bind(schema, index)) {
+      DEBUG_MSG("");
+      return false;
+    }
+
+    offsets_.push_back(offset);
+    converted_.push_back(
+        columns_[index].Type() != relation_schema.getFieldType(offset));
+  }
+
+  bool converted = std::find(converted_.begin(), converted_.end(), true) !=
+      converted_.end();
+  if (converted && staging_ && staging_relation_name_.empty()) {
+    return createStagingRelation() && bind(schema);
+  }
+
+  return true;
+}
+
+bool InsertSink::createStagingRelation() {
+  // The fields come in the order of the result, with the types of the
+  // relation, so copying them back converts nothing
+  const Schema& relation_schema = relation_->getSchemaRef();
+  std::vector<enum FIELD_TYPE> field_types;
+  for (auto& field_name : field_names_) {
+    field_types.push_back(relation_schema.getFieldType(field_name));
+  }
+
+  if (!storage_adapter_->CreateDummyRelation("Insert_", field_names_,
+      field_types, staging_relation_name_)) {
+    DEBUG_MSG("");
+    return false;
+  }
+
+  relation_ = storage_adapter_->GetRelation(staging_relation_name_);
+  return relation_ != nullptr;
+}
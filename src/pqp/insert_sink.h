@@ -0,0 +1,48 @@
+#ifndef SRC_PQP_INSERT_SINK_H
+#define SRC_PQP_INSERT_SINK_H
+
+#include <string>
+#include <vector>
+
+#include "pqp/column_accessor.h"
+#include "pqp/query_runner.h"
+#include "storage/storage_adapter.h"
+
+// Takes the place of printing at the root of a query plan: every result tuple
+// is appended to the relation as it comes, through the append buffer, so the
+// result is never kept. Field i of a result tuple goes to field_names[i] of the
+// relation, which has to name all its fields. A value of another type, like
+// the strings of a projection, is converted as if it was written in INSERT.
+// A conversion can fail on any tuple, so with staging the tuples of a result
+// that needs one go to a temporary relation instead, to be copied once the
+// whole result is in.
+class InsertSink {
+ public:
+  InsertSink(Relation *relation, const std::vector<std::string>& field_names);
+  virtual ~InsertSink();
+
+  QueryResultCallback Callback();
+  bool Append(QueryRunner *child, TupleBatch& tuples);
+  // Whether the result tuples did not fit the relation
+  bool Mismatched() const;
+  void SetStaging(bool staging);
+  // The temporary relation the tuples went to, empty if none was needed
+  std::string StagingRelationName() const;
+
+ private:
+  bool bind(const Schema& schema);
+  bool createStagingRelation();
+
+  Relation *relation_;
+  std::vector<std::string> field_names_;
+  // The result columns, and the relation fields they go to
+  std::vector<ColumnAccessor> columns_;
+  std::vector<int> offsets_;
+  std::vector<bool> converted_;
+  bool mismatched_;
+  bool staging_;
+  std::string staging_relation_name_;
+  StorageAdapter *storage_adapter_;
+};
+
+#endif // SRC_PQP_INSERT_SINK_H
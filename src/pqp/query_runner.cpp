@@ -1,15 +1,25 @@
 #include "pqp/query_runner.h"
 
+#include <chrono>
 #include <iomanip>
 
 #include "base/debug.h"
 #include "pqp/query_runner_factory.h"
 
+RunnerStats::RunnerStats()
+  : runs(0),
+    batches(0),
+    tuples(0),
+    wall_time(0) {
+}
+
 QueryRunner::QueryRunner(QueryNode *query_node)
   : query_node_(query_node),
     child_runner_(nullptr),
     fields_printed_(0),
-    storage_adapter_(StorageAdapter::Get()) {
+    storage_adapter_(StorageAdapter::Get()),
+    io_tag_(0) {
+  io_tag_ = storage_adapter_->RegisterIoOperator(query_node_->Label());
 }
 
 QueryRunner::~QueryRunner() {
@@ -20,10 +30,11 @@ QueryRunner::~QueryRunner() {
 }
 
 bool QueryRunner::Start(SqlErrors::Type& error_code) {
-  if (!Initialize(error_code) || !Run(std::bind(&QueryRunner::Print, this,
-                                                std::placeholders::_1,
-                                                std::placeholders::_2),
-                                                error_code)) {
+  if (!Initialize(error_code) || !Execute(std::bind(&QueryRunner::Print,
+                                                    this,
+                                                    std::placeholders::_1,
+                                                    std::placeholders::_2),
+                                                    error_code)) {
     DEBUG_MSG("");
     return false;
   }
@@ -33,15 +44,25 @@ bool QueryRunner::Start(SqlErrors::Type& error_code) {
   return false;
 }
 
-bool QueryRunner::Print(QueryRunner *child, std::vector<Tuple>& tuples) {
-  if (tuples.empty()) {
+bool QueryRunner::StartInto(QueryResultCallback sink,
+    SqlErrors::Type& error_code) {
+  if (!Initialize(error_code) || !Execute(sink, error_code)) {
+    DEBUG_MSG("");
+    return false;
+  }
+
+  return true;
+}
+
+bool QueryRunner::Print(QueryRunner *child, TupleBatch& tuples) {
+  if (tuples.Empty()) {
     return true;
   }
 
   if (fields_printed_ == 0) {
-    Tuple tuple = tuples[0];
+    const Tuple& tuple = tuples[0];
     int field_count = tuple.getNumOfFields();
-    Schema schema = tuple.getSchema();
+    const Schema& schema = tuple.getSchemaRef();
 
     ERROR_MSG_SINGLE_LINE("\n");
     ERROR_MSG_SINGLE_LINE(
@@ -61,16 +82,17 @@ bool QueryRunner::Print(QueryRunner *child, std::vector<Tuple>& tuples) {
     fields_printed_ = field_count;
   }
 
-  for (auto tuple : tuples) {
+  for (const Tuple& tuple : tuples) {
+    const Schema& schema = tuple.getSchemaRef();
     for (int index = 0; index < tuple.getNumOfFields(); index++) {
       std::string field_value;
-      if (tuple.getSchema().getFieldType(index) == INT) {
+      if (schema.getFieldType(index) == INT) {
         int value = tuple.getField(index).integer;
         field_value = std::to_string(value);
         if (value == -1) {
           field_value = "NULL";
         }
-      } else if (tuple.getSchema().getFieldType(index) == STR20) {
+      } else if (schema.getFieldType(index) == STR20) {
         field_value = *(tuple.getField(index).str);
       }
 
@@ -83,6 +105,37 @@ bool QueryRunner::Print(QueryRunner *child, std::vector<Tuple>& tuples) {
   return true;
 }
 
+bool QueryRunner::Execute(QueryResultCallback callback,
+    SqlErrors::Type& error_code) {
+  typedef std::chrono::steady_clock Clock;
+  typedef std::chrono::duration<double, std::milli> Milliseconds;
+
+  int caller_tag = Disk::getAccessTag();
+  DiskAccessScope scope(io_tag_);
+  stats_.runs++;
+
+  // The time of the callback is the caller's
+  Clock::time_point start = Clock::now();
+  double callback_time = 0;
+  bool result = Run([this, callback, caller_tag, &callback_time](
+      QueryRunner *child, TupleBatch& tuples) {
+    if (!tuples.Empty()) {
+      stats_.batches++;
+      stats_.tuples += tuples.Size();
+    }
+
+    Clock::time_point callback_start = Clock::now();
+    DiskAccessScope caller_scope(caller_tag);
+    bool result = callback(child, tuples);
+    callback_time += Milliseconds(Clock::now() - callback_start).count();
+    return result;
+  }, error_code);
+
+  stats_.wall_time += Milliseconds(Clock::now() - start).count() -
+      callback_time;
+  return result;
+}
+
 void QueryRunner::PassScanParams(ScanParams params) {
   if (child_runner_) {
     child_runner_->PassScanParams(params);
@@ -133,7 +186,12 @@ void QueryRunner::SetCallback(QueryResultCallback callback) {
 
 QueryRunner *QueryRunner::Create(QueryNode *child_node) {
   QueryRunnerFactory factory(child_node);
-  return factory.Create();
+  QueryRunner *child_runner = factory.Create();
+  if (child_runner != nullptr) {
+    child_runners_.push_back(child_runner);
+  }
+
+  return child_runner;
 }
 
 void QueryRunner::MarkTemporaryRelation(std::string relation_name) {
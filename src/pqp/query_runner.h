@@ -5,13 +5,15 @@
 
 #include "base/sql_errors.h"
 #include "lqp/query_node.h"
+#include "pqp/tuple_batch.h"
 #include "storage/storage_adapter.h"
 #include "storage/storage_manager_headers.h"
 
 class QueryRunner;
 
+// The batch is only valid during the call; see TupleBatch
 typedef std::function<bool(QueryRunner *,
-    std::vector<Tuple>&)> QueryResultCallback;
+    TupleBatch&)> QueryResultCallback;
 
 typedef struct ScanParams {
   ScanParams()
@@ -25,14 +27,41 @@ typedef struct ScanParams {
   int num_blocks_;
 } ScanParams;
 
+// What an operator did while the plan ran, for EXPLAIN ANALYZE
+struct RunnerStats {
+  RunnerStats();
+
+  // Calls of Execute(); the inner input of a product is run once per pass
+  unsigned long runs;
+  unsigned long batches;
+  unsigned long tuples;
+  // Milliseconds spent in the operator and the ones below it, without the
+  // time its parent spent on its batches
+  double wall_time;
+};
+
 class QueryRunner {
  public:
   QueryRunner(QueryNode *query_node);
   virtual ~QueryRunner();
 
   bool Start(SqlErrors::Type& error_code);
-  bool Print(QueryRunner *child, std::vector<Tuple>& tuples);
+  // Runs the plan like Start(), handing the results to sink instead of
+  // printing them
+  bool StartInto(QueryResultCallback sink, SqlErrors::Type& error_code);
+  bool Print(QueryRunner *child, TupleBatch& tuples);
+  // Runs the operator with its disk accesses accounted to it; the callback
+  // is accounted to the caller
+  bool Execute(QueryResultCallback callback, SqlErrors::Type& error_code);
+  QueryNode *Node() const { return query_node_; }
   QueryNode::QueryNodeType NodeType() const { return Node()->Type(); }
+  // The operators this one created and ran, in creation order
+  const std::vector<QueryRunner *>& ChildRunners() const {
+    return child_runners_;
+  }
+  const RunnerStats& Stats() const { return stats_; }
+  std::string Label() const { return Node()->Label(); }
+  int IoTag() const { return io_tag_; }
 
   virtual bool Initialize(SqlErrors::Type& error_code) = 0;
   virtual bool Run(QueryResultCallback callback,
@@ -44,12 +73,11 @@ class QueryRunner {
   virtual bool TableSize(int& blocks, int& tuples);
   virtual bool HasSortNode() const;
   virtual bool ResultCallback(QueryRunner *child,
-      std::vector<Tuple>& tuples) = 0;
+      TupleBatch& tuples) = 0;
 
   virtual void DeleteTemporaryRelations();
 
  protected:
-  QueryNode *Node() const { return query_node_; }
   StorageAdapter *Storage() const { return storage_adapter_; }
   QueryRunner *ChildRunner() const { return child_runner_; }
   QueryResultCallback Callback() const { return callback_; }
@@ -75,6 +103,10 @@ class QueryRunner {
 
   int fields_printed_;
   StorageAdapter *storage_adapter_;
+  // Tags the disk accesses of the operator in the I/O report
+  int io_tag_;
+  std::vector<QueryRunner *> child_runners_;
+  RunnerStats stats_;
 };
 
 #endif // SRC_PQP_QUERY_RUNNER_H
@@ -0,0 +1,349 @@
+#include "pqp/query_runner_band_join.h"
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include "base/debug.h"
+#include "base/tokenizer.h"
+#include "pqp/where_clause_helper_select.h"
+
+QueryRunnerBandJoin::QueryRunnerBandJoin(QueryNode *query_node)
+  : QueryRunner(query_node),
+    right_child_(nullptr),
+    where_helper_(nullptr),
+    error_code_(SqlErrors::NO_ERROR),
+    has_lower_bound_(false),
+    has_upper_bound_(false),
+    lower_bound_(0),
+    upper_bound_(0),
+    window_begin_(0),
+    window_end_(0),
+    intermediate_relation_(nullptr) {
+}
+
+QueryRunnerBandJoin::~QueryRunnerBandJoin() {
+  if (right_child_ != nullptr) {
+    delete right_child_;
+    right_child_ = nullptr;
+  }
+}
+
+bool QueryRunnerBandJoin::Initialize(SqlErrors::Type& error_code) {
+  if (Node() == nullptr || Node()->ChildrenCount() != 2) {
+    DEBUG_MSG("");
+    error_code = SqlErrors::ERROR_NATURAL_JOIN;
+    return false;
+  }
+
+  if (!Node()->WhereHelper(where_helper_) || where_helper_ == nullptr) {
+    DEBUG_MSG("");
+    return false;
+  }
+
+  RangeJoinAttributes range_join;
+  if (!Node()->RangeJoin(range_join) || range_join.empty()) {
+    DEBUG_MSG("");
+    error_code = SqlErrors::ERROR_NATURAL_JOIN;
+    return false;
+  }
+
+  // The comparisons narrow the band to the tightest bound on either side
+  for (auto& comparison : range_join) {
+    if (comparison.less_) {
+      upper_bound_ = has_upper_bound_ ?
+          std::min(upper_bound_, comparison.offset_) : comparison.offset_;
+      has_upper_bound_ = true;
+    } else {
+      lower_bound_ = has_lower_bound_ ?
+          std::max(lower_bound_, comparison.offset_) : comparison.offset_;
+      has_lower_bound_ = true;
+    }
+  }
+
+  std::string table_name;
+  Tokenizer::SplitIntoTwo(range_join[0].first_, '.', table_name,
+      left_attribute_name_);
+  Tokenizer::SplitIntoTwo(range_join[0].second_, '.', table_name,
+      right_attribute_name_);
+
+  SetChildRunner(Create(Node()->Child(0)));
+  right_child_ = Create(Node()->Child(1));
+
+  if (!ChildRunner()->Initialize(error_code) ||
+      !right_child_->Initialize(error_code)) {
+    DEBUG_MSG("Failed to initialize");
+    return false;
+  }
+
+  return true;
+}
+
+bool QueryRunnerBandJoin::Run(QueryResultCallback callback,
+    SqlErrors::Type& error_code) {
+  SetCallback(callback);
+
+  // The inputs run one after the other, so each is sorted in all of memory
+  ScanParams params;
+  params.start_index_ = 0;
+  params.num_blocks_ = Storage()->MainMemorySize();
+  ChildRunner()->PassScanParams(params);
+  right_child_->PassScanParams(params);
+
+  ChildRunner()->TableName(left_table_name_);
+  right_child_->TableName(right_table_name_);
+
+  bool joined = ChildRunner()->Execute(
+      std::bind(&QueryRunnerBandJoin::ResultCallback, this,
+          std::placeholders::_1, std::placeholders::_2),
+      error_code);
+
+  window_begin_ = 0;
+  window_end_ = 0;
+  if (joined && !left_tuples_.empty()) {
+    joined = right_child_->Execute(
+        std::bind(&QueryRunnerBandJoin::ResultCallback, this,
+            std::placeholders::_1, std::placeholders::_2),
+        error_code);
+  }
+
+  joined = joined && passOutput(true);
+
+  if (!joined) {
+    DEBUG_MSG("");
+    if (error_code_ == SqlErrors::NO_ERROR) {
+      error_code_ = SqlErrors::ERROR_NATURAL_JOIN;
+    }
+
+    error_code = error_code_;
+    return false;
+  }
+
+  return true;
+}
+
+bool QueryRunnerBandJoin::ResultCallback(QueryRunner *child,
+    TupleBatch& tuples) {
+  if (child != ChildRunner() && child != right_child_) {
+    DEBUG_MSG("Invalid child for band join");
+    return false;
+  }
+
+  if (tuples.Empty()) {
+    return true;
+  }
+
+  if (child == right_child_) {
+    return joinRightTuples(tuples);
+  }
+
+  // The left input is kept for the sweep, in its order
+  for (const Tuple& tuple : tuples) {
+    long long value = 0;
+    if (bandValue(tuple, true, value)) {
+      left_tuples_.push_back(tuple);
+      left_values_.push_back(value);
+    } else if (error_code_ != SqlErrors::NO_ERROR) {
+      DEBUG_MSG("");
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void QueryRunnerBandJoin::PassScanParams(ScanParams params) {
+}
+
+bool QueryRunnerBandJoin::TableName(std::string& table_name) {
+  return false;
+}
+
+bool QueryRunnerBandJoin::TableSize(int& blocks, int& tuples) {
+  return false;
+}
+
+bool QueryRunnerBandJoin::HasSortNode() const {
+  return false;
+}
+
+void QueryRunnerBandJoin::DeleteTemporaryRelations() {
+  if (right_child_ != nullptr) {
+    right_child_->DeleteTemporaryRelations();
+  }
+
+  QueryRunner::DeleteTemporaryRelations();
+}
+
+// Private methods
+bool QueryRunnerBandJoin::joinRightTuples(TupleBatch& tuples) {
+  for (const Tuple& right_tuple : tuples) {
+    long long value = 0;
+    if (!bandValue(right_tuple, false, value)) {
+      if (error_code_ != SqlErrors::NO_ERROR) {
+        DEBUG_MSG("");
+        return false;
+      }
+
+      continue;
+    }
+
+    // The right values grow, and so do both ends of the window of left
+    // values in value + lower bound < left < value + upper bound
+    if (has_lower_bound_) {
+      while (window_begin_ < left_values_.size() &&
+          left_values_[window_begin_] <= value + lower_bound_) {
+        window_begin_++;
+      }
+    }
+
+    if (has_upper_bound_) {
+      while (window_end_ < left_values_.size() &&
+          left_values_[window_end_] < value + upper_bound_) {
+        window_end_++;
+      }
+    } else {
+      window_end_ = left_values_.size();
+    }
+
+    for (size_t index = window_begin_; index < window_end_; index++) {
+      const Tuple& left_tuple = left_tuples_[index];
+      if (intermediate_relation_name_.empty() &&
+          !createIntermediateRelation(left_tuple, right_tuple,
+              left_table_name_, right_table_name_)) {
+        DEBUG_MSG("");
+        error_code_ = SqlErrors::ERROR_NATURAL_JOIN;
+        return false;
+      }
+
+      // The band is the whole condition, which is still checked as written
+      if (!where_helper_->EvaluatePair(left_tuple, left_table_name_,
+          right_tuple, right_table_name_, error_code_)) {
+        if (error_code_ != SqlErrors::NO_ERROR) {
+          DEBUG_MSG("");
+          return false;
+        }
+
+        continue;
+      }
+
+      Tuple merged_tuple = Tuple::getDummyTuple();
+      if (!mergeTuples(left_tuple, right_tuple, merged_tuple)) {
+        DEBUG_MSG("");
+        error_code_ = SqlErrors::ERROR_NATURAL_JOIN;
+        return false;
+      }
+
+      output_tuples_.push_back(merged_tuple);
+    }
+  }
+
+  return passOutput(false);
+}
+
+bool QueryRunnerBandJoin::bandValue(const Tuple& tuple, const bool left,
+    long long& value) {
+  ColumnAccessor& column = left ? left_column_ : right_column_;
+  const std::string& attribute_name =
+      left ? left_attribute_name_ : right_attribute_name_;
+  const Schema& schema = tuple.getSchemaRef();
+  if (!column.IsBoundTo(schema) && !column.Bind(schema, attribute_name)) {
+    DEBUG_MSG("Unable to bind band column " << attribute_name);
+    error_code_ = SqlErrors::INVALID_COLUMN_NAME;
+    return false;
+  }
+
+  // -1 is how an INT column holds NULL
+  value = column.Integer(tuple);
+  return value != -1;
+}
+
+bool QueryRunnerBandJoin::passOutput(const bool last) {
+  if (output_tuples_.empty() || (!last && output_tuples_.size() <
+      Storage()->MainMemorySize() *
+      intermediate_relation_->getSchemaRef().getTuplesPerBlock())) {
+    return true;
+  }
+
+  TupleBatch output_batch(output_tuples_);
+  bool passed = Callback()(this, output_batch);
+  output_tuples_.clear();
+  return passed;
+}
+
+bool QueryRunnerBandJoin::createIntermediateRelation(
+    const Tuple& first, const Tuple& second,
+    std::string table_name_first, std::string table_name_second) {
+  const Schema& schema_first = first.getSchemaRef();
+  const Schema& schema_second = second.getSchemaRef();
+  std::vector<std::string> field_names = schema_first.getFieldNames();
+  std::vector<enum FIELD_TYPE> field_types = schema_first.getFieldTypes();
+
+  for (auto &field_name : field_names) {
+    if (!table_name_first.empty())
+      field_name = table_name_first + "." + field_name;
+  }
+
+  std::vector<std::string> field_names_second = schema_second.getFieldNames();
+  std::vector<enum FIELD_TYPE> field_types_second =
+      schema_second.getFieldTypes();
+
+  for (auto &field_name : field_names_second) {
+    if (!table_name_second.empty())
+      field_name = table_name_second + "." + field_name;
+  }
+
+  field_names.insert(field_names.end(),
+      field_names_second.begin(), field_names_second.end());
+  field_types.insert(field_types.end(),
+      field_types_second.begin(), field_types_second.end());
+
+  if (!Storage()->CreateDummyRelation("BandJoin_", field_names, field_types,
+      intermediate_relation_name_)) {
+    DEBUG_MSG("");
+    return false;
+  }
+
+  MarkTemporaryRelation(intermediate_relation_name_);
+  intermediate_relation_ = Storage()->GetRelation(intermediate_relation_name_);
+
+  return true;
+}
+
+bool QueryRunnerBandJoin::mergeTuples(const Tuple& first, const Tuple& second,
+    Tuple& merged_tuple) {
+  if (intermediate_relation_ == nullptr) {
+    DEBUG_MSG("");
+    return false;
+  }
+
+  merged_tuple = intermediate_relation_->createTuple();
+
+  const Schema& schema_first = first.getSchemaRef();
+  for (auto it = 0; it < first.getNumOfFields(); it++) {
+    if (schema_first.getFieldType(it) == INT) {
+      merged_tuple.setField(it, first.getField(it).integer);
+    } else if (schema_first.getFieldType(it) == STR20) {
+      merged_tuple.setField(it, *(first.getField(it).str));
+    } else {
+      DEBUG_MSG("");
+      return false;
+    }
+  }
+
+  const Schema& schema_second = second.getSchemaRef();
+  for (auto it = 0; it < second.getNumOfFields(); it++) {
+    if (schema_second.getFieldType(it) == INT) {
+      merged_tuple.setField(
+          first.getNumOfFields() + it, second.getField(it).integer);
+    } else if (schema_second.getFieldType(it) == STR20) {
+      merged_tuple.setField(
+          first.getNumOfFields() + it, *(second.getField(it).str));
+    } else {
+      DEBUG_MSG("");
+      return false;
+    }
+  }
+
+  return true;
+}
@@ -0,0 +1,71 @@
+#ifndef SRC_PQP_QUERY_RUNNER_BAND_JOIN_H
+#define SRC_PQP_QUERY_RUNNER_BAND_JOIN_H
+
+#include <string>
+#include <vector>
+
+#include "base/sql_errors.h"
+#include "pqp/column_accessor.h"
+#include "pqp/query_runner.h"
+
+// Joins two inputs on comparisons of a column of each, which bound their
+// difference from below, above or both. Both inputs come sorted on their
+// column, and the left one is kept. For every right tuple, in order, the
+// left tuples whose values fall in the band around its value form a window
+// whose ends only move forward, so every input tuple is passed once and
+// only the pairs in the window are checked and merged. Tuples with a NULL
+// column are in no band.
+class QueryRunnerBandJoin : public QueryRunner {
+ public:
+  QueryRunnerBandJoin(QueryNode *query_node);
+  ~QueryRunnerBandJoin();
+
+  bool Initialize(SqlErrors::Type& error_code) final;
+  bool Run(QueryResultCallback callback, SqlErrors::Type& error_code) final;
+  bool ResultCallback(QueryRunner *child, TupleBatch& tuples) final;
+
+  void PassScanParams(ScanParams params) final;
+  bool TableName(std::string& table_name) final;
+  bool TableSize(int& blocks, int& tuples) final;
+  bool HasSortNode() const final;
+
+  void DeleteTemporaryRelations() final;
+
+ private:
+  bool joinRightTuples(TupleBatch& tuples);
+  bool bandValue(const Tuple& tuple, const bool left, long long& value);
+  bool passOutput(const bool last);
+
+  bool createIntermediateRelation(const Tuple& first, const Tuple& second,
+      std::string table_name_first, std::string table_name_second);
+  bool mergeTuples(const Tuple& first, const Tuple& second,
+      Tuple& merged_tuple);
+
+  QueryRunner *right_child_;
+  WhereClauseHelperSelect *where_helper_;
+  SqlErrors::Type error_code_;
+  std::string left_table_name_;
+  std::string right_table_name_;
+
+  // The left value minus the right one lies strictly between the bounds
+  std::string left_attribute_name_;
+  std::string right_attribute_name_;
+  bool has_lower_bound_;
+  bool has_upper_bound_;
+  long long lower_bound_;
+  long long upper_bound_;
+  ColumnAccessor left_column_;
+  ColumnAccessor right_column_;
+
+  std::vector<Tuple> left_tuples_;
+  std::vector<long long> left_values_;
+  size_t window_begin_;
+  size_t window_end_;
+
+  std::string intermediate_relation_name_;
+  Relation *intermediate_relation_;
+  // Passed on a memory load at a time, so a sort above gets few sublists
+  std::vector<Tuple> output_tuples_;
+};
+
+#endif // SRC_PQP_QUERY_RUNNER_BAND_JOIN_H
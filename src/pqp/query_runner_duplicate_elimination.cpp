@@ -32,7 +32,7 @@ bool QueryRunnerDuplicateElimination::Run(QueryResultCallback callback,
     SqlErrors::Type& error_code) {
   SetCallback(callback);
 
-  if (!ChildRunner()->Run(
+  if (!ChildRunner()->Execute(
       std::bind(&QueryRunnerDuplicateElimination::ResultCallback, this,
           std::placeholders::_1, std::placeholders::_2),
       error_code)) {
@@ -49,25 +49,18 @@ bool QueryRunnerDuplicateElimination::Run(QueryResultCallback callback,
 }
 
 bool QueryRunnerDuplicateElimination::ResultCallback(QueryRunner *child,
-    std::vector<Tuple>& tuples) {
-  if (tuples.empty()) {
+    TupleBatch& tuples) {
+  if (tuples.Empty()) {
     return true;
   }
 
-  std::vector<Tuple> output_tuples;
-  for (auto tuple : tuples) {
-    if (!previous_tuple_.isNull()) {
-      if (!(tuple == previous_tuple_)) {
-        output_tuples.push_back(tuple);
-      }
-    } else {
-      output_tuples.push_back(tuple);
-    }
-
+  tuples.Filter([&](const Tuple& tuple) {
+    bool keep = previous_tuple_.isNull() || !(tuple == previous_tuple_);
     previous_tuple_ = tuple;
-  }
+    return keep;
+  });
 
-  if (!output_tuples.empty() && !Callback()(this, output_tuples)) {
+  if (!tuples.Empty() && !Callback()(this, tuples)) {
     DEBUG_MSG("");
     return false;
   }
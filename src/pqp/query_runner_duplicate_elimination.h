@@ -11,7 +11,7 @@ class QueryRunnerDuplicateElimination : public QueryRunner {
 
   bool Initialize(SqlErrors::Type& error_code) final;
   bool Run(QueryResultCallback callback, SqlErrors::Type& error_code) final;
-  bool ResultCallback(QueryRunner *child, std::vector<Tuple>& tuples) final;
+  bool ResultCallback(QueryRunner *child, TupleBatch& tuples) final;
 
 private:
   Tuple previous_tuple_;
@@ -1,6 +1,8 @@
 #include "pqp/query_runner_factory.h"
 
+#include "pqp/query_runner_band_join.h"
 #include "pqp/query_runner_duplicate_elimination.h"
+#include "pqp/query_runner_hash_join.h"
 #include "pqp/query_runner_natural_join.h"
 #include "pqp/query_runner_product.h"
 #include "pqp/query_runner_projection.h"
@@ -30,9 +32,14 @@ QueryRunner *QueryRunnerFactory::Create() const {
     case QueryNode::QUERY_NODE_TYPE_SELECTION:
       return new QueryRunnerSelection(query_node_);
     case QueryNode::QUERY_NODE_TYPE_CROSS_PRODUCT:
+    case QueryNode::QUERY_NODE_TYPE_THETA_JOIN:
       return new QueryRunnerProduct(query_node_);
     case QueryNode::QUERY_NODE_TYPE_NATURAL_JOIN:
       return new QueryRunnerNaturalJoin(query_node_);
+    case QueryNode::QUERY_NODE_TYPE_HASH_JOIN:
+      return new QueryRunnerHashJoin(query_node_);
+    case QueryNode::QUERY_NODE_TYPE_BAND_JOIN:
+      return new QueryRunnerBandJoin(query_node_);
     default:
       return nullptr;
   }
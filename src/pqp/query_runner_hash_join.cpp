@@ -0,0 +1,626 @@
+#include "pqp/query_runner_hash_join.h"
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include "base/debug.h"
+#include "base/tokenizer.h"
+
+// Partitioning again past this depth would not split the keys left, which
+// all hash alike
+const int hash_join_max_depth = 3;
+
+// The fewest blocks a join below is run in next to the table; with fewer
+// left, its result is written to a temporary relation before the table is
+// built
+const int hash_join_min_input_blocks = 3;
+
+// A column is named by its attribute in the tuples of its own table, and
+// with the table in those of a join
+std::string inline InputColumnName(const std::string& column_name,
+    const std::string& table_name) {
+  std::string column_table_name, attribute_name;
+  Tokenizer::SplitIntoTwo(column_name, '.', column_table_name,
+      attribute_name);
+  return !attribute_name.empty() && column_table_name == table_name ?
+      attribute_name : column_name;
+}
+
+QueryRunnerHashJoin::QueryRunnerHashJoin(QueryNode *query_node)
+  : QueryRunner(query_node),
+    right_child_(nullptr),
+    error_code_(SqlErrors::NO_ERROR),
+    memory_start_(0),
+    memory_blocks_(0),
+    build_left_(true),
+    phase_(PHASE_BUILD),
+    partitions_(nullptr),
+    partition_block_(0),
+    partition_build_(true),
+    partition_depth_(0),
+    intermediate_relation_(nullptr) {
+}
+
+QueryRunnerHashJoin::~QueryRunnerHashJoin() {
+  if (right_child_ != nullptr) {
+    delete right_child_;
+    right_child_ = nullptr;
+  }
+}
+
+bool QueryRunnerHashJoin::Initialize(SqlErrors::Type& error_code) {
+  if (Node() == nullptr || Node()->ChildrenCount() != 2) {
+    DEBUG_MSG("");
+    error_code = SqlErrors::ERROR_NATURAL_JOIN;
+    return false;
+  }
+
+  if (!Node()->JoinColumns(join_columns_) || join_columns_.empty()) {
+    DEBUG_MSG("");
+    error_code = SqlErrors::ERROR_NATURAL_JOIN;
+    return false;
+  }
+
+  SetChildRunner(Create(Node()->Child(0)));
+  right_child_ = Create(Node()->Child(1));
+
+  if (!ChildRunner()->Initialize(error_code) ||
+      !right_child_->Initialize(error_code)) {
+    DEBUG_MSG("Failed to initialize");
+    return false;
+  }
+
+  return true;
+}
+
+bool QueryRunnerHashJoin::Run(QueryResultCallback callback,
+    SqlErrors::Type& error_code) {
+  SetCallback(callback);
+
+  memory_start_ = scan_params_.start_index_;
+  memory_blocks_ = scan_params_.num_blocks_ > 0 ? scan_params_.num_blocks_ :
+      Storage()->MainMemorySize() - memory_start_;
+  if (memory_blocks_ < 2) {
+    ERROR_MSG("Out of memory");
+    error_code = SqlErrors::ERROR_NATURAL_JOIN;
+    return false;
+  }
+
+  std::string left_table_name, right_table_name;
+  ChildRunner()->TableName(left_table_name);
+  right_child_->TableName(right_table_name);
+  left_columns_.clear();
+  right_columns_.clear();
+  for (auto& join_column : join_columns_) {
+    left_columns_.push_back(InputColumnName(join_column.first,
+        left_table_name));
+    right_columns_.push_back(InputColumnName(join_column.second,
+        right_table_name));
+  }
+
+  int left_blocks = 0, right_blocks = 0, tuples = 0;
+  bool left_known = ChildRunner()->TableSize(left_blocks, tuples);
+  bool right_known = right_child_->TableSize(right_blocks, tuples);
+  build_left_ = left_known && (!right_known || left_blocks <= right_blocks);
+
+  QueryRunner *build_input = build_left_ ? ChildRunner() : right_child_;
+  QueryRunner *probe_input = build_left_ ? right_child_ : ChildRunner();
+  bool build_known = build_left_ ? left_known : right_known;
+  bool probe_known = build_left_ ? right_known : left_known;
+  int build_blocks = build_left_ ? left_blocks : right_blocks;
+
+  int memory = memory_blocks_;
+  bool joined = true;
+  if (build_known && build_blocks < memory) {
+    // The table holds the blocks it is read into, and a join below runs in
+    // the rest of the memory
+    int input_blocks = memory - std::max(build_blocks, 1);
+    std::vector<Relation *> probe_inputs;
+    if (!probe_known && input_blocks < hash_join_min_input_blocks) {
+      joined = partitionInput(probe_input, nullptr, false, 0, 1,
+          probe_inputs);
+    }
+
+    ScanParams params;
+    params.start_index_ = memory_start_;
+    params.num_blocks_ = std::max(build_blocks, 1);
+    build_input->PassScanParams(params);
+
+    phase_ = PHASE_BUILD;
+    joined = joined && build_input->Execute(
+        std::bind(&QueryRunnerHashJoin::ResultCallback, this,
+            std::placeholders::_1, std::placeholders::_2),
+        error_code);
+
+    phase_ = PHASE_PROBE;
+    if (!probe_inputs.empty()) {
+      joined = joined && probeRelation(probe_inputs[0]);
+    } else {
+      params.start_index_ = probe_known ? memory_start_ + memory - 1 :
+          memory_start_ + memory - input_blocks;
+      params.num_blocks_ = probe_known ? 1 : input_blocks;
+      probe_input->PassScanParams(params);
+      joined = joined && probe_input->Execute(
+          std::bind(&QueryRunnerHashJoin::ResultCallback, this,
+              std::placeholders::_1, std::placeholders::_2),
+          error_code);
+    }
+
+    clearTable();
+    joined = deleteRelations(probe_inputs) && joined;
+  } else {
+    std::vector<Relation *> build_inputs, probe_inputs;
+    joined = (build_known || partitionInput(build_input, nullptr, true, 0, 1,
+        build_inputs)) && (probe_known || partitionInput(probe_input, nullptr,
+        false, 0, 1, probe_inputs));
+
+    std::vector<Relation *> build_partitions, probe_partitions;
+    joined = joined && partitionInput(build_known ? build_input : nullptr,
+        build_known ? nullptr : build_inputs[0], true, 0, memory - 1,
+        build_partitions) && partitionInput(probe_known ? probe_input : nullptr,
+        probe_known ? nullptr : probe_inputs[0], false, 0, memory - 1,
+        probe_partitions);
+    for (int index = 0; joined && index < build_partitions.size(); index++) {
+      joined = joinPartitions(build_partitions[index], probe_partitions[index],
+          1);
+    }
+
+    joined = deleteRelations(build_partitions) &&
+        deleteRelations(probe_partitions) && deleteRelations(build_inputs) &&
+        deleteRelations(probe_inputs) && joined;
+  }
+
+  joined = joined && passOutput(true);
+
+  if (!joined) {
+    DEBUG_MSG("");
+    if (error_code_ == SqlErrors::NO_ERROR) {
+      error_code_ = SqlErrors::ERROR_NATURAL_JOIN;
+    }
+
+    error_code = error_code_;
+    return false;
+  }
+
+  return true;
+}
+
+bool QueryRunnerHashJoin::ResultCallback(QueryRunner *child,
+    TupleBatch& tuples) {
+  if (child != ChildRunner() && child != right_child_) {
+    DEBUG_MSG("Invalid child for hash join");
+    return false;
+  }
+
+  if (tuples.Empty()) {
+    return true;
+  }
+
+  switch (phase_) {
+    case PHASE_BUILD:
+      return buildTable(tuples);
+    case PHASE_PROBE:
+      return probeTable(tuples);
+    case PHASE_PARTITION:
+      return partitionTuples(tuples);
+    default:
+      return false;
+  }
+}
+
+void QueryRunnerHashJoin::PassScanParams(ScanParams params) {
+  scan_params_ = params;
+}
+
+bool QueryRunnerHashJoin::TableName(std::string& table_name) {
+  return false;
+}
+
+bool QueryRunnerHashJoin::TableSize(int& blocks, int& tuples) {
+  return false;
+}
+
+bool QueryRunnerHashJoin::HasSortNode() const {
+  return false;
+}
+
+void QueryRunnerHashJoin::DeleteTemporaryRelations() {
+  if (right_child_ != nullptr) {
+    right_child_->DeleteTemporaryRelations();
+  }
+
+  for (auto& relation_name : partition_relation_names_) {
+    Storage()->DeleteDummyRelation(relation_name);
+  }
+
+  partition_relation_names_.clear();
+  QueryRunner::DeleteTemporaryRelations();
+}
+
+// Private methods
+bool QueryRunnerHashJoin::partitionInput(QueryRunner *input,
+    Relation *relation, const bool build, const int depth,
+    const int partition_count, std::vector<Relation *>& partitions) {
+  // The input is read into the first blocks and every partition is appended
+  // to through one of the last ones; a single partition writes the input
+  // to a temporary relation as it is
+  int memory = memory_blocks_;
+  partitions.assign(std::max(std::min(partition_count, memory - 1), 1),
+      nullptr);
+  partition_block_ = memory_start_ + memory - partitions.size();
+  for (int index = partition_block_; index < memory_start_ + memory;
+      index++) {
+    Storage()->ClearBlock(index);
+  }
+
+  partitions_ = &partitions;
+  partition_build_ = build;
+  partition_depth_ = depth;
+  phase_ = PHASE_PARTITION;
+  if (input != nullptr) {
+    ScanParams params;
+    params.start_index_ = memory_start_;
+    params.num_blocks_ = partition_block_ - memory_start_;
+    input->PassScanParams(params);
+    if (!input->Execute(
+        std::bind(&QueryRunnerHashJoin::ResultCallback, this,
+            std::placeholders::_1, std::placeholders::_2),
+        error_code_)) {
+      DEBUG_MSG("");
+      return false;
+    }
+  } else if (relation != nullptr) {
+    int block_count = Storage()->RelationBlockSize(relation);
+    for (int index = 0; index < block_count; index++) {
+      std::vector<Block *> blocks;
+      if (!Storage()->ReadRelationBlocks(relation, index, memory_start_, 1,
+          blocks)) {
+        DEBUG_MSG("");
+        return false;
+      }
+
+      TupleBatch tuples(blocks);
+      bool partitioned = partitionTuples(tuples);
+      blocks[0]->clear();
+      if (!partitioned) {
+        DEBUG_MSG("");
+        return false;
+      }
+    }
+  }
+
+  for (int index = 0; index < partitions.size(); index++) {
+    if (partitions[index] != nullptr &&
+        !Storage()->PushLastBlock(partitions[index],
+            partition_block_ + index)) {
+      DEBUG_MSG("");
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool QueryRunnerHashJoin::partitionTuples(TupleBatch& tuples) {
+  std::vector<Relation *>& partitions = *partitions_;
+  std::hash<std::string> hash;
+  for (const Tuple& tuple : tuples) {
+    // Every depth hashes the keys differently, so a partition too large is
+    // split by the next one
+    int index = 0;
+    if (partitions.size() > 1) {
+      std::string tuple_key;
+      if (!key(tuple, partition_build_, tuple_key)) {
+        DEBUG_MSG("");
+        error_code_ = SqlErrors::ERROR_NATURAL_JOIN;
+        return false;
+      }
+
+      index = hash(std::to_string(partition_depth_) + ":" + tuple_key) %
+          partitions.size();
+    }
+
+    if (partitions[index] == nullptr) {
+      const Schema& schema = tuple.getSchemaRef();
+      std::vector<std::string> field_names = schema.getFieldNames();
+      std::vector<enum FIELD_TYPE> field_types = schema.getFieldTypes();
+      std::string relation_name;
+      if (!Storage()->CreateDummyRelation("HashJoin_", field_names,
+          field_types, relation_name)) {
+        DEBUG_MSG("");
+        return false;
+      }
+
+      partition_relation_names_.push_back(relation_name);
+      partitions[index] = Storage()->GetRelation(relation_name);
+    }
+
+    Tuple partition_tuple = tuple;
+    if (!Storage()->AppendTupleUsing(partitions[index], partition_tuple,
+        partition_block_ + index)) {
+      DEBUG_MSG("");
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool QueryRunnerHashJoin::joinPartitions(Relation *build_relation,
+    Relation *probe_relation, const int depth) {
+  if (build_relation == nullptr || probe_relation == nullptr) {
+    return true;
+  }
+
+  int memory = memory_blocks_;
+  int build_blocks = Storage()->RelationBlockSize(build_relation);
+  if (build_blocks >= memory && depth < hash_join_max_depth) {
+    std::vector<Relation *> build_partitions, probe_partitions;
+    bool joined = partitionInput(nullptr, build_relation, true, depth,
+        memory - 1, build_partitions) &&
+        partitionInput(nullptr, probe_relation, false, depth, memory - 1,
+            probe_partitions);
+    for (int index = 0; joined && index < build_partitions.size(); index++) {
+      joined = joinPartitions(build_partitions[index], probe_partitions[index],
+          depth + 1);
+    }
+
+    return deleteRelations(build_partitions) &&
+        deleteRelations(probe_partitions) && joined;
+  }
+
+  // One memory load of the build partition, unless its keys all hash alike
+  int load_blocks = std::max(memory - 1, 1);
+  for (int start = 0; start < build_blocks; start += load_blocks) {
+    std::vector<Block *> blocks;
+    if (!Storage()->ReadRelationBlocks(build_relation, start, memory_start_,
+        load_blocks, blocks)) {
+      DEBUG_MSG("");
+      return false;
+    }
+
+    TupleBatch build_tuples(blocks);
+    bool built = buildTable(build_tuples);
+    for (auto block : blocks) {
+      block->clear();
+    }
+
+    built = built && probeRelation(probe_relation);
+    clearTable();
+    if (!built) {
+      DEBUG_MSG("");
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool QueryRunnerHashJoin::probeRelation(Relation *probe_relation) {
+  // A block at a time, through the last block of the memory
+  int probe_blocks = Storage()->RelationBlockSize(probe_relation);
+  for (int index = 0; index < probe_blocks; index++) {
+    std::vector<Block *> blocks;
+    if (!Storage()->ReadRelationBlocks(probe_relation, index,
+        memory_start_ + memory_blocks_ - 1, 1, blocks)) {
+      DEBUG_MSG("");
+      return false;
+    }
+
+    TupleBatch probe_tuples(blocks);
+    bool probed = probeTable(probe_tuples);
+    blocks[0]->clear();
+    if (!probed) {
+      DEBUG_MSG("");
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool QueryRunnerHashJoin::deleteRelations(
+    std::vector<Relation *>& relations) {
+  bool deleted = true;
+  for (auto relation : relations) {
+    if (relation == nullptr) {
+      continue;
+    }
+
+    std::string relation_name = relation->getRelationName();
+    partition_relation_names_.erase(std::remove(
+        partition_relation_names_.begin(), partition_relation_names_.end(),
+        relation_name), partition_relation_names_.end());
+    deleted = Storage()->DeleteDummyRelation(relation_name) && deleted;
+  }
+
+  relations.clear();
+  return deleted;
+}
+
+bool QueryRunnerHashJoin::buildTable(TupleBatch& tuples) {
+  for (const Tuple& tuple : tuples) {
+    std::string tuple_key;
+    if (!key(tuple, true, tuple_key)) {
+      DEBUG_MSG("");
+      error_code_ = SqlErrors::ERROR_NATURAL_JOIN;
+      return false;
+    }
+
+    build_index_.emplace(tuple_key, build_tuples_.size());
+    build_tuples_.push_back(tuple);
+  }
+
+  return true;
+}
+
+bool QueryRunnerHashJoin::probeTable(TupleBatch& tuples) {
+  for (const Tuple& probe_tuple : tuples) {
+    std::string probe_key;
+    if (!key(probe_tuple, false, probe_key)) {
+      DEBUG_MSG("");
+      error_code_ = SqlErrors::ERROR_NATURAL_JOIN;
+      return false;
+    }
+
+    auto matches = build_index_.equal_range(probe_key);
+    for (auto match = matches.first; match != matches.second; match++) {
+      const Tuple& build_tuple = build_tuples_[match->second];
+      const Tuple& left_tuple = build_left_ ? build_tuple : probe_tuple;
+      const Tuple& right_tuple = build_left_ ? probe_tuple : build_tuple;
+      if (intermediate_relation_name_.empty()) {
+        std::string table_name_first, table_name_second;
+        ChildRunner()->TableName(table_name_first);
+        right_child_->TableName(table_name_second);
+
+        if (!createIntermediateRelation(left_tuple, right_tuple,
+            table_name_first, table_name_second)) {
+          DEBUG_MSG("");
+          error_code_ = SqlErrors::ERROR_NATURAL_JOIN;
+          return false;
+        }
+      }
+
+      // Equal keys hold equal values, the rest of the condition is checked
+      // above the joins
+      Tuple merged_tuple = Tuple::getDummyTuple();
+      if (!mergeTuples(left_tuple, right_tuple, merged_tuple)) {
+        DEBUG_MSG("");
+        error_code_ = SqlErrors::ERROR_NATURAL_JOIN;
+        return false;
+      }
+
+      output_tuples_.push_back(merged_tuple);
+    }
+  }
+
+  return passOutput(false);
+}
+
+void QueryRunnerHashJoin::clearTable() {
+  build_tuples_.clear();
+  build_index_.clear();
+}
+
+bool QueryRunnerHashJoin::passOutput(const bool last) {
+  if (output_tuples_.empty() || (!last && output_tuples_.size() <
+      Storage()->MainMemorySize() *
+      intermediate_relation_->getSchemaRef().getTuplesPerBlock())) {
+    return true;
+  }
+
+  TupleBatch output_batch(output_tuples_);
+  bool passed = Callback()(this, output_batch);
+  output_tuples_.clear();
+  return passed;
+}
+
+bool QueryRunnerHashJoin::key(const Tuple& tuple, const bool build,
+    std::string& key) const {
+  const std::vector<std::string>& column_names =
+      build == build_left_ ? left_columns_ : right_columns_;
+  std::vector<ColumnAccessor>& columns =
+      build ? build_columns_ : probe_columns_;
+  columns.resize(column_names.size());
+
+  // The values of several columns are each prefixed with their length, so
+  // keys are equal only when all of them are
+  const Schema& schema = tuple.getSchemaRef();
+  key.clear();
+  for (int index = 0; index < column_names.size(); index++) {
+    ColumnAccessor& column = columns[index];
+    if (!column.IsBoundTo(schema) &&
+        !column.Bind(schema, column_names[index])) {
+      ERROR_MSG("Unable to bind join column " << column_names[index]);
+      return false;
+    }
+
+    std::string value = column.Value(tuple);
+    key += column_names.size() == 1 ? value :
+        std::to_string(value.size()) + ":" + value;
+  }
+
+  return true;
+}
+
+bool QueryRunnerHashJoin::createIntermediateRelation(
+    const Tuple& first, const Tuple& second,
+    std::string table_name_first, std::string table_name_second) {
+  const Schema& schema_first = first.getSchemaRef();
+  const Schema& schema_second = second.getSchemaRef();
+  std::vector<std::string> field_names = schema_first.getFieldNames();
+  std::vector<enum FIELD_TYPE> field_types = schema_first.getFieldTypes();
+
+  for (auto &field_name : field_names) {
+    if (!table_name_first.empty())
+      field_name = table_name_first + "." + field_name;
+  }
+
+  std::vector<std::string> field_names_second = schema_second.getFieldNames();
+  std::vector<enum FIELD_TYPE> field_types_second =
+      schema_second.getFieldTypes();
+
+  for (auto &field_name : field_names_second) {
+    if (!table_name_second.empty())
+      field_name = table_name_second + "." + field_name;
+  }
+
+  field_names.insert(field_names.end(),
+      field_names_second.begin(), field_names_second.end());
+  field_types.insert(field_types.end(),
+      field_types_second.begin(), field_types_second.end());
+
+  // A join of a join tree keeps only the columns the plan uses above it
+  std::vector<std::string> output_columns;
+  Node()->OutputColumns(output_columns);
+  std::vector<std::string> output_names;
+  std::vector<enum FIELD_TYPE> output_types;
+  merge_fields_.clear();
+  for (int index = 0; index < field_names.size(); index++) {
+    if (output_columns.empty() || std::find(output_columns.begin(),
+        output_columns.end(), field_names[index]) != output_columns.end()) {
+      merge_fields_.push_back(index);
+      output_names.push_back(field_names[index]);
+      output_types.push_back(field_types[index]);
+    }
+  }
+
+  if (!Storage()->CreateDummyRelation("HashJoin_", output_names, output_types,
+      intermediate_relation_name_)) {
+    DEBUG_MSG("");
+    return false;
+  }
+
+  MarkTemporaryRelation(intermediate_relation_name_);
+  intermediate_relation_ = Storage()->GetRelation(intermediate_relation_name_);
+
+  return true;
+}
+
+bool QueryRunnerHashJoin::mergeTuples(const Tuple& first, const Tuple& second,
+    Tuple& merged_tuple) {
+  if (intermediate_relation_ == nullptr) {
+    DEBUG_MSG("");
+    return false;
+  }
+
+  merged_tuple = intermediate_relation_->createTuple();
+
+  for (auto it = 0; it < merge_fields_.size(); it++) {
+    bool from_first = merge_fields_[it] < first.getNumOfFields();
+    const Tuple& tuple = from_first ? first : second;
+    int field = from_first ? merge_fields_[it] :
+        merge_fields_[it] - first.getNumOfFields();
+    if (tuple.getSchemaRef().getFieldType(field) == INT) {
+      merged_tuple.setField(it, tuple.getField(field).integer);
+    } else if (tuple.getSchemaRef().getFieldType(field) == STR20) {
+      merged_tuple.setField(it, *(tuple.getField(field).str));
+    } else {
+      DEBUG_MSG("");
+      return false;
+    }
+  }
+
+  return true;
+}
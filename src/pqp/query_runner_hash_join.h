@@ -0,0 +1,105 @@
+#ifndef SRC_PQP_QUERY_RUNNER_HASH_JOIN_H
+#define SRC_PQP_QUERY_RUNNER_HASH_JOIN_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "base/sql_errors.h"
+#include "pqp/column_accessor.h"
+#include "pqp/query_runner.h"
+
+// Joins two inputs on equal columns, one or several pairs of them, with a
+// hash table built on the input with fewer blocks. When that input fits in
+// main memory next to one block of the other, it is read into the table and
+// the other input is streamed past it a block at a time. Otherwise both
+// inputs are partitioned on the hash of the columns into temporary
+// relations, one per main memory block but the input one, and every pair of
+// partitions is joined the same way; a build partition still too large is
+// partitioned again with another hash, and joined a memory load at a time
+// once the hashes run out. Partitioning costs a read and a write of both
+// inputs, and joining the partitions one more read. An input of unknown
+// size, the result of another join, runs next to the table in the blocks it
+// leaves, or when they are too few, and before partitioning, is first
+// written to a temporary relation, so that it runs in all of the join's
+// memory but one block.
+class QueryRunnerHashJoin : public QueryRunner {
+ public:
+  QueryRunnerHashJoin(QueryNode *query_node);
+  ~QueryRunnerHashJoin();
+
+  bool Initialize(SqlErrors::Type& error_code) final;
+  bool Run(QueryResultCallback callback, SqlErrors::Type& error_code) final;
+  bool ResultCallback(QueryRunner *child, TupleBatch& tuples) final;
+
+  void PassScanParams(ScanParams params) final;
+  bool TableName(std::string& table_name) final;
+  bool TableSize(int& blocks, int& tuples) final;
+  bool HasSortNode() const final;
+
+  void DeleteTemporaryRelations() final;
+
+ private:
+  enum Phase {
+    PHASE_BUILD = 0,
+    PHASE_PROBE,
+    PHASE_PARTITION
+  };
+
+  bool partitionInput(QueryRunner *input, Relation *relation,
+      const bool build, const int depth, const int partition_count,
+      std::vector<Relation *>& partitions);
+  bool partitionTuples(TupleBatch& tuples);
+  bool joinPartitions(Relation *build_relation, Relation *probe_relation,
+      const int depth);
+  bool probeRelation(Relation *probe_relation);
+  bool deleteRelations(std::vector<Relation *>& relations);
+
+  bool buildTable(TupleBatch& tuples);
+  bool probeTable(TupleBatch& tuples);
+  void clearTable();
+  bool passOutput(const bool last);
+  bool key(const Tuple& tuple, const bool build, std::string& key) const;
+
+  bool createIntermediateRelation(const Tuple& first, const Tuple& second,
+      std::string table_name_first, std::string table_name_second);
+  bool mergeTuples(const Tuple& first, const Tuple& second,
+      Tuple& merged_tuple);
+
+  QueryRunner *right_child_;
+  JoinAttributes join_columns_;
+  SqlErrors::Type error_code_;
+  ScanParams scan_params_;
+  int memory_start_;
+  int memory_blocks_;
+
+  // The table is built on the left input when it has fewer blocks
+  bool build_left_;
+  Phase phase_;
+  std::vector<Tuple> build_tuples_;
+  std::unordered_multimap<std::string, size_t> build_index_;
+  // The join columns as named in the tuples of either input, and bound to
+  // the schema of the build and probe tuples
+  std::vector<std::string> left_columns_;
+  std::vector<std::string> right_columns_;
+  mutable std::vector<ColumnAccessor> build_columns_;
+  mutable std::vector<ColumnAccessor> probe_columns_;
+
+  // The partitions being written, the block the first one is written
+  // through, and the side and hash they are made with
+  std::vector<Relation *> *partitions_;
+  int partition_block_;
+  bool partition_build_;
+  int partition_depth_;
+  std::vector<std::string> partition_relation_names_;
+
+  std::string intermediate_relation_name_;
+  Relation *intermediate_relation_;
+  // The field of the two inputs, numbered one after the other, that each
+  // field of the result is copied from
+  std::vector<int> merge_fields_;
+  // Passed on a memory load at a time, so a sort above gets few sublists
+  std::vector<Tuple> output_tuples_;
+};
+
+#endif // SRC_PQP_QUERY_RUNNER_HASH_JOIN_H
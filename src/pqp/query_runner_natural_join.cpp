@@ -4,11 +4,13 @@
 #include <vector>
 
 #include "base/debug.h"
+#include "base/tokenizer.h"
 #include "pqp/tuple_helper.h"
-#include "pqp/where_clause_helper_select.h"
 
 QueryRunnerNaturalJoin::QueryRunnerNaturalJoin(QueryNode *query_node)
   : QueryRunner(query_node),
+    intermediate_relation_(nullptr),
+    right_child_(nullptr),
     error_code_(SqlErrors::NO_ERROR) {
 }
 
@@ -26,16 +28,18 @@ bool QueryRunnerNaturalJoin::Initialize(SqlErrors::Type& error_code) {
     return false;
   }
 
-  if (!Node()->WhereHelper(where_helper_) || where_helper_ == nullptr) {
-    DEBUG_MSG("");
-    return false;
-  }
-
-  if (!Node()->SortColumn(compare_column_)) {
+  JoinAttributes join_columns;
+  if (!Node()->JoinColumns(join_columns) || join_columns.size() != 1) {
     DEBUG_MSG("");
+    error_code = SqlErrors::ERROR_NATURAL_JOIN;
     return false;
   }
 
+  std::string table_name;
+  Tokenizer::SplitIntoTwo(join_columns[0].first, '.', table_name,
+      left_column_);
+  Tokenizer::SplitIntoTwo(join_columns[0].second, '.', table_name,
+      right_column_);
 
   SetChildRunner(Create(Node()->Child(0)));
   right_child_ = Create(Node()->Child(1));
@@ -61,7 +65,7 @@ bool QueryRunnerNaturalJoin::Run(QueryResultCallback callback,
   params.start_index_ = Storage()->MainMemorySize() / 2;
   right_child_->PassScanParams(params);
 
-  if (!ChildRunner()->Run(
+  if (!ChildRunner()->Execute(
           std::bind(&QueryRunnerNaturalJoin::ResultCallback, this,
           std::placeholders::_1, std::placeholders::_2),
           error_code)) {
@@ -74,7 +78,7 @@ bool QueryRunnerNaturalJoin::Run(QueryResultCallback callback,
     return false;
   }
 
-  if (!right_child_->Run(
+  if (!right_child_->Execute(
       std::bind(&QueryRunnerNaturalJoin::ResultCallback, this,
       std::placeholders::_1, std::placeholders::_2),
       error_code)) {
@@ -87,12 +91,9 @@ bool QueryRunnerNaturalJoin::Run(QueryResultCallback callback,
     return false;
   }
 
-  if (left_tuples_.empty()) {
-    return Callback()(this, right_tuples_);
-  }
-
-  if (right_tuples_.empty()) {
-    return Callback()(this, right_tuples_);
+  if (left_tuples_.empty() || right_tuples_.empty()) {
+    TupleBatch empty_batch;
+    return Callback()(this, empty_batch);
   }
 
   if (intermediate_relation_name_.empty()) {
@@ -108,70 +109,60 @@ bool QueryRunnerNaturalJoin::Run(QueryResultCallback callback,
     }
   }
 
-  auto left_index = 0, right_index = 0;
+  // The join columns are bound once for the schemas of both sides. Every
+  // run of equal values on the left is paired with the run of the right
+  TupleBatch no_tuples;
+  CompareTuples comparator(left_column_, right_column_, no_tuples);
+  size_t left_index = 0, right_index = 0;
   while (left_index < left_tuples_.size() &&
       right_index < right_tuples_.size()) {
-    Tuple merged_tuple = Tuple::getDummyTuple();
-    if (!mergeTuples(left_tuples_[left_index], right_tuples_[right_index],
-        merged_tuple)) {
-      DEBUG_MSG("");
-      error_code_ = SqlErrors::ERROR_NATURAL_JOIN;
-      return false;
+    const Tuple& left_tuple = left_tuples_[left_index];
+    const Tuple& right_tuple = right_tuples_[right_index];
+    if (!comparator.IsFieldEqual(left_tuple, right_tuple)) {
+      if (comparator(left_tuple, right_tuple)) {
+        left_index++;
+      } else {
+        right_index++;
+      }
+
+      continue;
+    }
+
+    size_t left_end = left_index + 1, right_end = right_index + 1;
+    while (left_end < left_tuples_.size() &&
+        comparator.IsFieldEqual(left_tuples_[left_end], right_tuple)) {
+      left_end++;
+    }
+
+    while (right_end < right_tuples_.size() &&
+        comparator.IsFieldEqual(left_tuple, right_tuples_[right_end])) {
+      right_end++;
     }
 
-    if (where_helper_->Evaluate(&merged_tuple, error_code)) {
-      int right_it = right_index;
-      int next_right_it = 0;
-      int mismatch_count = 0;
-      std::vector<Tuple> output_tuples;
-      for (; left_index < left_tuples_.size(); left_index++) {
-        for (right_it = right_index; right_it < right_tuples_.size();
-            right_it++) {
-          std::vector<Tuple> comparison_tuples = {
-              left_tuples_[left_index],
-              right_tuples_[right_it]
-          };
-
-          CompareTuples comparator(this, comparison_tuples);
-          if (!comparator.IsFieldEqual(0, 1)) {
-            mismatch_count++;
-            break;
-          }
-
-          Tuple merged_output_tuple = Tuple::getDummyTuple();
-          if (!mergeTuples(left_tuples_[left_index], right_tuples_[right_it],
-              merged_output_tuple)) {
-            DEBUG_MSG("");
-            error_code_ = SqlErrors::ERROR_NATURAL_JOIN;
-            return false;
-          }
-
-          if (!merged_output_tuple.isNull()) {
-            output_tuples.push_back(merged_output_tuple);
-          }
+    std::vector<Tuple> output_tuples;
+    for (; left_index < left_end; left_index++) {
+      for (size_t right_it = right_index; right_it < right_end; right_it++) {
+        Tuple merged_output_tuple = Tuple::getDummyTuple();
+        if (!mergeTuples(left_tuples_[left_index], right_tuples_[right_it],
+            merged_output_tuple)) {
+          DEBUG_MSG("");
+          error_code_ = SqlErrors::ERROR_NATURAL_JOIN;
+          return false;
         }
-        next_right_it = right_it;
 
-        if (mismatch_count > 1) {
-          break;
+        if (!merged_output_tuple.isNull()) {
+          output_tuples.push_back(merged_output_tuple);
         }
       }
+    }
 
-      right_index = next_right_it + 1;
+    right_index = right_end;
 
-      Callback()(this, output_tuples);
-    } else {
-      std::vector<Tuple> comparison_tuples = {
-          left_tuples_[left_index],
-          right_tuples_[right_index]
-      };
-
-      CompareTuples comparator(this, comparison_tuples);
-      if (comparator(0, 1)) {
-        left_index++;
-      } else {
-        right_index++;
-      }
+    TupleBatch output_batch(output_tuples);
+    if (!Callback()(this, output_batch)) {
+      DEBUG_MSG("");
+      error_code = error_code_;
+      return false;
     }
   }
 
@@ -179,16 +170,21 @@ bool QueryRunnerNaturalJoin::Run(QueryResultCallback callback,
 }
 
 bool QueryRunnerNaturalJoin::ResultCallback(QueryRunner *child,
-    std::vector<Tuple>& tuples) {
-  if (tuples.empty()) {
+    TupleBatch& tuples) {
+  if (tuples.Empty()) {
     DEBUG_MSG("");
     return true;
   }
 
+  // Both inputs are kept until the merge, so the batches are copied
   if (child == ChildRunner()) {
-    left_tuples_.insert(left_tuples_.end(), tuples.begin(), tuples.end());
+    for (const Tuple& tuple : tuples) {
+      left_tuples_.push_back(tuple);
+    }
   } else if (child == right_child_) {
-    right_tuples_.insert(right_tuples_.end(), tuples.begin(), tuples.end());
+    for (const Tuple& tuple : tuples) {
+      right_tuples_.push_back(tuple);
+    }
   } else {
     DEBUG_MSG("Invalid child for natural join");
     return false;
@@ -197,10 +193,6 @@ bool QueryRunnerNaturalJoin::ResultCallback(QueryRunner *child,
   return true;
 }
 
-std::string QueryRunnerNaturalJoin::CompareColumn() const {
-  return compare_column_;
-}
-
 void QueryRunnerNaturalJoin::PassScanParams(ScanParams params) {
 }
 
@@ -224,10 +216,11 @@ void QueryRunnerNaturalJoin::DeleteTemporaryRelations() {
   QueryRunner::DeleteTemporaryRelations();
 }
 
-bool QueryRunnerNaturalJoin::createIntermediateRelation(Tuple first, Tuple second,
+bool QueryRunnerNaturalJoin::createIntermediateRelation(
+    const Tuple& first, const Tuple& second,
     std::string table_name_first, std::string table_name_second) {
-  Schema schema_first = first.getSchema();
-  Schema schema_second = second.getSchema();
+  const Schema& schema_first = first.getSchemaRef();
+  const Schema& schema_second = second.getSchemaRef();
   std::vector<std::string> field_names = schema_first.getFieldNames();
   std::vector<enum FIELD_TYPE> field_types = schema_first.getFieldTypes();
 
@@ -257,27 +250,25 @@ bool QueryRunnerNaturalJoin::createIntermediateRelation(Tuple first, Tuple secon
   }
 
   MarkTemporaryRelation(intermediate_relation_name_);
+  intermediate_relation_ = Storage()->GetRelation(intermediate_relation_name_);
 
   return true;
 }
 
-bool QueryRunnerNaturalJoin::mergeTuples(Tuple first, Tuple second,
+bool QueryRunnerNaturalJoin::mergeTuples(const Tuple& first, const Tuple& second,
     Tuple& merged_tuple) {
-  if (intermediate_relation_name_.empty()) {
+  if (intermediate_relation_ == nullptr) {
     DEBUG_MSG("");
     return false;
   }
 
-  if (!Storage()->CreateEmptyTuple(intermediate_relation_name_, merged_tuple)) {
-    DEBUG_MSG("");
-    return false;
-  }
+  merged_tuple = intermediate_relation_->createTuple();
 
+  const Schema& schema_first = first.getSchemaRef();
   for (auto it = 0; it < first.getNumOfFields(); it++) {
-    Schema schema = first.getSchema();
-    if (schema.getFieldType(it) == INT) {
+    if (schema_first.getFieldType(it) == INT) {
       merged_tuple.setField(it, first.getField(it).integer);
-    } else if (schema.getFieldType(it) == STR20) {
+    } else if (schema_first.getFieldType(it) == STR20) {
       merged_tuple.setField(it, *(first.getField(it).str));
     } else {
       DEBUG_MSG("");
@@ -285,12 +276,12 @@ bool QueryRunnerNaturalJoin::mergeTuples(Tuple first, Tuple second,
     }
   }
 
+  const Schema& schema_second = second.getSchemaRef();
   for (auto it = 0; it < second.getNumOfFields(); it++) {
-    Schema schema = second.getSchema();
-    if (schema.getFieldType(it) == INT) {
+    if (schema_second.getFieldType(it) == INT) {
       merged_tuple.setField(
           first.getNumOfFields() + it, second.getField(it).integer);
-    } else if (schema.getFieldType(it) == STR20) {
+    } else if (schema_second.getFieldType(it) == STR20) {
       merged_tuple.setField(
           first.getNumOfFields() + it, *(second.getField(it).str));
     } else {
@@ -11,8 +11,7 @@ class QueryRunnerNaturalJoin : public QueryRunner {
 
   bool Initialize(SqlErrors::Type& error_code) final;
   bool Run(QueryResultCallback callback, SqlErrors::Type& error_code) final;
-  bool ResultCallback(QueryRunner *child, std::vector<Tuple>& tuples) final;
-  std::string CompareColumn() const final;
+  bool ResultCallback(QueryRunner *child, TupleBatch& tuples) final;
 
   void PassScanParams(ScanParams params) final;
   bool TableName(std::string& table_name) final;
@@ -22,17 +21,20 @@ class QueryRunnerNaturalJoin : public QueryRunner {
   void DeleteTemporaryRelations() final;
 
 private:
-  bool createIntermediateRelation(Tuple first, Tuple second,
+  bool createIntermediateRelation(const Tuple& first, const Tuple& second,
       std::string table_name_first, std::string table_name_second);
-  bool mergeTuples(Tuple first, Tuple second, Tuple& merged_tuple);
+  bool mergeTuples(const Tuple& first, const Tuple& second,
+      Tuple& merged_tuple);
 
   std::vector<Tuple> left_tuples_;
   std::vector<Tuple> right_tuples_;
   std::string intermediate_relation_name_;
+  Relation *intermediate_relation_;
 
   QueryRunner *right_child_;
-  std::string compare_column_;
-  WhereClauseHelperSelect *where_helper_;
+  // The column of either table the inputs are sorted and joined on
+  std::string left_column_;
+  std::string right_column_;
   SqlErrors::Type error_code_;
 };
 
@@ -1,5 +1,6 @@
 #include "pqp/query_runner_product.h"
 
+#include <algorithm>
 #include <vector>
 
 #include "base/debug.h"
@@ -7,13 +8,19 @@
 
 QueryRunnerProduct::QueryRunnerProduct(QueryNode *query_node)
   : QueryRunner(query_node),
+    intermediate_relation_(nullptr),
+    where_helper_(nullptr),
+    second_child_(nullptr),
+    outer_child_(nullptr),
+    inner_child_(nullptr),
+    outer_blocks_(1),
     error_code_(SqlErrors::NO_ERROR) {
 }
 
 QueryRunnerProduct::~QueryRunnerProduct() {
-  if (table_scan_child_ != nullptr) {
-    delete table_scan_child_;
-    table_scan_child_ = nullptr;
+  if (second_child_ != nullptr) {
+    delete second_child_;
+    second_child_ = nullptr;
   }
 }
 
@@ -24,19 +31,27 @@ bool QueryRunnerProduct::Initialize(SqlErrors::Type& error_code) {
     return false;
   }
 
+  if (NodeType() == QueryNode::QUERY_NODE_TYPE_THETA_JOIN &&
+      (!Node()->WhereHelper(where_helper_) || where_helper_ == nullptr)) {
+    DEBUG_MSG("");
+    error_code = SqlErrors::ERROR_CROSS_PRODUCT;
+    return false;
+  }
+
   QueryNode *left_child = Node()->Child(0);
   QueryNode *right_child = Node()->Child(1);
   if (right_child->Type() == QueryNode::QUERY_NODE_TYPE_CROSS_PRODUCT ||
+      right_child->Type() == QueryNode::QUERY_NODE_TYPE_THETA_JOIN ||
       right_child->Type() == QueryNode::QUERY_NODE_TYPE_SORT) {
     SetChildRunner(Create(right_child));
-    table_scan_child_ = Create(left_child);
+    second_child_ = Create(left_child);
   } else {
     SetChildRunner(Create(left_child));
-    table_scan_child_ = Create(right_child);
+    second_child_ = Create(right_child);
   }
 
   if (!ChildRunner()->Initialize(error_code) ||
-      !table_scan_child_->Initialize(error_code)) {
+      !second_child_->Initialize(error_code)) {
     DEBUG_MSG("Failed to initialize");
     return false;
   }
@@ -48,19 +63,41 @@ bool QueryRunnerProduct::Run(QueryResultCallback callback,
     SqlErrors::Type& error_code) {
   SetCallback(callback);
 
-  ScanParams params;
-  params.num_blocks_ = 1;
+  int first_blocks = 0, second_blocks = 0, tuples = 0;
+  bool first_known = ChildRunner()->TableSize(first_blocks, tuples);
+  bool second_known = second_child_->TableSize(second_blocks, tuples);
+  bool second_outer = !ChildRunner()->HasSortNode() &&
+      (second_child_->HasSortNode() ||
+      (second_known && (!first_known || second_blocks < first_blocks)));
+  outer_child_ = second_outer ? second_child_ : ChildRunner();
+  inner_child_ = second_outer ? ChildRunner() : second_child_;
+  bool inner_known = second_outer ? first_known : second_known;
+
   int start_index = scan_params_.start_index_;
+  int memory = scan_params_.num_blocks_ > 0 ? scan_params_.num_blocks_ :
+      Storage()->MainMemorySize() - start_index;
+  int inner_blocks = inner_known ? 1 : std::max(memory / 2, 1);
+  outer_blocks_ = std::max(memory - inner_blocks - 1, 1);
+
+  ScanParams params;
   params.start_index_ = start_index;
-  ChildRunner()->PassScanParams(params);
+  params.num_blocks_ = outer_blocks_;
+  outer_child_->PassScanParams(params);
 
-  params.start_index_++;
-  table_scan_child_->PassScanParams(params);
+  params.start_index_ = start_index + memory - inner_blocks;
+  params.num_blocks_ = inner_blocks;
+  inner_child_->PassScanParams(params);
 
-  if (!ChildRunner()->Run(
+  first_table_name_.clear();
+  second_table_name_.clear();
+  ChildRunner()->TableName(first_table_name_);
+  second_child_->TableName(second_table_name_);
+
+  outer_tuples_.clear();
+  if (!outer_child_->Execute(
       std::bind(&QueryRunnerProduct::ResultCallback, this,
           std::placeholders::_1, std::placeholders::_2),
-      error_code)) {
+      error_code) || !joinOuterTuples()) {
     DEBUG_MSG("");
     if (error_code_ == SqlErrors::NO_ERROR) {
       error_code_ = SqlErrors::ERROR_CROSS_PRODUCT;
@@ -74,34 +111,48 @@ bool QueryRunnerProduct::Run(QueryResultCallback callback,
 }
 
 bool QueryRunnerProduct::ResultCallback(QueryRunner *child,
-    std::vector<Tuple>& tuples) {
-  if (tuples.empty()) {
+    TupleBatch& tuples) {
+  if (tuples.Empty()) {
     return true;
   }
 
-  if (child == ChildRunner()) {
-    first_tuples_ = tuples;
-    if (!table_scan_child_->Run(
-        std::bind(&QueryRunnerProduct::ResultCallback, this,
-            std::placeholders::_1, std::placeholders::_2),
-        error_code_)) {
-      DEBUG_MSG("");
-      error_code_ = SqlErrors::ERROR_CROSS_PRODUCT;
-      return false;
+  if (child == outer_child_) {
+    // The outer tuples are kept past the batch, until a memory load of them
+    // is paired with the inner input
+    std::vector<Tuple> outer_tuples = tuples.Copy();
+    outer_tuples_.insert(outer_tuples_.end(),
+        outer_tuples.begin(), outer_tuples.end());
+    if (outer_tuples_.size() <
+        outer_blocks_ * tuples[0].getSchemaRef().getTuplesPerBlock()) {
+      return true;
     }
 
-    first_tuples_.clear();
-  } else if (child == table_scan_child_) {
+    return joinOuterTuples();
+  } else if (child == inner_child_) {
+    bool ordered = !ordered_tuples_.empty();
     std::vector<Tuple> output_tuples;
-    for (auto first_tuple : first_tuples_) {
-      for (auto second_tuple : tuples) {
-        if (intermediate_relation_name_.empty()) {
-          std::string table_name_first, table_name_second;
-          ChildRunner()->TableName(table_name_first);
-          table_scan_child_->TableName(table_name_second);
+    output_tuples.reserve(ordered ? 0 : outer_tuples_.size() * tuples.Size());
+    for (int index = 0; index < outer_tuples_.size(); index++) {
+      const Tuple& outer_tuple = outer_tuples_[index];
+      for (const Tuple& inner_tuple : tuples) {
+        const Tuple& first_tuple = outer_child_ == ChildRunner() ?
+            outer_tuple : inner_tuple;
+        const Tuple& second_tuple = outer_child_ == ChildRunner() ?
+            inner_tuple : outer_tuple;
+        if (where_helper_ != nullptr &&
+            !where_helper_->EvaluatePair(first_tuple, first_table_name_,
+                second_tuple, second_table_name_, error_code_)) {
+          if (error_code_ != SqlErrors::NO_ERROR) {
+            DEBUG_MSG("");
+            return false;
+          }
 
+          continue;
+        }
+
+        if (intermediate_relation_name_.empty()) {
           if (!createIntermediateRelation(first_tuple, second_tuple,
-              table_name_first, table_name_second)) {
+              first_table_name_, second_table_name_)) {
             DEBUG_MSG("");
             error_code_ = SqlErrors::ERROR_CROSS_PRODUCT;
             return false;
@@ -115,12 +166,17 @@ bool QueryRunnerProduct::ResultCallback(QueryRunner *child,
           return false;
         }
 
-        output_tuples.push_back(merged_tuple);
+        if (ordered) {
+          ordered_tuples_[index].push_back(merged_tuple);
+        } else {
+          output_tuples.push_back(merged_tuple);
+        }
       }
     }
 
     if (!output_tuples.empty()) {
-      return Callback()(this, output_tuples);
+      TupleBatch output_batch(output_tuples);
+      return Callback()(this, output_batch);
     }
   } else {
     DEBUG_MSG("");
@@ -144,21 +200,61 @@ bool QueryRunnerProduct::TableSize(int& blocks, int& tuples) {
 }
 
 bool QueryRunnerProduct::HasSortNode() const {
-  return ChildRunner()->HasSortNode() || table_scan_child_->HasSortNode();
+  return ChildRunner()->HasSortNode() || second_child_->HasSortNode();
 }
 
 void QueryRunnerProduct::DeleteTemporaryRelations() {
-  if (table_scan_child_ != nullptr) {
-    table_scan_child_->DeleteTemporaryRelations();
+  if (second_child_ != nullptr) {
+    second_child_->DeleteTemporaryRelations();
   }
 
   QueryRunner::DeleteTemporaryRelations();
 }
 
-bool QueryRunnerProduct::createIntermediateRelation(Tuple first, Tuple second,
+// Private methods
+bool QueryRunnerProduct::joinOuterTuples() {
+  if (outer_tuples_.empty()) {
+    return true;
+  }
+
+  // A sorted outer input keeps its order when the inner one comes in more
+  // than one batch, so the results of every outer tuple are held until the
+  // inner input ends
+  if (outer_child_->HasSortNode()) {
+    ordered_tuples_.assign(outer_tuples_.size(), std::vector<Tuple>());
+  }
+
+  bool joined = inner_child_->Execute(
+      std::bind(&QueryRunnerProduct::ResultCallback, this,
+          std::placeholders::_1, std::placeholders::_2),
+      error_code_);
+  outer_tuples_.clear();
+  if (!joined) {
+    DEBUG_MSG("");
+    ordered_tuples_.clear();
+    error_code_ = SqlErrors::ERROR_CROSS_PRODUCT;
+    return false;
+  }
+
+  std::vector<Tuple> output_tuples;
+  for (auto& tuples : ordered_tuples_) {
+    output_tuples.insert(output_tuples.end(), tuples.begin(), tuples.end());
+  }
+
+  ordered_tuples_.clear();
+  if (output_tuples.empty()) {
+    return true;
+  }
+
+  TupleBatch output_batch(output_tuples);
+  return Callback()(this, output_batch);
+}
+
+bool QueryRunnerProduct::createIntermediateRelation(
+    const Tuple& first, const Tuple& second,
     std::string table_name_first, std::string table_name_second) {
-  Schema schema_first = first.getSchema();
-  Schema schema_second = second.getSchema();
+  const Schema& schema_first = first.getSchemaRef();
+  const Schema& schema_second = second.getSchemaRef();
   std::vector<std::string> field_names = schema_first.getFieldNames();
   std::vector<enum FIELD_TYPE> field_types = schema_first.getFieldTypes();
 
@@ -181,49 +277,51 @@ bool QueryRunnerProduct::createIntermediateRelation(Tuple first, Tuple second,
   field_types.insert(field_types.end(),
       field_types_second.begin(), field_types_second.end());
 
-  if (!Storage()->CreateDummyRelation("Product_", field_names, field_types,
+  // A join of a join tree keeps only the columns the plan uses above it
+  std::vector<std::string> output_columns;
+  Node()->OutputColumns(output_columns);
+  std::vector<std::string> output_names;
+  std::vector<enum FIELD_TYPE> output_types;
+  merge_fields_.clear();
+  for (int index = 0; index < field_names.size(); index++) {
+    if (output_columns.empty() || std::find(output_columns.begin(),
+        output_columns.end(), field_names[index]) != output_columns.end()) {
+      merge_fields_.push_back(index);
+      output_names.push_back(field_names[index]);
+      output_types.push_back(field_types[index]);
+    }
+  }
+
+  if (!Storage()->CreateDummyRelation("Product_", output_names, output_types,
       intermediate_relation_name_)) {
     DEBUG_MSG("");
     return false;
   }
 
   MarkTemporaryRelation(intermediate_relation_name_);
+  intermediate_relation_ = Storage()->GetRelation(intermediate_relation_name_);
 
   return true;
 }
 
-bool QueryRunnerProduct::mergeTuples(Tuple first, Tuple second,
+bool QueryRunnerProduct::mergeTuples(const Tuple& first, const Tuple& second,
     Tuple& merged_tuple) {
-  if (intermediate_relation_name_.empty()) {
-    DEBUG_MSG("");
-    return false;
-  }
-
-  if (!Storage()->CreateEmptyTuple(intermediate_relation_name_, merged_tuple)) {
+  if (intermediate_relation_ == nullptr) {
     DEBUG_MSG("");
     return false;
   }
 
-  for (auto it = 0; it < first.getNumOfFields(); it++) {
-    Schema schema = first.getSchema();
-    if (schema.getFieldType(it) == INT) {
-      merged_tuple.setField(it, first.getField(it).integer);
-    } else if (schema.getFieldType(it) == STR20) {
-      merged_tuple.setField(it, *(first.getField(it).str));
-    } else {
-      DEBUG_MSG("");
-      return false;
-    }
-  }
-
-  for (auto it = 0; it < second.getNumOfFields(); it++) {
-    Schema schema = second.getSchema();
-    if (schema.getFieldType(it) == INT) {
-      merged_tuple.setField(
-          first.getNumOfFields() + it, second.getField(it).integer);
-    } else if (schema.getFieldType(it) == STR20) {
-      merged_tuple.setField(
-          first.getNumOfFields() + it, *(second.getField(it).str));
+  merged_tuple = intermediate_relation_->createTuple();
+
+  for (auto it = 0; it < merge_fields_.size(); it++) {
+    bool from_first = merge_fields_[it] < first.getNumOfFields();
+    const Tuple& tuple = from_first ? first : second;
+    int field = from_first ? merge_fields_[it] :
+        merge_fields_[it] - first.getNumOfFields();
+    if (tuple.getSchemaRef().getFieldType(field) == INT) {
+      merged_tuple.setField(it, tuple.getField(field).integer);
+    } else if (tuple.getSchemaRef().getFieldType(field) == STR20) {
+      merged_tuple.setField(it, *(tuple.getField(field).str));
     } else {
       DEBUG_MSG("");
       return false;
@@ -1,9 +1,21 @@
 #ifndef SRC_PQP_QUERY_RUNNER_PRODUCT_H
 #define SRC_PQP_QUERY_RUNNER_PRODUCT_H
 
+#include <string>
+#include <vector>
+
 #include "base/sql_errors.h"
 #include "pqp/query_runner.h"
 
+// Pairs every tuple of one input with every tuple of the other, block nested
+// loop style: the outer input is collected a memory load at a time, all of
+// main memory but a block for the inner input and one for the output, and
+// the inner input is run once for every load. The outer input is the one
+// with fewer blocks, or the one with a sort below it, whose order is kept;
+// an input of unknown size, such as another product, is run as the inner
+// one with half of the memory. A theta join is a product with a condition,
+// checked on every pair before the tuples are merged, so only the pairs it
+// keeps are.
 class QueryRunnerProduct : public QueryRunner {
  public:
   QueryRunnerProduct(QueryNode *query_node);
@@ -11,7 +23,7 @@ class QueryRunnerProduct : public QueryRunner {
 
   bool Initialize(SqlErrors::Type& error_code) final;
   bool Run(QueryResultCallback callback, SqlErrors::Type& error_code) final;
-  bool ResultCallback(QueryRunner *child, std::vector<Tuple>& tuples) final;
+  bool ResultCallback(QueryRunner *child, TupleBatch& tuples) final;
 
   void PassScanParams(ScanParams params) final;
   bool TableName(std::string& table_name) final;
@@ -21,15 +33,31 @@ class QueryRunnerProduct : public QueryRunner {
   void DeleteTemporaryRelations() final;
 
 private:
-  bool createIntermediateRelation(Tuple first, Tuple second,
+  bool joinOuterTuples();
+  bool createIntermediateRelation(const Tuple& first, const Tuple& second,
       std::string table_name_first, std::string table_name_second);
-  bool mergeTuples(Tuple first, Tuple second, Tuple& merged_tuple);
+  bool mergeTuples(const Tuple& first, const Tuple& second,
+      Tuple& merged_tuple);
 
   ScanParams scan_params_;
   std::string intermediate_relation_name_;
-  std::vector<Tuple> first_tuples_;
+  Relation *intermediate_relation_;
+  // The field of the two inputs, numbered one after the other, that each
+  // field of the result is copied from
+  std::vector<int> merge_fields_;
+
+  WhereClauseHelperSelect *where_helper_;
+  std::string first_table_name_;
+  std::string second_table_name_;
 
-  QueryRunner *table_scan_child_;
+  // The fields of the first child come first in the result
+  QueryRunner *second_child_;
+  QueryRunner *outer_child_;
+  QueryRunner *inner_child_;
+  int outer_blocks_;
+  std::vector<Tuple> outer_tuples_;
+  // The results of every outer tuple, when their order has to be kept
+  std::vector<std::vector<Tuple>> ordered_tuples_;
   SqlErrors::Type error_code_;
 };
 
@@ -28,21 +28,21 @@ bool QueryRunnerProjection::Run(QueryResultCallback callback,
     SqlErrors::Type& error_code) {
   SetCallback(callback);
 
-  return ChildRunner()->Run(
+  return ChildRunner()->Execute(
       std::bind(&QueryRunnerProjection::ResultCallback, this,
           std::placeholders::_1, std::placeholders::_2),
       error_code);
 }
 
 bool QueryRunnerProjection::ResultCallback(QueryRunner *child,
-    std::vector<Tuple>& tuples) {
+    TupleBatch& tuples) {
   std::vector<std::string> select_list;
   if (!Node()->SelectList(select_list)) {
     DEBUG_MSG("");
     return false;
   }
 
-  if (tuples.empty()) {
+  if (tuples.Empty()) {
     return true;
   }
 
@@ -50,36 +50,32 @@ bool QueryRunnerProjection::ResultCallback(QueryRunner *child,
     return Callback()(this, tuples);
   }
 
-  std::string temp_relation_name;
-  if (!Storage()->CreateDummyRelation("Projection_", select_list,
-      temp_relation_name)) {
-    DEBUG_MSG("");
-    return false;
+  if (projection_relation_name_.empty()) {
+    if (!Storage()->CreateDummyRelation("Projection_", select_list,
+        projection_relation_name_)) {
+      DEBUG_MSG("");
+      return false;
+    }
+
+    MarkTemporaryRelation(projection_relation_name_);
   }
 
   std::vector<Tuple> output_tuples;
-  for (auto tuple : tuples) {
+  output_tuples.reserve(tuples.Size());
+  for (const Tuple& tuple : tuples) {
+    if (!bindSelectList(tuple.getSchemaRef(), select_list)) {
+      DEBUG_MSG("");
+      return false;
+    }
+
     std::vector<std::string> tuples_row;
-    for (auto field : select_list) {
-      if (tuple.getSchema().getFieldType(field) == INT) {
-        int value = tuple.getField(field).integer;
-        std::string integer_value = std::to_string(value);
-        if (value == -1) {
-          integer_value = "NULL";
-        }
-
-        tuples_row.push_back(integer_value);
-      } else if (tuple.getSchema().getFieldType(field) == STR20) {
-        tuples_row.push_back(*(tuple.getField(field).str));
-      } else {
-        DEBUG_MSG("");
-        return false;
-      }
+    for (const ColumnAccessor& column : select_columns_) {
+      tuples_row.push_back(column.Value(tuple));
     }
 
     bool tuple_created = false;
     Tuple output_tuple = Storage()->CreateTuple(
-        temp_relation_name, tuples_row, tuple_created);
+        projection_relation_name_, tuples_row, tuple_created);
     if (!tuple_created) {
       DEBUG_MSG("");
       return false;
@@ -88,11 +84,30 @@ bool QueryRunnerProjection::ResultCallback(QueryRunner *child,
     output_tuples.push_back(output_tuple);
   }
 
-  if (!Callback()(this, output_tuples)) {
+  TupleBatch output_batch(output_tuples);
+  if (!Callback()(this, output_batch)) {
     DEBUG_MSG("");
     return false;
   }
 
-  Storage()->DeleteDummyRelation(temp_relation_name);
+  return true;
+}
+
+// Private methods
+bool QueryRunnerProjection::bindSelectList(const Schema& schema,
+    const std::vector<std::string>& select_list) {
+  if (!select_columns_.empty() && select_columns_[0].IsBoundTo(schema)) {
+    return true;
+  }
+
+  select_columns_.assign(select_list.size(), ColumnAccessor());
+  for (auto index = 0; index < select_list.size(); index++) {
+    if (!select_columns_[index].Bind(schema, select_list[index])) {
+      DEBUG_MSG("Invalid column: " << select_list[index]);
+      select_columns_.clear();
+      return false;
+    }
+  }
+
   return true;
 }
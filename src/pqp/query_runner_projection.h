@@ -1,7 +1,11 @@
 #ifndef SRC_PQP_QUERY_RUNNER_PROJECTION_H
 #define SRC_PQP_QUERY_RUNNER_PROJECTION_H
 
+#include <string>
+#include <vector>
+
 #include "base/sql_errors.h"
+#include "pqp/column_accessor.h"
 #include "pqp/query_runner.h"
 
 class QueryRunnerProjection : public QueryRunner {
@@ -11,7 +15,16 @@ class QueryRunnerProjection : public QueryRunner {
 
   bool Initialize(SqlErrors::Type& error_code) final;
   bool Run(QueryResultCallback callback, SqlErrors::Type& error_code) final;
-  bool ResultCallback(QueryRunner *child, std::vector<Tuple>& tuples) final;
+  bool ResultCallback(QueryRunner *child, TupleBatch& tuples) final;
+
+ private:
+  bool bindSelectList(const Schema& schema,
+      const std::vector<std::string>& select_list);
+
+  // The select list resolved against the schema of the input tuples
+  std::vector<ColumnAccessor> select_columns_;
+  // Holds the projected tuples of every batch; deleted with the query
+  std::string projection_relation_name_;
 };
 
 #endif // SRC_PQP_QUERY_RUNNER_PROJECTION_H
@@ -8,6 +8,7 @@
 
 QueryRunnerScan::QueryRunnerScan(QueryNode *query_node)
   : QueryRunner(query_node),
+    relation_(nullptr),
     next_relation_start_index_(0),
     error_code_(SqlErrors::NO_ERROR) {
   if (!Node()->TableName(table_name_)) {
@@ -32,6 +33,13 @@ bool QueryRunnerScan::Run(QueryResultCallback callback,
     SqlErrors::Type& error_code) {
   SetCallback(callback);
 
+  relation_ = Storage()->GetRelation(table_name_);
+  if (relation_ == nullptr) {
+    ERROR_MSG("Invalid relation name: " << table_name_);
+    error_code = SqlErrors::ERROR_TABLE_SCAN;
+    return false;
+  }
+
   bool respond_once = false;
   std::vector<Block *> blocks;
 
@@ -45,18 +53,34 @@ bool QueryRunnerScan::Run(QueryResultCallback callback,
   int relation_start_index = 0;
   int num_blocks = scan_params_.num_blocks_ <= 0 ?
       Storage()->MainMemorySize() : scan_params_.num_blocks_;
-  while (!respond_once &&
-      Storage()->ReadRelationBlocks(table_name_, relation_start_index,
-          memory_start_index, num_blocks, blocks)) {
-    std::vector<Tuple> tuples;
+  // While the parent works on a batch, the next one is read ahead if there
+  // is read-ahead memory left
+  ReadAheadBatch next_batch;
+  bool read_ahead = false;
+  while (!respond_once) {
+    bool read = read_ahead ?
+        Storage()->FinishReadAhead(next_batch, memory_start_index, num_blocks,
+            blocks) :
+        Storage()->ReadRelationBlocks(relation_, relation_start_index,
+            memory_start_index, num_blocks, blocks);
+    if (!read) {
+      break;
+    }
+
+    read_ahead = scan_params_.multi_scan_ &&
+        Storage()->StartReadAhead(relation_,
+            relation_start_index + blocks.size(), num_blocks, next_batch);
+
+    // The tuples are passed where they are and the blocks cleared after
+    TupleBatch tuples(blocks);
+    bool result = Callback()(this, tuples);
     for (auto block : blocks) {
-      std::vector<Tuple> insert_tuples = block->getTuples();
-      tuples.insert(tuples.end(), insert_tuples.begin(), insert_tuples.end());
       block->clear();
     }
 
-    if (!Callback()(this, tuples)) {
+    if (!result) {
       DEBUG_MSG("");
+      Storage()->CancelReadAhead(next_batch);
       return false;
     }
 
@@ -105,7 +129,7 @@ bool QueryRunnerScan::TableSize(int& blocks, int& tuples) {
 }
 
 bool QueryRunnerScan::ResultCallback(QueryRunner *child,
-    std::vector<Tuple>& tuples) {
+    TupleBatch& tuples) {
   DEBUG_MSG("EMPTY FUNCTION");
   return true;
 }
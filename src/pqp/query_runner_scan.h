@@ -14,10 +14,11 @@ class QueryRunnerScan : public QueryRunner {
   void PassScanParams(ScanParams params) final;
   bool TableName(std::string& table_name) final;
   bool TableSize(int& blocks, int& tuples) final;
-  bool ResultCallback(QueryRunner *child, std::vector<Tuple>& tuples) final;
+  bool ResultCallback(QueryRunner *child, TupleBatch& tuples) final;
 
 private:
   std::string table_name_;
+  Relation *relation_;
 
   int next_relation_start_index_;
   ScanParams scan_params_;
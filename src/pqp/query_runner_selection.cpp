@@ -29,7 +29,7 @@ bool QueryRunnerSelection::Run(QueryResultCallback callback,
     SqlErrors::Type& error_code) {
   SetCallback(callback);
 
-  if (!ChildRunner()->Run(
+  if (!ChildRunner()->Execute(
       std::bind(&QueryRunnerSelection::ResultCallback, this,
           std::placeholders::_1, std::placeholders::_2),
       error_code)) {
@@ -46,25 +46,20 @@ bool QueryRunnerSelection::Run(QueryResultCallback callback,
 }
 
 bool QueryRunnerSelection::ResultCallback(QueryRunner *child,
-    std::vector<Tuple>& tuples) {
+    TupleBatch& tuples) {
   WhereClauseHelperSelect *where_helper;
   if (!Node()->WhereHelper(where_helper) || where_helper == nullptr) {
     DEBUG_MSG("");
     return false;
   }
 
-  if (tuples.empty()) {
+  if (tuples.Empty()) {
     return true;
   }
 
-  auto tuple_index = tuples.begin();
-  while (tuple_index != tuples.end()) {
-    if (!where_helper->Evaluate(&*tuple_index, error_code_)) {
-      tuple_index = tuples.erase(tuple_index);
-    } else {
-      tuple_index++;
-    }
-  }
+  tuples.Filter([&](const Tuple& tuple) {
+    return where_helper->Evaluate(&tuple, error_code_);
+  });
 
   if (!Callback()(this, tuples)) {
     DEBUG_MSG("");
@@ -11,7 +11,7 @@ class QueryRunnerSelection : public QueryRunner {
 
   bool Initialize(SqlErrors::Type& error_code) final;
   bool Run(QueryResultCallback callback, SqlErrors::Type& error_code) final;
-  bool ResultCallback(QueryRunner *child, std::vector<Tuple>& tuples) final;
+  bool ResultCallback(QueryRunner *child, TupleBatch& tuples) final;
 
 private:
   SqlErrors::Type error_code_;
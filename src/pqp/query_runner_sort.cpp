@@ -11,6 +11,7 @@
 
 QueryRunnerSort::QueryRunnerSort(QueryNode *query_node)
   : QueryRunner(query_node),
+    intermediate_relation_(nullptr),
     block_size_(-1),
     tuples_per_block_(-1),
     memory_constraint_(Storage()->MainMemorySize()),
@@ -44,7 +45,7 @@ bool QueryRunnerSort::Run(QueryResultCallback callback,
 
   ChildRunner()->PassScanParams(scan_params_);
 
-  if (!ChildRunner()->Run(
+  if (!ChildRunner()->Execute(
       std::bind(&QueryRunnerSort::ResultCallback, this,
           std::placeholders::_1, std::placeholders::_2),
       error_code)) {
@@ -63,7 +64,7 @@ bool QueryRunnerSort::Run(QueryResultCallback callback,
   std::vector<int> sublist_block_indices(sublist_size_list_.size(), 0);
   for (auto index = 0; index < sublist_size_list_.size(); index++) {
     std::vector<Block *> sublist_blocks;
-    if (!Storage()->ReadRelationBlocks(intermediate_relation_name_,
+    if (!Storage()->ReadRelationBlocks(intermediate_relation_,
         relation_index, memory_index++, 1, sublist_blocks)) {
       DEBUG_MSG("");
       return false;
@@ -88,7 +89,7 @@ bool QueryRunnerSort::Run(QueryResultCallback callback,
       if (block_tuple_indices[index] == blocks[index]->getNumTuples()) {
         if (sublist_block_indices[index] < sublist_size_list_[index] - 1) {
           std::vector<Block *> sublist_blocks;
-          if (!Storage()->ReadRelationBlocks(intermediate_relation_name_,
+          if (!Storage()->ReadRelationBlocks(intermediate_relation_,
               ++sublist_block_indices[index], scan_params_.start_index_ + index,
               1, sublist_blocks)) {
             DEBUG_MSG("");
@@ -112,15 +113,17 @@ bool QueryRunnerSort::Run(QueryResultCallback callback,
       }
     }
 
+    TupleBatch minimum_batch(minimum_tuples);
     std::vector<size_t> sort_indices(minimum_tuples.size());
     std::iota(sort_indices.begin(), sort_indices.end(), 0);
     std::sort(sort_indices.begin(),
-        sort_indices.end(), CompareTuples(this, minimum_tuples));
+        sort_indices.end(), CompareTuples(this, minimum_batch));
     minimum_tuple = minimum_tuples[sort_indices[0]];
     block_tuple_indices[sort_indices[0]]++;
 
     if (minimum_tuple.isNull()) {
-      Callback()(this, output_tuples);
+      TupleBatch output_batch(output_tuples);
+      Callback()(this, output_batch);
       break;
     }
 
@@ -129,7 +132,8 @@ bool QueryRunnerSort::Run(QueryResultCallback callback,
     }
 
     if (output_tuples.size() == memory_constraint_ * tuples_per_block_) {
-      Callback()(this, output_tuples);
+      TupleBatch output_batch(output_tuples);
+      Callback()(this, output_batch);
       output_tuples.clear();
     }
   }
@@ -156,27 +160,20 @@ bool QueryRunnerSort::HasSortNode() const {
 }
 
 bool QueryRunnerSort::ResultCallback(QueryRunner *child,
-    std::vector<Tuple>& tuples) {
-  if (tuples.empty()) {
+    TupleBatch& tuples) {
+  if (tuples.Empty()) {
     return true;
   }
 
-  if (tuples_per_block_ == -1) {
-    tuples_per_block_ = tuples[0].getSchema().getTuplesPerBlock();
-  }
-
   int tuple_size;
   if (TableSize(block_size_, tuple_size) && block_size_ <= memory_constraint_) {
-    std::vector<size_t> sort_indices(tuples.size());
+    std::vector<size_t> sort_indices(tuples.Size());
     std::iota(sort_indices.begin(), sort_indices.end(), 0);
     std::sort(sort_indices.begin(), sort_indices.end(),
         CompareTuples(this, tuples));
 
-    std::vector<Tuple> sorted_tuples;
-    for (auto sort_index = 0; sort_index < sort_indices.size(); sort_index++) {
-      sorted_tuples.push_back(tuples[sort_indices[sort_index]]);
-    }
-    return Callback()(this, sorted_tuples);
+    tuples.Select(sort_indices);
+    return Callback()(this, tuples);
   }
 
   if (intermediate_relation_name_.empty()) {
@@ -187,25 +184,31 @@ bool QueryRunnerSort::ResultCallback(QueryRunner *child,
     }
   }
 
-  std::vector<size_t> sort_indices(tuples.size());
+  std::vector<size_t> sort_indices(tuples.Size());
   std::iota(sort_indices.begin(), sort_indices.end(), 0);
   std::sort(sort_indices.begin(), sort_indices.end(),
       CompareTuples(this, tuples));
 
-  for (auto sort_index = 0; sort_index < sort_indices.size(); sort_index++) {
-    Storage()->AppendTupleUsing(intermediate_relation_name_,
-        tuples[sort_indices[sort_index]], Storage()->MainMemorySize() - 1);
+  // The output block may be one the child scan still reads from, so the
+  // sorted tuples are copied out before it is cleared
+  tuples.Select(sort_indices);
+  std::vector<Tuple> sorted_tuples = tuples.Copy();
+  Storage()->ClearBlock(Storage()->MainMemorySize() - 1);
+  int previous_block_count = Storage()->RelationBlockSize(
+      intermediate_relation_);
+  for (auto& tuple : sorted_tuples) {
+    Storage()->AppendTupleUsing(intermediate_relation_, tuple,
+        Storage()->MainMemorySize() - 1);
   }
 
-  Storage()->PushLastBlock(intermediate_relation_name_, std::min(
+  Storage()->PushLastBlock(intermediate_relation_, std::min(
       memory_constraint_, Storage()->MainMemorySize() - 1));
-  int block_count = tuples.size() / tuples_per_block_;
-  int adjusted_block_count = tuples.size() % tuples_per_block_ ?
-      block_count + 1 : block_count;
 
-  sublist_size_list_.push_back(adjusted_block_count);
-  if (adjusted_block_count > memory_constraint_ ||
-      sublist_size_list_.size() > memory_constraint_) {
+  // A batch of compressed blocks takes more blocks once written plain, which
+  // the merge reads one at a time
+  sublist_size_list_.push_back(Storage()->RelationBlockSize(
+      intermediate_relation_) - previous_block_count);
+  if (sublist_size_list_.size() > memory_constraint_) {
     ERROR_MSG("Out of memory");
     return false;
   }
@@ -217,8 +220,8 @@ std::string QueryRunnerSort::CompareColumn() const {
   return sort_column_;
 }
 
-bool QueryRunnerSort::createIntermediateRelation(Tuple& tuple) {
-  Schema schema = tuple.getSchema();
+bool QueryRunnerSort::createIntermediateRelation(const Tuple& tuple) {
+  const Schema& schema = tuple.getSchemaRef();
   std::vector<std::string> field_names = schema.getFieldNames();
   std::vector<enum FIELD_TYPE> field_types = schema.getFieldTypes();
 
@@ -229,6 +232,11 @@ bool QueryRunnerSort::createIntermediateRelation(Tuple& tuple) {
   }
 
   MarkTemporaryRelation(intermediate_relation_name_);
+  intermediate_relation_ = Storage()->GetRelation(intermediate_relation_name_);
+
+  // Taken from the sublists, as a compressed input holds more per block
+  tuples_per_block_ =
+      intermediate_relation_->getSchemaRef().getTuplesPerBlock();
 
   return true;
 }
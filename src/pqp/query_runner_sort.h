@@ -18,15 +18,16 @@ class QueryRunnerSort : public QueryRunner {
 
   void PassScanParams(ScanParams params) final;
   bool HasSortNode() const final;
-  bool ResultCallback(QueryRunner *child, std::vector<Tuple>& tuples) final;
+  bool ResultCallback(QueryRunner *child, TupleBatch& tuples) final;
 
 private:
-  bool createIntermediateRelation(Tuple& tuple);
+  bool createIntermediateRelation(const Tuple& tuple);
   bool sublistIterated(std::vector<int>& sublist_size_list,
       std::vector<int>& sublist_block_indices);
 
   std::string column_name_;
   std::string intermediate_relation_name_;
+  Relation *intermediate_relation_;
   int block_size_;
   int tuples_per_block_;
   std::vector<int> sublist_size_list_;
@@ -0,0 +1,62 @@
+#include "pqp/tuple_batch.h"
+
+TupleBatch::TupleBatch() {
+}
+
+TupleBatch::TupleBatch(const std::vector<Tuple>& tuples) {
+  tuples_.reserve(tuples.size());
+  for (const Tuple& tuple : tuples) {
+    tuples_.push_back(&tuple);
+  }
+}
+
+TupleBatch::TupleBatch(const std::vector<Block *>& blocks) {
+  for (auto block : blocks) {
+    // Deleted tuples stay in their blocks as holes
+    for (const Tuple& tuple : *block) {
+      if (!tuple.isNull()) {
+        tuples_.push_back(&tuple);
+      }
+    }
+  }
+}
+
+bool TupleBatch::Empty() const {
+  return tuples_.empty();
+}
+
+size_t TupleBatch::Size() const {
+  return tuples_.size();
+}
+
+const Tuple& TupleBatch::operator[](size_t index) const {
+  return *tuples_[index];
+}
+
+TupleBatch::Iterator TupleBatch::begin() const {
+  return Iterator(tuples_.begin());
+}
+
+TupleBatch::Iterator TupleBatch::end() const {
+  return Iterator(tuples_.end());
+}
+
+void TupleBatch::Select(const std::vector<size_t>& positions) {
+  std::vector<const Tuple *> selected;
+  selected.reserve(positions.size());
+  for (auto position : positions) {
+    selected.push_back(tuples_[position]);
+  }
+
+  tuples_.swap(selected);
+}
+
+std::vector<Tuple> TupleBatch::Copy() const {
+  std::vector<Tuple> tuples;
+  tuples.reserve(tuples_.size());
+  for (auto tuple : tuples_) {
+    tuples.push_back(*tuple);
+  }
+
+  return tuples;
+}
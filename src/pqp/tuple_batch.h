@@ -0,0 +1,63 @@
+#ifndef SRC_PQP_TUPLE_BATCH_H
+#define SRC_PQP_TUPLE_BATCH_H
+
+#include <cstddef>
+#include <vector>
+
+#include "storage/storage_manager_headers.h"
+
+// The tuples a query runner hands to its parent in one callback. A batch only
+// points at the tuples: they stay in the main memory blocks of a scan or in
+// the vector of the runner that made them, and are valid until the callback
+// returns. Filtering or reordering a batch moves pointers, not tuples; a
+// runner that needs the tuples after the callback has to Copy() them.
+class TupleBatch {
+ public:
+  class Iterator {
+   public:
+    explicit Iterator(std::vector<const Tuple *>::const_iterator it)
+      : it_(it) {}
+
+    const Tuple& operator*() const { return **it_; }
+    const Tuple *operator->() const { return *it_; }
+    Iterator& operator++() { ++it_; return *this; }
+    bool operator!=(const Iterator& other) const { return it_ != other.it_; }
+
+   private:
+    std::vector<const Tuple *>::const_iterator it_;
+  };
+
+  TupleBatch();
+  explicit TupleBatch(const std::vector<Tuple>& tuples);
+  explicit TupleBatch(const std::vector<Block *>& blocks);
+
+  bool Empty() const;
+  size_t Size() const;
+  const Tuple& operator[](size_t index) const;
+  Iterator begin() const;
+  Iterator end() const;
+
+  // Keeps the tuples for which keep(tuple) returns true, in order
+  template <typename Predicate>
+  void Filter(Predicate keep);
+  // Keeps the tuples at the given positions, in the order of the positions
+  void Select(const std::vector<size_t>& positions);
+  std::vector<Tuple> Copy() const;
+
+ private:
+  std::vector<const Tuple *> tuples_;
+};
+
+template <typename Predicate>
+void TupleBatch::Filter(Predicate keep) {
+  size_t kept = 0;
+  for (size_t index = 0; index < tuples_.size(); index++) {
+    if (keep(*tuples_[index])) {
+      tuples_[kept++] = tuples_[index];
+    }
+  }
+
+  tuples_.resize(kept);
+}
+
+#endif // SRC_PQP_TUPLE_BATCH_H
@@ -3,134 +3,76 @@
 #include "base/debug.h"
 
 CompareTuples::CompareTuples(const QueryRunner *query_runner,
-      std::vector<Tuple> tuples)
-    : query_runner_(query_runner),
-      tuples_(tuples){ }
+      const TupleBatch& tuples)
+    : tuples_(tuples),
+      sort_column_(query_runner->CompareColumn()),
+      second_sort_column_(sort_column_) { }
+
+CompareTuples::CompareTuples(const std::string& first_column,
+      const std::string& second_column, const TupleBatch& tuples)
+    : tuples_(tuples),
+      sort_column_(first_column),
+      second_sort_column_(second_column) { }
 
 bool CompareTuples::operator()(size_t first_index, size_t second_index) const {
-  if (first_index >= tuples_.size() || second_index >= tuples_.size()) {
+  if (first_index >= tuples_.Size() || second_index >= tuples_.Size()) {
     DEBUG_MSG("");
     return false;
   }
 
-  Tuple first = tuples_[first_index];
-  Tuple second = tuples_[second_index];
+  return (*this)(tuples_[first_index], tuples_[second_index]);
+}
+
+bool CompareTuples::operator()(const Tuple& first,
+    const Tuple& second) const {
   if (first.isNull()) {
     return false;
   } else if (second.isNull()) {
     return true;
   }
 
-  std::string sort_column = query_runner_->CompareColumn();
-  Schema schema_first = first.getSchema();
-  Schema schema_second = second.getSchema();
-
-  if (sort_column == "*" || sort_column.empty()) {
-    int index = 0;
-    while (index < schema_first.getNumOfFields() &&
-        index < schema_second.getNumOfFields()) {
-      if (schema_first.getFieldType(index) == schema_second.getFieldType(
-          index)) {
-        sort_column = schema_first.getFieldName(index);
-        break;
-      }
-    }
-  }
-
-  if (sort_column.empty()) {
+  if (!bind(first, second)) {
     return false;
   }
 
-  if (schema_first.getFieldType(sort_column) == INT) {
-    int field_value_first = first.getField(sort_column).integer;
-    int field_value_second = second.getField(sort_column).integer;
-
-    return field_value_first < field_value_second;
-  } else if (schema_first.getFieldType(sort_column) == STR20) {
-    std::string field_value_first = *(first.getField(sort_column).str);
-    std::string field_value_second = *(second.getField(sort_column).str);
-
-    if (field_value_first == "NULL") {
-      field_value_first.clear();
-    }
-
-    if (field_value_second == "NULL") {
-      field_value_second.clear();
-    }
-
-    return field_value_first < field_value_second;
-  }
+  return first_column_.Less(first, second_column_, second);
+}
 
-  return true;
+bool CompareTuples::IsFieldEqual(size_t first_index,
+    size_t second_index) const {
+  return IsFieldEqual(tuples_[first_index], tuples_[second_index]);
 }
 
-bool CompareTuples::operator()(Tuple first, Tuple second) const {
-  if (first.isNull()) {
+bool CompareTuples::IsFieldEqual(const Tuple& first,
+    const Tuple& second) const {
+  if (first.isNull() || second.isNull()) {
     return false;
-  } else if (second.isNull()) {
-    return true;
-  }
-
-  std::string sort_column = query_runner_->CompareColumn();
-  Schema schema_first = first.getSchema();
-  Schema schema_second = second.getSchema();
-
-  if (sort_column == "*" || sort_column.empty()) {
-    int index = 0;
-    while (index < schema_first.getNumOfFields() &&
-        index < schema_second.getNumOfFields()) {
-      if (schema_first.getFieldType(index) == schema_second.getFieldType(
-          index)) {
-        sort_column = schema_first.getFieldName(index);
-        break;
-      }
-    }
   }
 
-  if (sort_column.empty()) {
+  if (!bind(first, second)) {
     return false;
   }
 
-  if (schema_first.getFieldType(sort_column) == INT) {
-    int field_value_first = first.getField(sort_column).integer;
-    int field_value_second = second.getField(sort_column).integer;
-
-    return field_value_first < field_value_second;
-  } else if (schema_first.getFieldType(sort_column) == STR20) {
-    std::string field_value_first = *(first.getField(sort_column).str);
-    std::string field_value_second = *(second.getField(sort_column).str);
-
-    if (field_value_first == "NULL") {
-      field_value_first.clear();
-    }
-
-    if (field_value_second == "NULL") {
-      field_value_second.clear();
-    }
-
-    return field_value_first < field_value_second;
-  }
-
-  return true;
+  return first_column_.Equal(first, second_column_, second);
 }
 
-bool CompareTuples::IsFieldEqual(size_t first_index,
-    size_t second_index) const {
-  Tuple first = tuples_[first_index];
-  Tuple second = tuples_[second_index];
-
-  if (first.isNull() || second.isNull()) {
-    return false;
+// Private methods
+bool CompareTuples::bind(const Tuple& first, const Tuple& second) const {
+  const Schema& schema_first = first.getSchemaRef();
+  const Schema& schema_second = second.getSchemaRef();
+  if (first_column_.IsBoundTo(schema_first) &&
+      second_column_.IsBoundTo(schema_second)) {
+    return true;
   }
 
-  std::string sort_column = query_runner_->CompareColumn();
-  Schema schema_first = first.getSchema();
-  Schema schema_second = second.getSchema();
-
+  // Without a column the tuples are ordered by the first field both have in
+  // common
+  std::string sort_column = sort_column_;
+  std::string second_sort_column = second_sort_column_;
   if (sort_column == "*" || sort_column.empty()) {
-    int index = 0;
-    while (index < schema_first.getNumOfFields() &&
-        index < schema_second.getNumOfFields()) {
+    sort_column.clear();
+    for (int index = 0; index < schema_first.getNumOfFields() &&
+        index < schema_second.getNumOfFields(); index++) {
       if (schema_first.getFieldType(index) == schema_second.getFieldType(
           index)) {
         sort_column = schema_first.getFieldName(index);
@@ -143,19 +85,17 @@ bool CompareTuples::IsFieldEqual(size_t first_index,
     return false;
   }
 
-  if (schema_first.getFieldType(sort_column) == INT) {
-    int field_value_first = first.getField(sort_column).integer;
-    int field_value_second = second.getField(sort_column).integer;
-
-    return field_value_first == field_value_second;
-  } else if (schema_first.getFieldType(sort_column) == STR20) {
-    std::string field_value_first = *(first.getField(sort_column).str);
-    std::string field_value_second = *(second.getField(sort_column).str);
+  if (second_sort_column == "*" || second_sort_column.empty()) {
+    second_sort_column = sort_column;
+  }
 
-    return field_value_first == field_value_second;
+  if (!first_column_.Bind(schema_first, sort_column) ||
+      !second_column_.Bind(schema_second, second_sort_column)) {
+    DEBUG_MSG("Unable to bind sort column " << sort_column);
+    return false;
   }
 
-  return false;
+  return true;
 }
 
 bool operator ==(const Tuple &first, const Tuple &second) {
@@ -167,8 +107,8 @@ bool operator ==(const Tuple &first, const Tuple &second) {
     return false;
   }
 
-  Schema schema_first = first.getSchema();
-  Schema schema_second = second.getSchema();
+  const Schema& schema_first = first.getSchemaRef();
+  const Schema& schema_second = second.getSchemaRef();
   if (!(schema_first == schema_second)) {
     return false;
   }
@@ -4,18 +4,33 @@
 #include <string>
 #include <vector>
 
+#include "pqp/column_accessor.h"
 #include "pqp/query_runner.h"
+#include "pqp/tuple_batch.h"
 #include "storage/storage_manager_headers.h"
 
 typedef struct CompareTuples {
-  CompareTuples(const QueryRunner *query_runner, std::vector<Tuple> tuples);
+  // The batch is not copied and has to outlive the comparator. The compare
+  // column of the runner is bound to the schemas of the first two tuples
+  // compared and only bound again when a tuple of another schema comes by.
+  CompareTuples(const QueryRunner *query_runner, const TupleBatch& tuples);
+  // Compares the first tuple on one column and the second on another, as
+  // the two sides of a join
+  CompareTuples(const std::string& first_column,
+      const std::string& second_column, const TupleBatch& tuples);
   bool operator()(size_t first_index, size_t second_index) const;
-  bool operator()(Tuple first, Tuple second) const;
+  bool operator()(const Tuple& first, const Tuple& second) const;
   bool IsFieldEqual(size_t first_index, size_t second_index) const;
+  bool IsFieldEqual(const Tuple& first, const Tuple& second) const;
 
  private:
-  const QueryRunner *query_runner_;
-  const std::vector<Tuple> tuples_;
+  bool bind(const Tuple& first, const Tuple& second) const;
+
+  const TupleBatch& tuples_;
+  std::string sort_column_;
+  std::string second_sort_column_;
+  mutable ColumnAccessor first_column_;
+  mutable ColumnAccessor second_column_;
 } CompareTuples;
 
 bool operator ==(const Tuple &first, const Tuple &second);
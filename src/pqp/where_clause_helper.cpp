@@ -1,8 +1,16 @@
 #include "pqp/where_clause_helper.h"
 
 #include "base/debug.h"
+#include "base/tokenizer.h"
 #include "storage/storage_adapter.h"
 
+// Up to 18 digits, which a long long holds whatever they are
+bool inline IsNumber(const std::string& value) {
+  std::string digits =
+      value.size() > 1 && value[0] == '-' ? value.substr(1) : value;
+  return digits.size() <= 18 && Tokenizer::IsInteger(digits);
+}
+
 WhereClauseHelper::WhereClauseHelper() {
   storage_adapter_ = StorageAdapter::Get();
 }
@@ -28,7 +36,7 @@ bool WhereClauseHelper::Initialize(SqlNode *where_node) {
   return true;
 }
 
-bool WhereClauseHelper::HandleSearchCondition(Tuple *tuple) {
+bool WhereClauseHelper::HandleSearchCondition(const Tuple *tuple) {
   current_tuple_ = tuple;
 
   std::vector<SqlNode *> children = where_node_->Children();
@@ -40,24 +48,32 @@ bool WhereClauseHelper::HandleSearchCondition(Tuple *tuple) {
   return search_predicate;
 }
 
-bool WhereClauseHelper::ValueFromTuple(const std::string attribute_name,
-    std::string& field_value, SqlErrors::Type& error_code) {
-  if (current_tuple_->getSchema().getFieldType(attribute_name) == INT) {
-    int value = current_tuple_->getField(attribute_name).integer;
-    field_value = std::to_string(value);
-    if (value == -1) {
-      field_value = "NULL";
-    }
-  } else if (current_tuple_->getSchema().getFieldType(
-        attribute_name) == STR20) {
-    field_value = *(current_tuple_->getField(attribute_name).str);
-  } else {
+const ColumnAccessor *WhereClauseHelper::BoundColumn(
+    SqlNode *column_name) const {
+  auto it = column_accessors_.find(column_name);
+  if (it == column_accessors_.end() ||
+      !it->second.IsBoundTo(current_tuple_->getSchemaRef())) {
+    return nullptr;
+  }
+
+  return &it->second;
+}
+
+const ColumnAccessor *WhereClauseHelper::BindColumn(SqlNode *column_name,
+    const std::string& attribute_name, SqlErrors::Type& error_code) {
+  ColumnAccessor& column = column_accessors_[column_name];
+  if (!column.Bind(current_tuple_->getSchemaRef(), attribute_name)) {
     DEBUG_MSG("Column name invalid for the table");
     error_code = SqlErrors::INVALID_COLUMN_NAME;
-    return false;
+    return nullptr;
   }
 
-  return true;
+  return &column;
+}
+
+std::string WhereClauseHelper::ValueFromTuple(
+    const ColumnAccessor& column) const {
+  return column.Value(*current_tuple_);
 }
 
 // Private methods
@@ -77,7 +93,7 @@ bool WhereClauseHelper::handleBooleanTerm(SqlNode *boolean_term) {
   return boolean_term_predicate;
 }
 
-bool WhereClauseHelper::HandleBooleanFactor(Tuple *tuple,
+bool WhereClauseHelper::HandleBooleanFactor(const Tuple *tuple,
     SqlNode *boolean_factor) {
   if (tuple) {
     current_tuple_ = tuple;
@@ -87,13 +103,24 @@ bool WhereClauseHelper::HandleBooleanFactor(Tuple *tuple,
   std::string expression_right = handleExpression(boolean_factor->Child(1));
 
   std::string comp_op = boolean_factor->Data();
-  if (comp_op == "<") {
-    return expression_left < expression_right;
-  } else if (comp_op == ">") {
-    return expression_left > expression_right;
-  } else {
+  if (comp_op != "<" && comp_op != ">") {
     return expression_left == expression_right;
   }
+
+  // Nothing is less or greater than NULL, integers compare by value and
+  // strings by their characters
+  if (expression_left == "NULL" || expression_right == "NULL") {
+    return false;
+  }
+
+  if (IsNumber(expression_left) && IsNumber(expression_right)) {
+    long long left = std::stoll(expression_left);
+    long long right = std::stoll(expression_right);
+    return comp_op == "<" ? left < right : left > right;
+  }
+
+  return comp_op == "<" ? expression_left < expression_right :
+      expression_left > expression_right;
 }
 
 std::string WhereClauseHelper::handleExpression(SqlNode *expression) {
@@ -106,6 +133,9 @@ std::string WhereClauseHelper::handleExpression(SqlNode *expression) {
 
   std::string term_right = handleTerm(children[1]);
   std::string data_operator = expression->Data();
+  if (!IsNumber(term_left) || !IsNumber(term_right)) {
+    return "NULL";
+  }
 
   long long result;
   if (data_operator == "+") {
@@ -1,10 +1,12 @@
 #ifndef SRC_PQP_WHERE_CLAUSE_HELPER_H_
 #define SRC_PQP_WHERE_CLAUSE_HELPER_H_
 
+#include <map>
 #include <string>
 
 #include "base/sql_errors.h"
 #include "parser/sql_node.h"
+#include "pqp/column_accessor.h"
 #include "storage/storage_manager_headers.h"
 
 class StorageAdapter;
@@ -16,14 +18,19 @@ class WhereClauseHelper {
 
  protected:
   bool Initialize(SqlNode *where_node);
-  virtual bool Evaluate(Tuple *tuple, SqlErrors::Type& error_code) = 0;
+  virtual bool Evaluate(const Tuple *tuple, SqlErrors::Type& error_code) = 0;
 
   virtual std::string HandleColumnName(SqlNode *column_name) = 0;
-  bool HandleSearchCondition(Tuple *tuple);
-  virtual bool HandleBooleanFactor(Tuple *tuple,
+  bool HandleSearchCondition(const Tuple *tuple);
+  virtual bool HandleBooleanFactor(const Tuple *tuple,
       SqlNode *boolean_factor);
-  bool ValueFromTuple(const std::string attribute_name,
-      std::string& field_value, SqlErrors::Type& error_code);
+  // Column names are resolved once per schema: HandleColumnName() asks for
+  // the accessor bound to the schema of the current tuple and only works out
+  // the attribute name and binds it when there is none.
+  const ColumnAccessor *BoundColumn(SqlNode *column_name) const;
+  const ColumnAccessor *BindColumn(SqlNode *column_name,
+      const std::string& attribute_name, SqlErrors::Type& error_code);
+  std::string ValueFromTuple(const ColumnAccessor& column) const;
 
   StorageAdapter *Storage() const { return storage_adapter_; }
   SqlNode *RootNode() const { return where_node_; }
@@ -34,7 +41,8 @@ class WhereClauseHelper {
   std::string handleTerm(SqlNode *term);
 
   SqlNode *where_node_;
-  Tuple *current_tuple_;
+  const Tuple *current_tuple_;
+  std::map<SqlNode *, ColumnAccessor> column_accessors_;
   StorageAdapter *storage_adapter_;
 };
 
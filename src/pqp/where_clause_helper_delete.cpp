@@ -4,7 +4,8 @@
 #include "storage/storage_adapter.h"
 
 WhereClauseHelperDelete::WhereClauseHelperDelete()
-  : error_code_(SqlErrors::NO_ERROR) {
+  : error_code_(SqlErrors::NO_ERROR),
+    relation_(nullptr) {
 }
 
 WhereClauseHelperDelete::~WhereClauseHelperDelete() {
@@ -14,91 +15,99 @@ WhereClauseHelperDelete::~WhereClauseHelperDelete() {
 bool WhereClauseHelperDelete::Initialize(SqlNode *where_node,
     std::string table_name) {
   table_name_ = table_name;
+  relation_ = Storage()->GetRelation(table_name_);
+  if (relation_ == nullptr) {
+    DEBUG_MSG("Invalid relation name: " << table_name_);
+    return false;
+  }
 
   return WhereClauseHelper::Initialize(where_node);
 }
 
 bool WhereClauseHelperDelete::Execute(SqlErrors::Type& error_code) {
+  // Deleted tuples are nulled where they are and only the blocks that
+  // changed are written back; the holes are filled by later inserts
   std::vector<Block *> blocks;
-  int relation_start_index = 0;
+  std::vector<int> emptied_blocks;
   int num_blocks = Storage()->MainMemorySize();
+  int block_count = Storage()->RelationBlockSize(relation_);
+  int used_block_count = 0;
+
+  for (int relation_start_index = 0; relation_start_index < block_count;
+      relation_start_index += blocks.size()) {
+    if (!Storage()->ReadRelationBlocks(relation_, relation_start_index, 0,
+        num_blocks, blocks)) {
+      DEBUG_MSG("");
+      error_code = SqlErrors::UNKNOWN_ERROR;
+      return false;
+    }
 
-  int empty_block_index = 0;
-  int relation_insert_index = 0;
-  int memory_start_index = 0;
-  while (Storage()->ReadRelationBlocks(table_name_, relation_start_index,
-      memory_start_index, num_blocks, blocks)) {
-    Block *empty_block = blocks[empty_block_index];
-    for (auto block : blocks) {
-      std::vector<Tuple> modified_tuples;
-      std::vector<Tuple> tuples = block->getTuples();
-      block->clear();
-
-      for (auto tuple : tuples) {
-        bool evaluate_result = Evaluate(&tuple, error_code);
-        if (error_code != SqlErrors::NO_ERROR) {
-          DEBUG_MSG("");
-          return false;
+    std::vector<bool> changed(blocks.size(), false);
+    for (int index = 0; index < blocks.size(); index++) {
+      Block *block = blocks[index];
+      std::vector<int> offsets;
+      int offset = 0;
+      for (const Tuple& tuple : *block) {
+        if (!tuple.isNull()) {
+          bool evaluate_result = Evaluate(&tuple, error_code);
+          if (error_code != SqlErrors::NO_ERROR) {
+            DEBUG_MSG("");
+            return false;
+          }
+
+          if (evaluate_result) {
+            offsets.push_back(offset);
+          }
         }
 
-        if (!evaluate_result) {
-          modified_tuples.push_back(tuple);
-        }
+        offset++;
       }
 
-      int tuple_index = 0;
-      while (tuple_index < modified_tuples.size()) {
-        for (; tuple_index < modified_tuples.size() && !empty_block->isFull();
-            tuple_index++) {
-          empty_block->appendTuple(modified_tuples[tuple_index]);
-        }
-
-        if (empty_block->isFull() && empty_block_index < blocks.size() - 1) {
-          empty_block = blocks[++empty_block_index];
-        }
+      for (auto deleted_offset : offsets) {
+        block->nullTuple(deleted_offset);
       }
-    }
 
-    int insert_blocks_size = empty_block->isFull() ?
-        empty_block_index + 1 : empty_block_index;
-    if (insert_blocks_size > 0) {
-      DEBUG_MSG("Inserting into " << table_name_ << " from " <<
-          relation_start_index << " a total of " << insert_blocks_size);
-      Storage()->InsertBlocksToRelation(table_name_, 0, relation_insert_index,
-          insert_blocks_size);
+      if (block->getNumTuples() > 0) {
+        used_block_count = relation_start_index + index + 1;
+        changed[index] = !offsets.empty();
+      } else if (!offsets.empty()) {
+        // Written at the end, unless it is cut off with the trailing ones
+        emptied_blocks.push_back(relation_start_index + index);
+      }
     }
 
-    relation_start_index += blocks.size();
-    relation_insert_index += insert_blocks_size;
+    for (int index = 0; index < blocks.size();) {
+      int run = 0;
+      while (index + run < blocks.size() && changed[index + run]) {
+        run++;
+      }
 
-    Block *temp_block = nullptr;
-    if (!empty_block->isFull() && !empty_block->isEmpty()) {
-      temp_block = blocks[empty_block_index];
-    }
+      if (run > 0 && !Storage()->InsertBlocksToRelation(relation_, index,
+          relation_start_index + index, run)) {
+        DEBUG_MSG("");
+        error_code = SqlErrors::UNKNOWN_ERROR;
+        return false;
+      }
 
-    blocks.clear();
-    if (temp_block != nullptr) {
-      blocks.push_back(temp_block);
-      Storage()->SetMainMemoryBlock(0, temp_block);
+      index += run > 0 ? run : 1;
     }
+  }
 
-    memory_start_index = blocks.size();
-    empty_block_index = blocks.size();
-
-    if (relation_start_index >= Storage()->RelationBlockSize(table_name_)) {
-      if (!blocks.empty()) {
-        Storage()->InsertBlocksToRelation(table_name_, 0,
-            relation_insert_index++, 1);
-      }
-    }
+  if (!writeEmptyBlocks(emptied_blocks, used_block_count)) {
+    DEBUG_MSG("");
+    error_code = SqlErrors::UNKNOWN_ERROR;
+    return false;
   }
 
-  Storage()->DeleteTuples(table_name_, relation_insert_index);
+  if (used_block_count < block_count) {
+    DEBUG_MSG("Cutting " << table_name_ << " at block " << used_block_count);
+    Storage()->DeleteTuples(table_name_, used_block_count);
+  }
 
   return true;
 }
 
-bool WhereClauseHelperDelete::Evaluate(Tuple *tuple,
+bool WhereClauseHelperDelete::Evaluate(const Tuple *tuple,
     SqlErrors::Type& error_code) {
   if (tuple == nullptr) {
     error_code = SqlErrors::UNKNOWN_ERROR;
@@ -116,8 +125,43 @@ bool WhereClauseHelperDelete::Evaluate(Tuple *tuple,
 }
 
 // Private methods
+bool WhereClauseHelperDelete::writeEmptyBlocks(
+    const std::vector<int>& block_indices, const int used_block_count) {
+  if (block_indices.empty() || block_indices.front() >= used_block_count) {
+    return true;
+  }
+
+  // A block of holes, written wherever all the tuples of a block were deleted
+  Block *block = Storage()->MainMemoryBlock(0);
+  Tuple tuple = relation_->createTuple();
+  block->clear();
+  while (!block->isFull()) {
+    block->appendTuple(tuple);
+  }
+
+  block->nullTuples();
+  for (auto block_index : block_indices) {
+    if (block_index >= used_block_count) {
+      break;
+    }
+
+    if (!Storage()->InsertBlocksToRelation(relation_, 0, block_index, 1)) {
+      DEBUG_MSG("");
+      return false;
+    }
+  }
+
+  block->clear();
+  return true;
+}
+
 std::string WhereClauseHelperDelete::HandleColumnName(
     SqlNode *column_name) {
+  const ColumnAccessor *column = BoundColumn(column_name);
+  if (column != nullptr) {
+    return ValueFromTuple(*column);
+  }
+
   std::vector<SqlNode *> children = column_name->Children();
   if (children.size() == 2 && table_name_ != children[0]->Data()) {
     DEBUG_MSG("WHERE clause contains invalid table name");
@@ -138,7 +182,11 @@ std::string WhereClauseHelperDelete::HandleColumnName(
     return std::string();
   }
 
-  std::string field_value;
-  ValueFromTuple(attribute_name, field_value, error_code_);
-  return field_value;
+  column = BindColumn(column_name, attribute_name, error_code_);
+  if (column == nullptr) {
+    DEBUG_MSG("");
+    return std::string();
+  }
+
+  return ValueFromTuple(*column);
 }
@@ -2,6 +2,7 @@
 #define SRC_PQP_WHERE_CLAUSE_HELPER_DELETE_H_
 
 #include <string>
+#include <vector>
 
 #include "base/sql_errors.h"
 #include "parser/sql_node.h"
@@ -19,11 +20,14 @@ class WhereClauseHelperDelete : public WhereClauseHelper {
   bool Execute(SqlErrors::Type& error_code);
 
  private:
-  bool Evaluate(Tuple *tuple, SqlErrors::Type& error_code) override;
+  bool Evaluate(const Tuple *tuple, SqlErrors::Type& error_code) override;
   virtual std::string HandleColumnName(SqlNode *column_name) override;
+  bool writeEmptyBlocks(const std::vector<int>& block_indices,
+      const int used_block_count);
 
   SqlErrors::Type error_code_;
   std::string table_name_;
+  Relation *relation_;
 };
 
 #endif // SRC_PQP_WHERE_CLAUSE_HELPER_DELETE_H_
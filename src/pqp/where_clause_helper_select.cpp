@@ -8,11 +8,15 @@
 
 WhereClauseHelperSelect::WhereClauseHelperSelect(HelperType type)
     : type_(type),
-      error_code_(SqlErrors::NO_ERROR) {
+      error_code_(SqlErrors::NO_ERROR),
+      first_tuple_(nullptr),
+      second_tuple_(nullptr) {
 }
 
 WhereClauseHelperSelect::~WhereClauseHelperSelect() {
-
+  for (auto join_factor : join_factors_) {
+    delete join_factor;
+  }
 }
 
 bool WhereClauseHelperSelect::Initialize(SqlNode *where_node,
@@ -29,7 +33,7 @@ bool WhereClauseHelperSelect::Initialize(SqlNode *where_node,
   return return_value;
 }
 
-bool WhereClauseHelperSelect::Evaluate(Tuple *tuple,
+bool WhereClauseHelperSelect::Evaluate(const Tuple *tuple,
     SqlErrors::Type& error_code) {
   if (tuple == nullptr) {
     error_code = SqlErrors::UNKNOWN_ERROR;
@@ -53,11 +57,27 @@ bool WhereClauseHelperSelect::Evaluate(Tuple *tuple,
   return condition_result;
 }
 
+bool WhereClauseHelperSelect::EvaluatePair(const Tuple& first,
+    const std::string& first_table, const Tuple& second,
+    const std::string& second_table, SqlErrors::Type& error_code) {
+  first_tuple_ = &first;
+  second_tuple_ = &second;
+  first_table_ = first_table;
+  second_table_ = second_table;
+
+  bool condition_result = Evaluate(&first, error_code);
+  first_tuple_ = nullptr;
+  second_tuple_ = nullptr;
+  return condition_result;
+}
+
 void WhereClauseHelperSelect::OptimizationCandidates(
     PushCandidates& push_candidates,
-    JoinAttributes& join_attributes) const {
+    JoinAttributes& join_attributes,
+    RangeJoinAttributes& range_join_attributes) const {
   push_candidates.clear();
   join_attributes.clear();
+  range_join_attributes.clear();
 
   if (RootNode()->ChildrenCount() != 1) {
     DEBUG_MSG("");
@@ -70,27 +90,180 @@ void WhereClauseHelperSelect::OptimizationCandidates(
 
   std::vector<SqlNode *> children = RootNode()->Children();
   return optimizationCandidatesBooleanTerm(RootNode()->Child(0),
-      push_candidates, join_attributes);
+      push_candidates, join_attributes, range_join_attributes);
+}
+
+void WhereClauseHelperSelect::DropJoinFactors() {
+  if (RootNode() == nullptr || RootNode()->ChildrenCount() != 1) {
+    DEBUG_MSG("");
+    return;
+  }
+
+  SqlNode *boolean_term = RootNode()->Child(0);
+  for (auto boolean_factor : boolean_term->Children()) {
+    JoinAttributes join_attributes;
+    bool joinable = false;
+    bool optimizable = false;
+    std::string optimizable_table_name;
+    optimizationCandidatesBooleanFactor(boolean_factor, join_attributes,
+        joinable, optimizable, optimizable_table_name);
+    if (joinable) {
+      join_factors_.push_back(boolean_factor);
+      boolean_term->RemoveChild(boolean_factor);
+    }
+  }
+}
+
+double WhereClauseHelperSelect::Selectivity() const {
+  if (RootNode() == nullptr) {
+    return 1;
+  }
+
+  if (type_ ==
+      WhereClauseHelperSelect::WHERE_CLAUSE_HELPER_TYPE_BOOLEAN_FACTOR) {
+    return booleanFactorSelectivity(RootNode());
+  }
+
+  // The factors of a term are ANDed and the terms ORed
+  double selectivity = 0;
+  for (auto boolean_term : RootNode()->Children()) {
+    double term_selectivity = 1;
+    for (auto boolean_factor : boolean_term->Children()) {
+      term_selectivity *= booleanFactorSelectivity(boolean_factor);
+    }
+
+    selectivity += term_selectivity;
+  }
+
+  return std::min(selectivity, 1.0);
+}
+
+void WhereClauseHelperSelect::ReferencedTables(
+    std::vector<std::string>& table_names) const {
+  table_names.clear();
+  if (RootNode() != nullptr) {
+    referencedTables(RootNode(), table_names);
+  }
+}
+
+void WhereClauseHelperSelect::ReferencedColumns(
+    std::vector<std::string>& column_names) const {
+  column_names.clear();
+  if (RootNode() != nullptr) {
+    referencedColumns(RootNode(), column_names);
+  }
 }
 
 // Private methods
 std::string WhereClauseHelperSelect::HandleColumnName(
     SqlNode *column_name) {
+  if (second_tuple_ != nullptr) {
+    return pairColumnValue(column_name);
+  }
+
+  const ColumnAccessor *column = BoundColumn(column_name);
+  if (column == nullptr) {
+    std::string column_name_string, table_name, attribute_name;
+    column_name->ColumnName(column_name_string);
+
+    Tokenizer::SplitIntoTwo(column_name_string, '.', table_name,
+        attribute_name);
+    if (attribute_name.empty()) {
+      attribute_name = table_name;
+    }
+
+    if (table_list_.size() != 1) {
+      attribute_name = column_name_string;
+    }
+
+    column = BindColumn(column_name, attribute_name, error_code_);
+    if (column == nullptr) {
+      DEBUG_MSG("");
+      return std::string();
+    }
+  }
+
+  return ValueFromTuple(*column);
+}
+
+std::string WhereClauseHelperSelect::pairColumnValue(SqlNode *column_name) {
+  ColumnAccessor& first_column = first_columns_[column_name];
+  if (first_column.IsBoundTo(first_tuple_->getSchemaRef())) {
+    return first_column.Value(*first_tuple_);
+  }
+
+  ColumnAccessor& second_column = second_columns_[column_name];
+  if (second_column.IsBoundTo(second_tuple_->getSchemaRef())) {
+    return second_column.Value(*second_tuple_);
+  }
+
   std::string column_name_string, table_name, attribute_name;
   column_name->ColumnName(column_name_string);
+  Tokenizer::SplitIntoTwo(column_name_string, '.', table_name,
+      attribute_name);
 
-  Tokenizer::SplitIntoTwo(column_name_string, '.', table_name, attribute_name);
-  if (attribute_name.empty()) {
-    attribute_name = table_name;
+  if (first_column.Bind(first_tuple_->getSchemaRef(),
+      first_table_ == table_name ? attribute_name : column_name_string)) {
+    return first_column.Value(*first_tuple_);
   }
 
-  if (table_list_.size() != 1) {
-    attribute_name = column_name_string;
+  if (second_column.Bind(second_tuple_->getSchemaRef(),
+      second_table_ == table_name ? attribute_name : column_name_string)) {
+    return second_column.Value(*second_tuple_);
   }
 
-  std::string field_value;
-  ValueFromTuple(attribute_name, field_value, error_code_);
-  return field_value;
+  DEBUG_MSG("Column name invalid for the tables: " << column_name_string);
+  error_code_ = SqlErrors::INVALID_COLUMN_NAME;
+  return std::string();
+}
+
+void WhereClauseHelperSelect::referencedTables(SqlNode *node,
+    std::vector<std::string>& table_names) const {
+  if (node->Type() != SqlNode::NODE_TYPE_COLUMN_NAME) {
+    for (auto child : node->Children()) {
+      referencedTables(child, table_names);
+    }
+
+    return;
+  }
+
+  std::string column_name, table_name, attribute_name;
+  if (!node->ColumnName(column_name)) {
+    DEBUG_MSG("");
+    return;
+  }
+
+  Tokenizer::SplitIntoTwo(column_name, '.', table_name, attribute_name);
+  if (attribute_name.empty() && table_list_.size() == 1) {
+    table_name = table_list_[0];
+  }
+
+  if (std::find(table_names.begin(), table_names.end(), table_name) ==
+      table_names.end()) {
+    table_names.push_back(table_name);
+  }
+}
+
+void WhereClauseHelperSelect::referencedColumns(SqlNode *node,
+    std::vector<std::string>& column_names) const {
+  if (node->Type() != SqlNode::NODE_TYPE_COLUMN_NAME) {
+    for (auto child : node->Children()) {
+      referencedColumns(child, column_names);
+    }
+
+    return;
+  }
+
+  std::string column_name;
+  if (!node->ColumnName(column_name)) {
+    DEBUG_MSG("");
+    return;
+  }
+
+  if (std::find(column_names.begin(), column_names.end(), column_name) ==
+      column_names.end()) {
+    column_names.push_back(column_name);
+  }
 }
 
 bool WhereClauseHelperSelect::isValidSearchCondition() const {
@@ -184,8 +357,11 @@ bool WhereClauseHelperSelect::isValidColumnName(SqlNode *column_node) const {
 void WhereClauseHelperSelect::optimizationCandidatesBooleanTerm(
     SqlNode *boolean_term,
     PushCandidates& push_candidates,
-    JoinAttributes& join_attributes) const {
-  bool joinable = true;
+    JoinAttributes& join_attributes,
+    RangeJoinAttributes& range_join_attributes) const {
+  // The equalities are join predicates whatever else the term holds, which
+  // is checked once the tables are joined
+  bool range_joinable = true;
   std::vector<SqlNode *> children = boolean_term->Children();
 
   for (auto boolean_factor : children) {
@@ -194,7 +370,10 @@ void WhereClauseHelperSelect::optimizationCandidatesBooleanTerm(
     std::string optimizable_table_name;
     optimizationCandidatesBooleanFactor(boolean_factor, join_attributes,
         node_joinable, node_optimizable, optimizable_table_name);
-    joinable = joinable && (node_joinable || node_optimizable);
+    bool node_range_joinable = !node_optimizable && !node_joinable &&
+        tryRangeJoinFactor(boolean_factor, range_join_attributes);
+    range_joinable = range_joinable &&
+        (node_range_joinable || node_optimizable);
 
     if (node_optimizable) {
       push_candidates.push_back(std::make_pair(
@@ -203,8 +382,8 @@ void WhereClauseHelperSelect::optimizationCandidatesBooleanTerm(
     }
   }
 
-  if (!joinable) {
-    join_attributes.clear();
+  if (!range_joinable) {
+    range_join_attributes.clear();
   }
 }
 
@@ -222,7 +401,10 @@ void WhereClauseHelperSelect::optimizationCandidatesBooleanFactor(
   bool right_joinable = tryJoinExpression(boolean_factor->Child(1),
       join_candidate_right, has_column_right);
 
-  if (has_column_left != has_column_right) {
+  // A factor using the columns of one table is checked below the joins
+  std::vector<std::string> table_names;
+  referencedTables(boolean_factor, table_names);
+  if (has_column_left != has_column_right && table_names.size() == 1) {
     optimizable = true;
     optimizable_table_name =
         has_column_left ? join_candidate_left : join_candidate_right;
@@ -242,8 +424,7 @@ void WhereClauseHelperSelect::optimizationCandidatesBooleanFactor(
   Tokenizer::SplitIntoTwo(join_candidate_right, '.',
       table_name_right, attribute_name_right);
 
-  if (attribute_name_left != attribute_name_right ||
-      table_name_left == table_name_right) {
+  if (table_name_left == table_name_right) {
     DEBUG_MSG("");
     return;
   }
@@ -267,26 +448,127 @@ void WhereClauseHelperSelect::optimizationCandidatesBooleanFactor(
   joinable = true;
 }
 
-bool WhereClauseHelperSelect::tryJoinExpression(SqlNode *expression,
-    std::string& join_candidate, bool& has_column) const {
-  if (expression->ChildrenCount() != 1) {
+bool WhereClauseHelperSelect::tryRangeJoinFactor(SqlNode *boolean_factor,
+    RangeJoinAttributes& range_join_attributes) const {
+  std::string comp_op = boolean_factor->Data();
+  if (comp_op != "<" && comp_op != ">") {
     DEBUG_MSG("");
     return false;
   }
 
-  SqlNode *term = expression->Child(0);
-  if (term->ChildrenCount() != 1) {
+  std::string column_left, column_right;
+  long long offset_left = 0, offset_right = 0;
+  if (!tryRangeJoinExpression(boolean_factor->Child(0),
+          column_left, offset_left) ||
+      !tryRangeJoinExpression(boolean_factor->Child(1),
+          column_right, offset_right)) {
     DEBUG_MSG("");
     return false;
   }
 
-  has_column = true;
+  std::string table_name_left, attribute_name_left;
+  Tokenizer::SplitIntoTwo(column_left, '.',
+      table_name_left, attribute_name_left);
+
+  std::string table_name_right, attribute_name_right;
+  Tokenizer::SplitIntoTwo(column_right, '.',
+      table_name_right, attribute_name_right);
+
+  auto position_left = std::find(table_list_.begin(), table_list_.end(),
+      table_name_left);
+  auto position_right = std::find(table_list_.begin(), table_list_.end(),
+      table_name_right);
+  if (position_left == table_list_.end() ||
+      position_right == table_list_.end() ||
+      position_left == position_right) {
+    DEBUG_MSG("");
+    return false;
+  }
 
-  SqlNode *column_name = term->Child(0);
-  if (!column_name->ColumnName(join_candidate)) {
+  FIELD_TYPE field_type_left, field_type_right;
+  if (!Storage()->AttributeType(table_name_left, attribute_name_left,
+          field_type_left) ||
+      !Storage()->AttributeType(table_name_right, attribute_name_right,
+          field_type_right) ||
+      field_type_left != INT || field_type_right != INT) {
+    DEBUG_MSG("");
+    return false;
+  }
+
+  // left + offset_left < right + offset_right is left - right < offset, and
+  // the columns swap sides when the right one is of the first table
+  RangeJoinAttribute range_join_attribute;
+  range_join_attribute.first_ = column_left;
+  range_join_attribute.second_ = column_right;
+  range_join_attribute.less_ = comp_op == "<";
+  range_join_attribute.offset_ = offset_right - offset_left;
+  if (position_right < position_left) {
+    std::swap(range_join_attribute.first_, range_join_attribute.second_);
+    range_join_attribute.less_ = !range_join_attribute.less_;
+    range_join_attribute.offset_ = -range_join_attribute.offset_;
+  }
+
+  range_join_attributes.push_back(range_join_attribute);
+  return true;
+}
+
+bool WhereClauseHelperSelect::tryJoinExpression(SqlNode *expression,
+    std::string& join_candidate, bool& has_column) const {
+  // Only a single column joins, but any column keeps the factor from being
+  // pushed down as a condition on constants
+  for (auto term : expression->Children()) {
+    if (term->ChildrenCount() == 1) {
+      has_column = true;
+      if (join_candidate.empty() &&
+          !term->Child(0)->ColumnName(join_candidate)) {
+        DEBUG_MSG("");
+        return false;
+      }
+    }
+  }
+
+  if (expression->ChildrenCount() != 1 || !has_column) {
     DEBUG_MSG("");
     return false;
   }
 
   return true;
 }
+
+bool WhereClauseHelperSelect::tryRangeJoinExpression(SqlNode *expression,
+    std::string& column_name, long long& offset) const {
+  std::vector<SqlNode *> terms = expression->Children();
+  offset = 0;
+  if (terms.size() == 1) {
+    return terms[0]->ChildrenCount() == 1 &&
+        terms[0]->Child(0)->ColumnName(column_name);
+  }
+
+  // A column plus or minus an integer, or an integer plus a column
+  if (terms.size() != 2 || terms[0]->ChildrenCount() ==
+      terms[1]->ChildrenCount()) {
+    DEBUG_MSG("");
+    return false;
+  }
+
+  bool column_first = terms[0]->ChildrenCount() == 1;
+  SqlNode *column_term = column_first ? terms[0] : terms[1];
+  std::string constant = column_first ? terms[1]->Data() : terms[0]->Data();
+  std::string data_operator = expression->Data();
+  if (!Tokenizer::IsInteger(constant) || constant.size() > 9 ||
+      (data_operator != "+" && (data_operator != "-" || !column_first))) {
+    DEBUG_MSG("");
+    return false;
+  }
+
+  offset = data_operator == "+" ? std::stoll(constant) :
+      -std::stoll(constant);
+  return column_term->Child(0)->ColumnName(column_name);
+}
+
+double WhereClauseHelperSelect::booleanFactorSelectivity(
+    SqlNode *boolean_factor) const {
+  // Without value counts an equality keeps a tenth of the tuples and a
+  // comparison a third
+  return boolean_factor->Data() == "=" ? 0.1 : 1.0 / 3;
+}
@@ -1,8 +1,10 @@
 #ifndef SRC_PQP_WHERE_CLAUSE_HELPER_SELECT_H_
 #define SRC_PQP_WHERE_CLAUSE_HELPER_SELECT_H_
 
+#include <map>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "base/sql_errors.h"
 #include "parser/sql_node.h"
@@ -12,6 +14,17 @@
 typedef std::vector<std::pair<std::string, SqlNode *> > PushCandidates;
 typedef std::vector<std::pair<std::string, std::string> > JoinAttributes;
 
+// A comparison of INT columns of two tables, first - second < offset, or
+// > offset when less_ is false. The first column is of the table listed
+// first in the FROM clause.
+typedef struct RangeJoinAttribute {
+  std::string first_;
+  std::string second_;
+  bool less_;
+  long long offset_;
+} RangeJoinAttribute;
+typedef std::vector<RangeJoinAttribute> RangeJoinAttributes;
+
 class StorageAdapter;
 
 class WhereClauseHelperSelect : public WhereClauseHelper {
@@ -26,15 +39,42 @@ class WhereClauseHelperSelect : public WhereClauseHelper {
 
   bool Initialize(SqlNode *where_node,
       const std::vector<std::string> table_list);
-  bool Evaluate(Tuple *tuple, SqlErrors::Type& error_code) override;
+  bool Evaluate(const Tuple *tuple, SqlErrors::Type& error_code) override;
+  // Evaluates the condition on a pair of tuples as if they were merged by a
+  // product. The columns of a table are named without the table in its own
+  // tuples, so each tuple comes with the table it was read from, or an empty
+  // name when it is the result of another product.
+  bool EvaluatePair(const Tuple& first, const std::string& first_table,
+      const Tuple& second, const std::string& second_table,
+      SqlErrors::Type& error_code);
 
+  // Splits the condition into factors pushed down to a table, the
+  // equalities of columns of two tables with the same type, and the
+  // comparisons of a column with a column of another table, plus or minus a
+  // constant, it is a band join on when they are all that is left of it
   void OptimizationCandidates(
       PushCandidates& push_candidates,
-      JoinAttributes& join_attributes) const;
+      JoinAttributes& join_attributes,
+      RangeJoinAttributes& range_join_attributes) const;
+  // Takes the equalities of columns of two tables out of the condition,
+  // once the joins below check them
+  void DropJoinFactors();
+  // The estimated fraction of the tuples the condition keeps
+  double Selectivity() const;
+  // The tables the columns of the condition belong to, each once
+  void ReferencedTables(std::vector<std::string>& table_names) const;
+  // The columns of the condition as they are written, each once
+  void ReferencedColumns(std::vector<std::string>& column_names) const;
 
  private:
   virtual std::string HandleColumnName(SqlNode *column_name) override;
 
+  std::string pairColumnValue(SqlNode *column_name);
+  void referencedTables(SqlNode *node,
+      std::vector<std::string>& table_names) const;
+  void referencedColumns(SqlNode *node,
+      std::vector<std::string>& column_names) const;
+
   bool isValidSearchCondition() const;
   bool isValidBooleanTerm(SqlNode *boolean_term) const;
   bool isValidBooleanFactor(SqlNode *boolean_factor) const;
@@ -44,17 +84,33 @@ class WhereClauseHelperSelect : public WhereClauseHelper {
 
   void optimizationCandidatesBooleanTerm(SqlNode *boolean_term,
       PushCandidates& push_candidates,
-      JoinAttributes& join_attributes) const;
+      JoinAttributes& join_attributes,
+      RangeJoinAttributes& range_join_attributes) const;
   void optimizationCandidatesBooleanFactor(
       SqlNode *boolean_factor, JoinAttributes& join_attributes,
       bool& joinable, bool& optimizable,
       std::string& optimizable_table_name) const;
+  bool tryRangeJoinFactor(SqlNode *boolean_factor,
+      RangeJoinAttributes& range_join_attributes) const;
   bool tryJoinExpression(SqlNode *expression,
       std::string& join_candidate, bool& has_column) const;
+  bool tryRangeJoinExpression(SqlNode *expression,
+      std::string& column_name, long long& offset) const;
+  double booleanFactorSelectivity(SqlNode *boolean_factor) const;
 
   HelperType type_;
   SqlErrors::Type error_code_;
   std::vector<std::string> table_list_;
+  // The factors DropJoinFactors() took out of the condition
+  std::vector<SqlNode *> join_factors_;
+
+  // The pair of EvaluatePair(), and the columns bound in either tuple
+  const Tuple *first_tuple_;
+  const Tuple *second_tuple_;
+  std::string first_table_;
+  std::string second_table_;
+  std::map<SqlNode *, ColumnAccessor> first_columns_;
+  std::map<SqlNode *, ColumnAccessor> second_columns_;
 };
 
 #endif // SRC_PQP_WHERE_CLAUSE_HELPER_SELECT_H_
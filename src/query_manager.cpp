@@ -1,16 +1,79 @@
 #include "query_manager.h"
 
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+
 #include "base/debug.h"
+#include "base/tokenizer.h"
 #include "lqp/statement.h"
 #include "lqp/statement_factory.h"
 #include "parser/sql_node.h"
+#include "storage/storage_adapter.h"
+
+bool inline ParseCount(const std::string& value, int& count) {
+  char *end = nullptr;
+  long number = std::strtol(value.c_str(), &end, 10);
+  if (value.empty() || *end != '\0' || number <= 0 || number > INT_MAX) {
+    return false;
+  }
+
+  count = number;
+  return true;
+}
+
+// For the sizes whose default of 0 turns a feature off
+bool inline ParseNonNegativeCount(const std::string& value, int& count) {
+  char *end = nullptr;
+  long number = std::strtol(value.c_str(), &end, 10);
+  if (value.empty() || *end != '\0' || number < 0 || number > INT_MAX) {
+    return false;
+  }
+
+  count = number;
+  return true;
+}
+
+bool inline ParsePercent(const std::string& value, int& percent) {
+  char *end = nullptr;
+  long number = std::strtol(value.c_str(), &end, 10);
+  if (value.empty() || *end != '\0' || number < 0 || number > 100) {
+    return false;
+  }
+
+  percent = number;
+  return true;
+}
+
+// The statements the write-ahead log keeps to run again after a crash
+bool inline ChangesDatabase(SqlNode *statement_root) {
+  switch (statement_root->Type()) {
+    case SqlNode::NODE_TYPE_CREATE_TABLE_STATEMENT:
+    case SqlNode::NODE_TYPE_DROP_TABLE_STATEMENT:
+    case SqlNode::NODE_TYPE_DELETE_STATEMENT:
+    case SqlNode::NODE_TYPE_INSERT_STATEMENT:
+    case SqlNode::NODE_TYPE_LOAD_STATEMENT:
+      return true;
+    default:
+      return false;
+  }
+}
 
 QueryManager *QueryManager::manager_ = nullptr;
 
-QueryManager::QueryManager() : print_stats_(false) {
+QueryManager::QueryManager()
+  : print_stats_(false),
+    replaying_(false),
+    io_report_(false) {
   parser_ = std::make_unique<SqlParser>();
 }
 
+QueryManager::~QueryManager() {
+  if (!StorageAdapter::Get()->Checkpoint()) {
+    ERROR_MSG("Unable to checkpoint the database file");
+  }
+}
+
 QueryManager *QueryManager::Get() {
   if (!manager_)
     manager_ = new QueryManager();
@@ -52,13 +115,219 @@ void QueryManager::ExecuteQuery(SqlErrors::Type &error_code) {
     return;
   }
 
+  StorageAdapter::Get()->ResetIoStats();
   statement->Execute(error_code);
+  if (!StorageAdapter::Get()->CompactRelations()) {
+    DEBUG_MSG("Unable to compact the relations");
+  }
+
+  // A statement that failed may have changed the database all the same,
+  // like a LOAD keeping the batches before an invalid row, and fails the
+  // same way when run again
+  if (!replaying_ && ChangesDatabase(statement_root) &&
+      !StorageAdapter::Get()->LogStatement(sql_query_)) {
+    ERROR_MSG("Unable to write the statement to the write-ahead log");
+  }
+
+  if (!StorageAdapter::Get()->Sync()) {
+    DEBUG_MSG("Unable to sync the database file");
+  }
+
   delete sql_node;
   delete statement;
+
+  if (io_report_) {
+    writeIoReport();
+  }
+}
+
+bool QueryManager::Initialize() {
+  if (!StorageAdapter::Get()->Initialize(storage_config_)) {
+    ERROR_MSG("Unable to initialize storage");
+    return false;
+  }
+
+  return replayStatements();
 }
 
 void QueryManager::SetArgument(const char *argument) {
-  if (std::string(argument) == "--print-stats") {
+  std::string option, value;
+  Tokenizer::SplitIntoTwo(argument, '=', option, value);
+
+  if (option.compare(0, 2, "--") != 0 || !setOption(option.substr(2), value)) {
+    ERROR_MSG("Invalid option: " << argument);
+  }
+}
+
+bool QueryManager::setOption(const std::string& option,
+    const std::string& value) {
+  if (option == "print-stats") {
     print_stats_ = true;
+  } else if (option == "io-report") {
+    io_report_ = true;
+    io_report_file_ = value;
+  } else if (option == "config") {
+    return readConfigFile(value);
+  } else if (option == "database") {
+    if (value.empty()) {
+      return false;
+    }
+
+    storage_config_.database_file = value;
+  } else if (option == "restore") {
+    if (value.empty()) {
+      return false;
+    }
+
+    storage_config_.restore_file = value;
+  } else if (option == "memory-blocks") {
+    return ParseCount(value, storage_config_.memory_blocks);
+  } else if (option == "fields-per-block") {
+    return ParseCount(value, storage_config_.fields_per_block);
+  } else if (option == "buffer-frames") {
+    return ParseNonNegativeCount(value, storage_config_.buffer_frames);
+  } else if (option == "read-ahead-blocks") {
+    return ParseNonNegativeCount(value, storage_config_.read_ahead_blocks);
+  } else if (option == "append-blocks") {
+    return ParseCount(value, storage_config_.append_blocks);
+  } else if (option == "compaction-threshold") {
+    return ParsePercent(value, storage_config_.compaction_threshold);
+  } else if (option == "compressed-tables") {
+    storage_config_.compressed_tables = true;
+  } else if (option == "wal") {
+    storage_config_.write_ahead_log = true;
+  } else if (option == "wal-group-commit") {
+    return ParseCount(value, storage_config_.group_commit_size);
+  } else if (option == "checkpoint-interval") {
+    return ParseCount(value, storage_config_.checkpoint_interval);
+  } else if (option.compare(0, 5, "disk-") == 0) {
+    return setDiskOption(option, value);
+  } else {
+    return false;
+  }
+
+  return true;
+}
+
+bool QueryManager::readConfigFile(const std::string& file_name) {
+  std::ifstream config_file(file_name);
+  if (!config_file.is_open()) {
+    ERROR_MSG("Unable to open config file: " << file_name);
+    return false;
+  }
+
+  // One option per line, as on the command line without the leading dashes
+  std::string line;
+  while (std::getline(config_file, line)) {
+    line = Tokenizer::Trim(line);
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+
+    std::string option, value;
+    Tokenizer::SplitIntoTwo(line, '=', option, value);
+    if (!setOption(Tokenizer::Trim(option), Tokenizer::Trim(value))) {
+      ERROR_MSG("Invalid option in " << file_name << ": " << line);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void QueryManager::writeIoReport() {
+  std::string report = StorageAdapter::Get()->IoReport(sql_query_);
+  if (io_report_file_.empty()) {
+    ERROR_MSG(report);
+    return;
+  }
+
+  std::ofstream report_file(io_report_file_, std::ios::app);
+  if (!report_file.is_open()) {
+    ERROR_MSG("Unable to open the I/O report file: " << io_report_file_);
+    return;
+  }
+
+  report_file << report << std::endl;
+}
+
+bool QueryManager::replayStatements() {
+  std::vector<std::string> statements =
+      StorageAdapter::Get()->RecoveredStatements();
+  if (statements.empty()) {
+    return true;
+  }
+
+  bool print_stats = print_stats_, io_report = io_report_;
+  print_stats_ = io_report_ = false;
+  replaying_ = true;
+  for (auto& statement : statements) {
+    SqlErrors::Type error_code = SqlErrors::NO_ERROR;
+    SetQuery(statement, error_code);
+    ExecuteQuery(error_code);
+  }
+
+  print_stats_ = print_stats;
+  io_report_ = io_report;
+  replaying_ = false;
+
+  ERROR_MSG("Recovered " << statements.size() <<
+      " statements from the write-ahead log");
+  if (!StorageAdapter::Get()->Checkpoint()) {
+    ERROR_MSG("Unable to checkpoint the database file");
+    return false;
+  }
+
+  return true;
+}
+
+bool QueryManager::setDiskOption(const std::string& option,
+    const std::string& value) {
+  DiskLatencyModel& model = storage_config_.disk_latency;
+
+  if (option == "disk-latency") {
+    if (value == "virtual") {
+      model.mode = DiskLatencyModel::VIRTUAL;
+    } else if (value == "sleep") {
+      model.mode = DiskLatencyModel::SLEEP;
+    } else if (value == "spin") {
+      model.mode = DiskLatencyModel::SPIN;
+    } else {
+      return false;
+    }
+  } else if (option == "disk-profile") {
+    DiskLatencyModel::Mode mode = model.mode;
+    if (value == "hdd") {
+      model = DiskLatencyModel::getHardDiskModel();
+    } else if (value == "ssd") {
+      model = DiskLatencyModel::getSolidStateModel();
+    } else {
+      return false;
+    }
+
+    model.mode = mode;
+  } else {
+    double *parameter = nullptr;
+    if (option == "disk-seek-time") {
+      parameter = &model.seek_time;
+    } else if (option == "disk-rotation-latency") {
+      parameter = &model.rotation_latency;
+    } else if (option == "disk-transfer-time") {
+      parameter = &model.transfer_time_per_block;
+    } else if (option == "disk-sequential-transfer-time") {
+      parameter = &model.sequential_transfer_time_per_block;
+    } else {
+      return false;
+    }
+
+    char *end = nullptr;
+    double number = std::strtod(value.c_str(), &end);
+    if (value.empty() || *end != '\0' || number < 0) {
+      return false;
+    }
+
+    *parameter = number;
   }
+
+  return true;
 }
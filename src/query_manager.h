@@ -6,21 +6,38 @@
 
 #include "base/sql_errors.h"
 #include "parser/sql_parser.h"
+#include "storage/storage_adapter.h"
 
 class QueryManager {
  public:
   // Singleton method
   static QueryManager *Get();
+  // Checkpoints the database file
+  virtual ~QueryManager();
 
   // Set SQL Query
   void SetQuery(std::string query, SqlErrors::Type &error_code);
   void ExecuteQuery(SqlErrors::Type &error_code);
   void SetArgument(const char *argument);
+  // Sets up the storage from the arguments; call before the first query
+  bool Initialize();
 
  private:
   QueryManager();
 
+  bool setOption(const std::string& option, const std::string& value);
+  bool setDiskOption(const std::string& option, const std::string& value);
+  bool readConfigFile(const std::string& file_name);
+  void writeIoReport();
+  bool replayStatements();
+
   bool print_stats_;
+  // Set while the statements of the write-ahead log are run again
+  bool replaying_;
+  // Prints the I/O report of every statement, or appends it to the file
+  bool io_report_;
+  std::string io_report_file_;
+  StorageConfig storage_config_;
   std::unique_ptr<SqlParser> parser_;
   std::string sql_query_;
 
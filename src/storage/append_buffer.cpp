@@ -0,0 +1,248 @@
+#include "storage/append_buffer.h"
+
+#include "base/debug.h"
+
+AppendBuffer::Tail::Tail()
+  : relation(nullptr),
+    block_index(-1),
+    dirty(false),
+    last_use(0) {
+}
+
+AppendBuffer::AppendBuffer(MainMemory *main_memory, BufferPool *buffer_pool,
+    FreeSpaceMap *free_space_map, int first_block, int num_blocks)
+  : main_memory_(main_memory),
+    buffer_pool_(buffer_pool),
+    free_space_map_(free_space_map),
+    first_block_(first_block),
+    tails_(num_blocks),
+    use_count_(0) {
+}
+
+AppendBuffer::~AppendBuffer() {
+}
+
+int AppendBuffer::Size() const {
+  return tails_.size();
+}
+
+bool AppendBuffer::Append(Relation *relation, const Tuple& tuple) {
+  int slot = find(relation);
+  if (slot < 0) {
+    slot = load(relation);
+    if (slot < 0) {
+      DEBUG_MSG("");
+      return false;
+    }
+  }
+
+  tails_[slot].last_use = ++use_count_;
+  Block *block = tailBlock(slot);
+
+  // Only a compressed block runs out of room before its slots are used, as
+  // the values of the tuple may not compress with the others; the tuple then
+  // starts a new block
+  if (!block->hasRoomFor(tuple)) {
+    if (!write(slot)) {
+      DEBUG_MSG("");
+      return false;
+    }
+
+    block->clear();
+    tails_[slot].block_index = relation->getNumOfBlocks();
+  }
+
+  // The first hole left by a delete, else after the last tuple
+  int offset = 0;
+  for (const Tuple& stored : *block) {
+    if (stored.isNull()) {
+      break;
+    }
+
+    offset++;
+  }
+
+  if (block->begin() + offset != block->end()) {
+    block->setTuple(offset, tuple);
+  } else {
+    block->appendTuple(tuple);
+  }
+
+  tails_[slot].dirty = true;
+  if (FreeSpaceMap::FreeSlots(relation, *block) > 0) {
+    return true;
+  }
+
+  // A full block is written once and the next tuple goes to another one
+  if (!write(slot)) {
+    DEBUG_MSG("");
+    return false;
+  }
+
+  // A hole is only read once a tuple goes there
+  if (free_space_map_->FirstBlock(relation) >= 0) {
+    block->clear();
+    tails_[slot] = Tail();
+    return true;
+  }
+
+  return place(slot, relation);
+}
+
+bool AppendBuffer::Flush(Relation *relation) {
+  int slot = find(relation);
+  return slot < 0 || write(slot);
+}
+
+bool AppendBuffer::FlushAll() {
+  for (int slot = 0; slot < tails_.size(); slot++) {
+    if (tails_[slot].relation != nullptr && !write(slot)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool AppendBuffer::Drop(Relation *relation) {
+  int slot = find(relation);
+  if (slot < 0) {
+    return true;
+  }
+
+  bool written = write(slot);
+  tails_[slot] = Tail();
+  tailBlock(slot)->clear();
+  return written;
+}
+
+bool AppendBuffer::Discard(Relation *relation, int block_index) {
+  int slot = find(relation);
+  if (slot < 0) {
+    return true;
+  }
+
+  if (tails_[slot].block_index < block_index) {
+    return Drop(relation);
+  }
+
+  tails_[slot] = Tail();
+  tailBlock(slot)->clear();
+  return true;
+}
+
+// Private methods
+int AppendBuffer::find(Relation *relation) const {
+  if (relation == nullptr) {
+    return -1;
+  }
+
+  for (int slot = 0; slot < tails_.size(); slot++) {
+    if (tails_[slot].relation == relation) {
+      return slot;
+    }
+  }
+
+  return -1;
+}
+
+int AppendBuffer::load(Relation *relation) {
+  if (tails_.empty()) {
+    return -1;
+  }
+
+  int slot = 0;
+  for (int index = 1; index < tails_.size(); index++) {
+    if (tails_[index].last_use < tails_[slot].last_use) {
+      slot = index;
+    }
+  }
+
+  if (tails_[slot].relation != nullptr && !Drop(tails_[slot].relation)) {
+    return -1;
+  }
+
+  if (!place(slot, relation)) {
+    tails_[slot] = Tail();
+    return -1;
+  }
+
+  return slot;
+}
+
+bool AppendBuffer::place(int slot, Relation *relation) {
+  Block *block = tailBlock(slot);
+  block->clear();
+
+  tails_[slot].relation = relation;
+  tails_[slot].dirty = false;
+
+  int num_blocks = relation->getNumOfBlocks();
+  free_space_map_->Discard(relation, num_blocks);
+
+  // The lowest block with a hole; an entry may be stale if the block was
+  // rewritten around the map, so its free slots are checked once it is read
+  int block_index = free_space_map_->FirstBlock(relation);
+  while (block_index >= 0) {
+    if (!buffer_pool_->ReadBlocks(relation, block_index,
+        first_block_ + slot, 1)) {
+      DEBUG_MSG("Unable to read block " << block_index << " of " <<
+          relation->getRelationName());
+      return false;
+    }
+
+    if (FreeSpaceMap::FreeSlots(relation, *block) > 0) {
+      tails_[slot].block_index = block_index;
+      return true;
+    }
+
+    free_space_map_->Update(relation, block_index, *block);
+    block_index = free_space_map_->FirstBlock(relation);
+  }
+
+  // The last block is read once unless it is known to be full; if it is
+  // full the tail is a new block
+  block->clear();
+  tails_[slot].block_index = num_blocks;
+  if (num_blocks == 0 ||
+      free_space_map_->KnownFull(relation, num_blocks - 1)) {
+    return true;
+  }
+
+  if (!buffer_pool_->ReadBlocks(relation, num_blocks - 1,
+      first_block_ + slot, 1)) {
+    DEBUG_MSG("Unable to read the last block of " <<
+        relation->getRelationName());
+    return false;
+  }
+
+  if (FreeSpaceMap::FreeSlots(relation, *block) > 0) {
+    tails_[slot].block_index = num_blocks - 1;
+  } else {
+    block->clear();
+  }
+
+  return true;
+}
+
+bool AppendBuffer::write(int slot) {
+  if (!tails_[slot].dirty) {
+    return true;
+  }
+
+  if (!buffer_pool_->WriteBlocks(tails_[slot].relation,
+      tails_[slot].block_index, first_block_ + slot, 1)) {
+    DEBUG_MSG("Unable to write block " << tails_[slot].block_index);
+    return false;
+  }
+
+  free_space_map_->Update(tails_[slot].relation, tails_[slot].block_index,
+      *tailBlock(slot));
+
+  tails_[slot].dirty = false;
+  return true;
+}
+
+Block *AppendBuffer::tailBlock(int slot) const {
+  return main_memory_->getBlock(first_block_ + slot);
+}
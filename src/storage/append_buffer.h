@@ -0,0 +1,62 @@
+#ifndef SRC_STORAGE_APPEND_BUFFER_H
+#define SRC_STORAGE_APPEND_BUFFER_H
+
+#include <vector>
+
+#include "storage/buffer_pool.h"
+#include "storage/free_space_map.h"
+#include "storage/storage_manager_headers.h"
+
+// Keeps the last block of the relations being inserted into in main memory,
+// so an INSERT adds its tuple there instead of reading and rewriting the last
+// block on disk. A block is written once, when it fills up; a partly filled
+// tail is written when it is flushed at the end of the statement and stays
+// cached for the next INSERT. The tails are the main memory blocks after the
+// read-ahead blocks; when all of them are taken, the least recently used one
+// is written and reused. Blocks go through the buffer pool, so a cached copy
+// of the last block never goes stale. Blocks the free-space map knows to have
+// holes are filled before the last one, a tuple taking the first free slot.
+class AppendBuffer {
+ public:
+  AppendBuffer(MainMemory *main_memory, BufferPool *buffer_pool,
+      FreeSpaceMap *free_space_map, int first_block, int num_blocks);
+  ~AppendBuffer();
+
+  int Size() const;
+
+  bool Append(Relation *relation, const Tuple& tuple);
+  // Writes the tail of the relation if it changed; it stays cached
+  bool Flush(Relation *relation);
+  bool FlushAll();
+  // Writes and forgets the tail, before the relation is changed elsewhere
+  bool Drop(Relation *relation);
+  // Forgets the tail without writing it if it is at or after block_index,
+  // before those blocks are deleted; an earlier tail is dropped
+  bool Discard(Relation *relation, int block_index);
+
+ private:
+  struct Tail {
+    Tail();
+
+    Relation *relation;
+    int block_index;
+    bool dirty;
+    unsigned long last_use;
+  };
+
+  int find(Relation *relation) const;
+  int load(Relation *relation);
+  // Reads the block the next tuples of the relation go to into the slot
+  bool place(int slot, Relation *relation);
+  bool write(int slot);
+  Block *tailBlock(int slot) const;
+
+  MainMemory *main_memory_;
+  BufferPool *buffer_pool_;
+  FreeSpaceMap *free_space_map_;
+  int first_block_;
+  std::vector<Tail> tails_;
+  unsigned long use_count_;
+};
+
+#endif // SRC_STORAGE_APPEND_BUFFER_H
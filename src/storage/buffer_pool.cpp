@@ -0,0 +1,272 @@
+#include "storage/buffer_pool.h"
+
+#include "base/debug.h"
+
+BufferPool::Frame::Frame()
+  : relation(nullptr),
+    block_index(-1),
+    pin_count(0),
+    dirty(false),
+    referenced(false) {
+}
+
+BufferPool::BufferPool(MainMemory *main_memory, int first_frame,
+    int num_frames)
+  : main_memory_(main_memory),
+    first_frame_(first_frame),
+    frames_(num_frames),
+    clock_hand_(0),
+    hits_(0),
+    misses_(0) {
+}
+
+BufferPool::~BufferPool() {
+}
+
+int BufferPool::Size() const {
+  return frames_.size();
+}
+
+void BufferPool::ResetStats() {
+  hits_ = 0;
+  misses_ = 0;
+}
+
+unsigned long BufferPool::Hits() const {
+  return hits_;
+}
+
+unsigned long BufferPool::Misses() const {
+  return misses_;
+}
+
+Block *BufferPool::Pin(Relation *relation, int block_index) {
+  int frame = find(relation, block_index);
+  if (frame >= 0) {
+    hits_++;
+  } else {
+    frame = install(relation, block_index);
+    if (frame < 0) {
+      return nullptr;
+    }
+
+    if (!relation->getBlock(block_index, first_frame_ + frame)) {
+      DEBUG_MSG("");
+      frame_table_.erase(std::make_pair(relation, block_index));
+      frames_[frame] = Frame();
+      return nullptr;
+    }
+
+    misses_++;
+  }
+
+  frames_[frame].pin_count++;
+  frames_[frame].referenced = true;
+  return frameBlock(frame);
+}
+
+void BufferPool::Unpin(Relation *relation, int block_index, bool dirty) {
+  int frame = find(relation, block_index);
+  if (frame < 0 || frames_[frame].pin_count == 0) {
+    DEBUG_MSG("Block is not pinned: " << block_index);
+    return;
+  }
+
+  frames_[frame].pin_count--;
+  frames_[frame].dirty = frames_[frame].dirty || dirty;
+}
+
+bool BufferPool::ReadBlocks(Relation *relation, int block_index,
+    int memory_index, int num_blocks) {
+  int offset = 0;
+  while (offset < num_blocks) {
+    int frame = find(relation, block_index + offset);
+    if (frame >= 0) {
+      hits_++;
+      frames_[frame].referenced = true;
+      main_memory_->setBlock(memory_index + offset, *frameBlock(frame));
+      offset++;
+      continue;
+    }
+
+    int run = 1;
+    while (offset + run < num_blocks &&
+        find(relation, block_index + offset + run) < 0) {
+      run++;
+    }
+
+    if (!relation->getBlocks(block_index + offset, memory_index + offset,
+        run)) {
+      DEBUG_MSG("");
+      return false;
+    }
+
+    if (!frames_.empty()) {
+      misses_ += run;
+    }
+
+    for (int index = offset; index < offset + run; index++) {
+      frame = install(relation, block_index + index);
+      if (frame >= 0) {
+        main_memory_->setBlock(first_frame_ + frame,
+            *main_memory_->getBlock(memory_index + index));
+      }
+    }
+
+    offset += run;
+  }
+
+  return true;
+}
+
+bool BufferPool::WriteBlocks(Relation *relation, int block_index,
+    int memory_index, int num_blocks) {
+  if (frames_.empty()) {
+    return relation->setBlocks(block_index, memory_index, num_blocks);
+  }
+
+  int offset = 0;
+  for (; offset < num_blocks &&
+      block_index + offset < relation->getNumOfBlocks(); offset++) {
+    int frame = find(relation, block_index + offset);
+    if (frame < 0) {
+      frame = install(relation, block_index + offset);
+    }
+
+    if (frame < 0) {
+      if (!relation->setBlock(block_index + offset, memory_index + offset)) {
+        DEBUG_MSG("");
+        return false;
+      }
+
+      continue;
+    }
+
+    main_memory_->setBlock(first_frame_ + frame,
+        *main_memory_->getBlock(memory_index + offset));
+    frames_[frame].dirty = true;
+    frames_[frame].referenced = true;
+  }
+
+  if (offset == num_blocks) {
+    return true;
+  }
+
+  return relation->setBlocks(block_index + offset, memory_index + offset,
+      num_blocks - offset);
+}
+
+bool BufferPool::Cached(Relation *relation, int block_index) const {
+  return find(relation, block_index) >= 0;
+}
+
+void BufferPool::Adopt(Relation *relation, int block_index,
+    int memory_index) {
+  if (frames_.empty()) {
+    return;
+  }
+
+  misses_++;
+  int frame = install(relation, block_index);
+  if (frame >= 0) {
+    main_memory_->setBlock(first_frame_ + frame,
+        *main_memory_->getBlock(memory_index));
+  }
+}
+
+bool BufferPool::Flush(Relation *relation) {
+  for (int frame = 0; frame < frames_.size(); frame++) {
+    if (frames_[frame].relation == relation && !writeBack(frame)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool BufferPool::FlushAll() {
+  for (int frame = 0; frame < frames_.size(); frame++) {
+    if (!writeBack(frame)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void BufferPool::Discard(Relation *relation, int block_index) {
+  auto it = frame_table_.lower_bound(std::make_pair(relation, block_index));
+  while (it != frame_table_.end() && it->first.first == relation) {
+    frames_[it->second] = Frame();
+    it = frame_table_.erase(it);
+  }
+}
+
+// Private methods
+int BufferPool::find(Relation *relation, int block_index) const {
+  auto it = frame_table_.find(std::make_pair(relation, block_index));
+  return it == frame_table_.end() ? -1 : it->second;
+}
+
+int BufferPool::victim() {
+  // The first sweep may only clear reference bits; the second finds a frame
+  for (int step = 0; step < 2 * frames_.size(); step++) {
+    int frame = clock_hand_;
+    clock_hand_ = (clock_hand_ + 1) % frames_.size();
+
+    if (frames_[frame].pin_count > 0) {
+      continue;
+    }
+
+    if (frames_[frame].relation != nullptr && frames_[frame].referenced) {
+      frames_[frame].referenced = false;
+      continue;
+    }
+
+    return frame;
+  }
+
+  return -1;
+}
+
+int BufferPool::install(Relation *relation, int block_index) {
+  int frame = victim();
+  if (frame < 0) {
+    return -1;
+  }
+
+  if (frames_[frame].relation != nullptr) {
+    if (!writeBack(frame)) {
+      return -1;
+    }
+
+    frame_table_.erase(std::make_pair(frames_[frame].relation,
+        frames_[frame].block_index));
+  }
+
+  frames_[frame] = Frame();
+  frames_[frame].relation = relation;
+  frames_[frame].block_index = block_index;
+  frames_[frame].referenced = true;
+  frame_table_[std::make_pair(relation, block_index)] = frame;
+  return frame;
+}
+
+bool BufferPool::writeBack(int frame) {
+  if (!frames_[frame].dirty) {
+    return true;
+  }
+
+  if (!frames_[frame].relation->setBlock(frames_[frame].block_index,
+      first_frame_ + frame)) {
+    DEBUG_MSG("Unable to write back block " << frames_[frame].block_index);
+    return false;
+  }
+
+  frames_[frame].dirty = false;
+  return true;
+}
+
+Block *BufferPool::frameBlock(int frame) const {
+  return main_memory_->getBlock(first_frame_ + frame);
+}
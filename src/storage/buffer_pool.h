@@ -0,0 +1,77 @@
+#ifndef SRC_STORAGE_BUFFER_POOL_H
+#define SRC_STORAGE_BUFFER_POOL_H
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "storage/storage_manager_headers.h"
+
+// Keeps relation blocks cached in main memory frames across statements, so a
+// hot table is read from disk once. The frames are the main memory blocks
+// after the operator workspace. Frames are replaced with the CLOCK policy; a
+// pinned frame is never replaced and a dirty frame is written back when it is
+// replaced or flushed. With no frames every call goes straight to the relation.
+class BufferPool {
+ public:
+  BufferPool(MainMemory *main_memory, int first_frame, int num_frames);
+  ~BufferPool();
+
+  int Size() const;
+  void ResetStats();
+  unsigned long Hits() const;
+  unsigned long Misses() const;
+
+  // Returns the frame holding the block, reading it on a miss, or nullptr if
+  // there is no unpinned frame. Every Pin() needs a matching Unpin().
+  Block *Pin(Relation *relation, int block_index);
+  void Unpin(Relation *relation, int block_index, bool dirty);
+
+  // Copies the blocks into main memory; the missing runs of blocks are read
+  // with one disk access each and then cached
+  bool ReadBlocks(Relation *relation, int block_index, int memory_index,
+      int num_blocks);
+  // Overwrites the blocks from main memory. Blocks inside the relation are
+  // cached dirty; blocks past its end are written to disk right away.
+  bool WriteBlocks(Relation *relation, int block_index, int memory_index,
+      int num_blocks);
+
+  bool Cached(Relation *relation, int block_index) const;
+  // Caches a block that was read into main memory past the pool, counting the
+  // read as a miss
+  void Adopt(Relation *relation, int block_index, int memory_index);
+
+  // Writes back the dirty frames
+  bool Flush(Relation *relation);
+  bool FlushAll();
+  // Drops the frames of the blocks from block_index on without writing them
+  void Discard(Relation *relation, int block_index);
+
+ private:
+  struct Frame {
+    Frame();
+
+    Relation *relation;
+    int block_index;
+    int pin_count;
+    bool dirty;
+    bool referenced;
+  };
+
+  int find(Relation *relation, int block_index) const;
+  int victim();
+  int install(Relation *relation, int block_index);
+  bool writeBack(int frame);
+  Block *frameBlock(int frame) const;
+
+  MainMemory *main_memory_;
+  int first_frame_;
+  std::vector<Frame> frames_;
+  std::map<std::pair<Relation *, int>, int> frame_table_;
+  int clock_hand_;
+
+  unsigned long hits_;
+  unsigned long misses_;
+};
+
+#endif // SRC_STORAGE_BUFFER_POOL_H
@@ -0,0 +1,96 @@
+#include "storage/free_space_map.h"
+
+FreeSpaceMap::Entry::Entry()
+  : free_slots(0) {
+}
+
+FreeSpaceMap::FreeSpaceMap() {
+}
+
+FreeSpaceMap::~FreeSpaceMap() {
+}
+
+void FreeSpaceMap::Update(Relation *relation, int block_index,
+    const Block& block) {
+  Entry& entry = entries_[relation];
+  int& block_free_slots = entry.blocks[block_index];
+  entry.free_slots -= block_free_slots;
+
+  block_free_slots = FreeSlots(relation, block);
+  entry.free_slots += block_free_slots;
+  if (block_free_slots > 0) {
+    entry.free_blocks.insert(block_index);
+  } else {
+    entry.free_blocks.erase(block_index);
+  }
+}
+
+void FreeSpaceMap::Discard(Relation *relation, int block_index) {
+  auto entry = entries_.find(relation);
+  if (entry == entries_.end()) {
+    return;
+  }
+
+  std::map<int, int>& blocks = entry->second.blocks;
+  for (auto it = blocks.lower_bound(block_index); it != blocks.end();) {
+    entry->second.free_slots -= it->second;
+    it = blocks.erase(it);
+  }
+
+  std::set<int>& free_blocks = entry->second.free_blocks;
+  free_blocks.erase(free_blocks.lower_bound(block_index), free_blocks.end());
+
+  if (blocks.empty()) {
+    entries_.erase(entry);
+  }
+}
+
+int FreeSpaceMap::FirstBlock(Relation *relation) const {
+  auto entry = entries_.find(relation);
+  if (entry == entries_.end() || entry->second.free_blocks.empty()) {
+    return -1;
+  }
+
+  return *entry->second.free_blocks.begin();
+}
+
+bool FreeSpaceMap::KnownFull(Relation *relation, int block_index) const {
+  auto entry = entries_.find(relation);
+  if (entry == entries_.end()) {
+    return false;
+  }
+
+  auto block = entry->second.blocks.find(block_index);
+  return block != entry->second.blocks.end() && block->second == 0;
+}
+
+long FreeSpaceMap::FreeSlots(Relation *relation) const {
+  auto entry = entries_.find(relation);
+  if (entry == entries_.end()) {
+    return 0;
+  }
+
+  return entry->second.free_slots;
+}
+
+std::vector<Relation *> FreeSpaceMap::Relations() const {
+  std::vector<Relation *> relations;
+  for (auto& entry : entries_) {
+    if (entry.second.free_slots > 0) {
+      relations.push_back(entry.first);
+    }
+  }
+
+  return relations;
+}
+
+int FreeSpaceMap::FreeSlots(Relation *relation, const Block& block) {
+  const Schema& schema = relation->getSchemaRef();
+  if (!schema.isCompressed()) {
+    return schema.getTuplesPerBlock() - block.getNumTuples();
+  }
+
+  // The holes, and one more if a tuple can still be added
+  int holes = (block.end() - block.begin()) - block.getNumTuples();
+  return block.isFull() ? holes : holes + 1;
+}
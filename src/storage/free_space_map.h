@@ -0,0 +1,50 @@
+#ifndef SRC_STORAGE_FREE_SPACE_MAP_H
+#define SRC_STORAGE_FREE_SPACE_MAP_H
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include "storage/storage_manager_headers.h"
+
+// The free tuple slots of the relation blocks written in this run: the holes
+// a DELETE leaves by nulling tuples and the room after the last tuple of a
+// block. Inserts fill the lowest block with free slots first, and compaction
+// looks here for sparse relations. The map is only kept in memory, so the
+// holes of blocks not written since startup are not known.
+class FreeSpaceMap {
+ public:
+  FreeSpaceMap();
+  ~FreeSpaceMap();
+
+  // Records the free slots of the block as it was just written
+  void Update(Relation *relation, int block_index, const Block& block);
+  // Forgets the blocks from block_index on
+  void Discard(Relation *relation, int block_index);
+
+  // The lowest block with free slots, or -1
+  int FirstBlock(Relation *relation) const;
+  // Whether the block was written full since startup
+  bool KnownFull(Relation *relation, int block_index) const;
+  long FreeSlots(Relation *relation) const;
+  // The relations with free slots
+  std::vector<Relation *> Relations() const;
+
+  // A compressed block is counted as one slot short of full until no tuple
+  // fits, as the room left depends on the values of the tuples
+  static int FreeSlots(Relation *relation, const Block& block);
+
+ private:
+  struct Entry {
+    Entry();
+
+    // Free slots of the blocks written, and the blocks that have some
+    std::map<int, int> blocks;
+    std::set<int> free_blocks;
+    long free_slots;
+  };
+
+  std::map<Relation *, Entry> entries_;
+};
+
+#endif // SRC_STORAGE_FREE_SPACE_MAP_H
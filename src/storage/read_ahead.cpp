@@ -0,0 +1,138 @@
+#include "storage/read_ahead.h"
+
+#include <algorithm>
+
+#include "base/debug.h"
+
+ReadAheadBatch::ReadAheadBatch()
+  : relation(nullptr),
+    block_index(0),
+    memory_index(-1),
+    num_blocks(0) {
+}
+
+ReadAhead::ReadAhead(MainMemory *main_memory, int first_block,
+    int num_blocks)
+  : main_memory_(main_memory),
+    first_block_(first_block),
+    reserved_(num_blocks, false),
+    next_job_(0),
+    stopping_(false) {
+  if (num_blocks > 0) {
+    thread_ = std::thread(&ReadAhead::run, this);
+  }
+}
+
+ReadAhead::~ReadAhead() {
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    stopping_ = true;
+  }
+
+  condition_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+int ReadAhead::Size() const {
+  return reserved_.size();
+}
+
+int ReadAhead::Reserve(int num_blocks, int& memory_index) {
+  // The longest free run, cut to num_blocks
+  int best_start = -1, best_length = 0;
+  for (int index = 0; index < reserved_.size();) {
+    if (reserved_[index]) {
+      index++;
+      continue;
+    }
+
+    int length = 0;
+    while (index + length < reserved_.size() && !reserved_[index + length]) {
+      length++;
+    }
+
+    if (length > best_length) {
+      best_start = index;
+      best_length = length;
+    }
+
+    index += length;
+  }
+
+  best_length = std::min(best_length, num_blocks);
+  for (int index = best_start; index < best_start + best_length; index++) {
+    reserved_[index] = true;
+  }
+
+  memory_index = first_block_ + best_start;
+  return best_length;
+}
+
+void ReadAhead::Release(int memory_index, int num_blocks) {
+  for (int index = memory_index - first_block_;
+      index < memory_index - first_block_ + num_blocks; index++) {
+    reserved_[index] = false;
+    main_memory_->getBlock(first_block_ + index)->clear();
+  }
+}
+
+int ReadAhead::Submit(Relation *relation, int block_index, int memory_index,
+    int num_blocks) {
+  Job job;
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    job.id = next_job_++;
+    job.relation = relation;
+    job.block_index = block_index;
+    job.memory_index = memory_index;
+    job.num_blocks = num_blocks;
+    job.access_tag = Disk::getAccessTag();
+    jobs_.push_back(job);
+  }
+
+  condition_.notify_all();
+  return job.id;
+}
+
+bool ReadAhead::Wait(int job) {
+  std::unique_lock<std::mutex> guard(mutex_);
+  condition_.wait(guard, [this, job]() {
+    return results_.count(job) > 0;
+  });
+
+  bool result = results_[job];
+  results_.erase(job);
+  return result;
+}
+
+// Private methods
+void ReadAhead::run() {
+  std::unique_lock<std::mutex> guard(mutex_);
+  while (true) {
+    condition_.wait(guard, [this]() {
+      return stopping_ || !jobs_.empty();
+    });
+
+    if (jobs_.empty()) {
+      return;
+    }
+
+    Job job = jobs_.front();
+    jobs_.pop_front();
+
+    guard.unlock();
+    Disk::setAccessTag(job.access_tag);
+    bool result = job.relation->getBlocks(job.block_index, job.memory_index,
+        job.num_blocks);
+    guard.lock();
+
+    if (!result) {
+      DEBUG_MSG("Unable to read ahead block " << job.block_index);
+    }
+
+    results_[job.id] = result;
+    condition_.notify_all();
+  }
+}
@@ -0,0 +1,78 @@
+#ifndef SRC_STORAGE_READ_AHEAD_H
+#define SRC_STORAGE_READ_AHEAD_H
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "storage/storage_manager_headers.h"
+
+// The next blocks of a sequential scan, being read while the scan works on
+// the current ones; see StorageAdapter::StartReadAhead()
+struct ReadAheadBatch {
+  ReadAheadBatch();
+
+  Relation *relation;
+  int block_index;
+  // The read-ahead memory blocks given to the batch
+  int memory_index;
+  int num_blocks;
+  // The blocks queued to be read; the others were cached when it started
+  std::vector<bool> queued;
+  std::vector<int> jobs;
+};
+
+// Reads relation blocks on a background I/O thread into main memory blocks set
+// aside for it, after the buffer pool frames. Scans use them as the second
+// half of a double buffer: the blocks are handed out first come, first served,
+// so a nested scan gets what an outer one left, possibly nothing. Only disk
+// reads run on the thread, and the blocks of a job belong to it until Wait()
+// returns for the job. With no blocks the thread is never started.
+class ReadAhead {
+ public:
+  ReadAhead(MainMemory *main_memory, int first_block, int num_blocks);
+  ~ReadAhead();
+
+  int Size() const;
+
+  // Sets aside up to num_blocks consecutive blocks; returns how many, and the
+  // first of them in memory_index
+  int Reserve(int num_blocks, int& memory_index);
+  void Release(int memory_index, int num_blocks);
+
+  // Queues reading the relation blocks into main memory; returns the job
+  int Submit(Relation *relation, int block_index, int memory_index,
+      int num_blocks);
+  // Returns once the job is done, with the result of the read
+  bool Wait(int job);
+
+ private:
+  struct Job {
+    int id;
+    Relation *relation;
+    int block_index;
+    int memory_index;
+    int num_blocks;
+    // The disk access tag of the thread that queued the job
+    int access_tag;
+  };
+
+  void run();
+
+  MainMemory *main_memory_;
+  int first_block_;
+  std::vector<bool> reserved_;
+
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::deque<Job> jobs_;
+  std::map<int, bool> results_;
+  int next_job_;
+  bool stopping_;
+};
+
+#endif // SRC_STORAGE_READ_AHEAD_H
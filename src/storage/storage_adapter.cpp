@@ -1,20 +1,40 @@
 #include "storage_adapter.h"
 
+#include <climits>
+#include <cstdio>
 #include <cstdlib>
+#include <fstream>
 #include <iomanip>
-#include <regex>
+#include <map>
+#include <sstream>
 
 #include "base/debug.h"
+#include "base/tokenizer.h"
 
-bool inline IsInteger(const std::string integer) {
-  if (!std::regex_match(integer, std::regex("^[0-9]+$")) && integer != "NULL") {
-    return false;
+bool inline IsInteger(const std::string& integer) {
+  return Tokenizer::IsInteger(integer) || integer == "NULL";
+}
+
+// NULL is kept as -1
+bool inline ParseInteger(const std::string& value, int& integer) {
+  if (value == "NULL") {
+    integer = -1;
+    return true;
+  }
+
+  long number = 0;
+  for (char digit : value) {
+    number = number * 10 + (digit - '0');
+    if (number > INT_MAX) {
+      return false;
+    }
   }
 
+  integer = number;
   return true;
 }
 
-bool inline MatchFieldType(const Schema schema, const int offset,
+bool inline MatchFieldType(const Schema& schema, const int offset,
     const std::string value) {
   std::string field_name = schema.getFieldName(offset);
   FIELD_TYPE field_type = schema.getFieldType(offset);
@@ -25,8 +45,9 @@ bool inline MatchFieldType(const Schema schema, const int offset,
       return false;
     }
   } else if (field_type == STR20) {
-    if (value.length() > 22) {
+    if (value.length() > STR20_CAPACITY) {
       ERROR_MSG("Length mismatch for value of attribtue: " << field_name);
+      return false;
     }
   } else {
     ERROR_MSG("Invalid field name");
@@ -36,10 +57,89 @@ bool inline MatchFieldType(const Schema schema, const int offset,
   return true;
 }
 
-bool inline MatchFieldType(const Schema schema,
-    const std::string field_name, const std::string value) {
+bool inline SetFieldValue(const Schema& schema, const int offset,
+    const std::string& value, Tuple& tuple) {
+  if (!MatchFieldType(schema, offset, value)) {
+    return false;
+  }
+
+  if (schema.getFieldType(offset) == STR20) {
+    return tuple.setField(offset, value);
+  }
+
+  int integer = 0;
+  if (!ParseInteger(value, integer)) {
+    ERROR_MSG("Integer value out of range for attribute: " <<
+        schema.getFieldName(offset));
+    return false;
+  }
+
+  return tuple.setField(offset, integer);
+}
+
+std::string inline JsonString(const std::string& text) {
+  std::ostringstream json;
+  json << '"';
+  for (char character : text) {
+    if (character == '"' || character == '\\') {
+      json << '\\' << character;
+    } else if (character < 0x20 && character >= 0) {
+      json << "\\u" << std::hex << std::setw(4) << std::setfill('0') <<
+          (int) character << std::dec;
+    } else {
+      json << character;
+    }
+  }
+
+  json << '"';
+  return json.str();
+}
+
+void inline WriteJsonStats(std::ostream& json, const DiskAccessStats& stats) {
+  json << "\"reads\":" << stats.reads << ",\"writes\":" << stats.writes <<
+      ",\"blocks_read\":" << stats.blocks_read <<
+      ",\"blocks_written\":" << stats.blocks_written <<
+      ",\"time_ms\":" << std::fixed << std::setprecision(2) << stats.time;
+}
+
+DiskAccessScope::DiskAccessScope(int tag)
+  : previous_tag_(Disk::getAccessTag()) {
+  Disk::setAccessTag(tag);
+}
+
+DiskAccessScope::~DiskAccessScope() {
+  Disk::setAccessTag(previous_tag_);
+}
+
+bool inline ImageExists(const std::string& file_name) {
+  std::ifstream image(file_name, std::ios::binary);
+  return image.is_open() && image.peek() != EOF;
+}
+
+bool inline CopyFile(const std::string& from, const std::string& to) {
+  std::ifstream source(from, std::ios::binary);
+  std::ofstream target(to, std::ios::binary | std::ios::trunc);
+  if (!source.is_open() || !target.is_open()) {
+    return false;
+  }
+
+  target << source.rdbuf();
+  target.close();
+  return !target.fail();
+}
+
+StorageConfig::StorageConfig()
+  : memory_blocks(NUM_OF_BLOCKS_IN_MEMORY),
+    fields_per_block(FIELDS_PER_BLOCK),
+    buffer_frames(0),
+    read_ahead_blocks(0),
+    append_blocks(1),
+    compaction_threshold(50),
+    compressed_tables(false),
+    write_ahead_log(false),
+    group_commit_size(32),
+    checkpoint_interval(1000) {
 
-  return MatchFieldType(schema, schema.getFieldOffset(field_name), value);
 }
 
 StorageAdapter *StorageAdapter::storage_adapter_ = nullptr;
@@ -52,61 +152,285 @@ StorageAdapter *StorageAdapter::Get() {
 }
 
 StorageAdapter::StorageAdapter()
-  : available_memory_index_(0),
+  : temporary_relation_count_(0),
     disk_(new Disk()),
     main_memory_(new MainMemory()),
-    schema_manager_(new SchemaManager(main_memory_, disk_)) {
+    schema_manager_(new SchemaManager(main_memory_, disk_)),
+    buffer_pool_(new BufferPool(main_memory_, main_memory_->getMemorySize(),
+        0)),
+    read_ahead_(new ReadAhead(main_memory_, main_memory_->getMemorySize(),
+        0)),
+    free_space_map_(new FreeSpaceMap()),
+    write_ahead_log_(nullptr),
+    checkpoint_interval_(0),
+    logged_statements_(0),
+    append_buffer_(new AppendBuffer(main_memory_, buffer_pool_,
+        free_space_map_, main_memory_->getMemorySize(), 0)),
+    compaction_threshold_(0),
+    compressed_tables_(false) {
 
 }
 
 StorageAdapter::~StorageAdapter() {
-  DEBUG_MSG("Real elapse time = " << \
-      ((double) (clock() - disk_start_time_) / CLOCKS_PER_SEC * 1000) << " ms");
+  std::chrono::duration<double, std::milli> elapsed_time =
+      std::chrono::steady_clock::now() - disk_start_time_;
+  DEBUG_MSG("Real elapse time = " << elapsed_time.count() << " ms");
   DEBUG_MSG("Calculated elapse time = " << disk_->getDiskTimer() << " ms");
   DEBUG_MSG("Calculated Disk I/Os = " << disk_->getDiskIOs());
 
   reset();
 }
 
-bool StorageAdapter::Initialize() {
+bool StorageAdapter::Initialize(const StorageConfig& config) {
+  if (!Block::setFieldsPerBlock(config.fields_per_block)) {
+    ERROR_MSG("Invalid number of fields per block: " << config.fields_per_block);
+    return false;
+  }
+
+  reset();
+  disk_ = new Disk();
+  main_memory_ = new MainMemory(config.memory_blocks + config.buffer_frames +
+      config.read_ahead_blocks + config.append_blocks);
+  schema_manager_ = new SchemaManager(main_memory_, disk_);
+  buffer_pool_ = new BufferPool(main_memory_, config.memory_blocks,
+      config.buffer_frames);
+  read_ahead_ = new ReadAhead(main_memory_,
+      config.memory_blocks + config.buffer_frames, config.read_ahead_blocks);
+  free_space_map_ = new FreeSpaceMap();
+  append_buffer_ = new AppendBuffer(main_memory_, buffer_pool_,
+      free_space_map_, config.memory_blocks + config.buffer_frames + config.read_ahead_blocks,
+      config.append_blocks);
+  compaction_threshold_ = config.compaction_threshold;
+  compressed_tables_ = config.compressed_tables;
+  checkpoint_interval_ = config.checkpoint_interval;
+  logged_statements_ = 0;
+  recovered_statements_.clear();
+  disk_->setLatencyModel(config.disk_latency);
+
+  if (!config.restore_file.empty() && !ImageExists(config.restore_file)) {
+    ERROR_MSG("Unable to open the image: " << config.restore_file);
+    return false;
+  }
+
+  if (config.database_file.empty()) {
+    if (config.write_ahead_log) {
+      ERROR_MSG("The write-ahead log needs a database file");
+      return false;
+    }
+
+    if (!config.restore_file.empty() &&
+        !schema_manager_->loadImage(config.restore_file)) {
+      ERROR_MSG("Unable to restore the image: " << config.restore_file);
+      return false;
+    }
+
+    return true;
+  }
+
+  // The image replaces the database file, and its log with it
+  if (!config.restore_file.empty() &&
+      config.restore_file != config.database_file) {
+    if (!CopyFile(config.restore_file, config.database_file)) {
+      ERROR_MSG("Unable to restore the image: " << config.restore_file);
+      return false;
+    }
+
+    std::remove((config.database_file + ".wal").c_str());
+  }
+
+  // The log puts the pages of the last checkpoint back before the disk
+  // reads them
+  if (config.write_ahead_log) {
+    write_ahead_log_ = new WriteAheadLog(config.group_commit_size);
+    if (!write_ahead_log_->Open(config.database_file,
+        recovered_statements_)) {
+      ERROR_MSG("Unable to open the write-ahead log of: " <<
+          config.database_file);
+      return false;
+    }
+  }
+
+  if (!disk_->open(config.database_file)) {
+    ERROR_MSG("Unable to open database file: " << config.database_file);
+    return false;
+  }
+
+  if (!schema_manager_->loadCatalog()) {
+    DEBUG_MSG("");
+    return false;
+  }
+
+  if (write_ahead_log_ != nullptr) {
+    disk_->startJournal(write_ahead_log_);
+  }
+
+  return true;
+}
+
+bool StorageAdapter::Sync() {
+  if (write_ahead_log_ == nullptr) {
+    return writeChangedBlocks() && disk_->sync();
+  }
+
+  return logged_statements_ < checkpoint_interval_ || Checkpoint();
+}
+
+bool StorageAdapter::SaveImage(const std::string& file_name) {
+  if (!writeChangedBlocks()) {
+    DEBUG_MSG("Unable to write the changed blocks");
+    return false;
+  }
+
+  return schema_manager_->saveImage(file_name);
+}
+
+bool StorageAdapter::Checkpoint() {
+  if (write_ahead_log_ == nullptr) {
+    return true;
+  }
+
+  if (!write_ahead_log_->Sync() || !writeChangedBlocks() ||
+      !disk_->flush() || !write_ahead_log_->Truncate()) {
+    DEBUG_MSG("Unable to checkpoint the database file");
+    return false;
+  }
+
+  disk_->startJournal(write_ahead_log_);
+  logged_statements_ = 0;
+  return true;
+}
+
+bool StorageAdapter::LogStatement(const std::string& statement) {
+  if (write_ahead_log_ == nullptr) {
+    return true;
+  }
+
+  logged_statements_++;
+  return write_ahead_log_->Append(statement);
+}
+
+std::vector<std::string> StorageAdapter::RecoveredStatements() const {
+  return recovered_statements_;
+}
+
+bool StorageAdapter::CompactRelations() {
+  // The I/O is reported as its own operator rather than as the statement's,
+  // which is registered only when a relation has to be compacted
+  int tag = 0;
+  for (auto relation : free_space_map_->Relations()) {
+    if (!needsCompaction(relation)) {
+      continue;
+    }
+
+    if (tag == 0) {
+      tag = RegisterIoOperator("Compaction");
+    }
+
+    DiskAccessScope scope(tag);
+    if (!compactRelation(relation)) {
+      DEBUG_MSG("Unable to compact " << relation->getRelationName());
+      return false;
+    }
+  }
+
   return true;
 }
 
 void StorageAdapter::ResetDiskStats() {
   disk_->resetDiskIOs();
   disk_->resetDiskTimer();
+  buffer_pool_->ResetStats();
+  if (write_ahead_log_ != nullptr) {
+    write_ahead_log_->ResetStats();
+  }
 
-  disk_start_time_ = clock();
+  disk_start_time_ = std::chrono::steady_clock::now();
 }
 
 void StorageAdapter::PrintDiskStats() {
-  ERROR_MSG("Real elapse time = " << (
-      (double)(clock() - disk_start_time_) / CLOCKS_PER_SEC * 1000) << " ms");
+  std::chrono::duration<double, std::milli> elapsed_time =
+      std::chrono::steady_clock::now() - disk_start_time_;
+  ERROR_MSG("Real elapse time = " << elapsed_time.count() << " ms");
   ERROR_MSG("Calculated elapse time = " << disk_->getDiskTimer() << " ms");
   ERROR_MSG("Calculated Disk I/Os = " << disk_->getDiskIOs());
+  if (buffer_pool_->Size() > 0) {
+    ERROR_MSG("Buffer pool hits = " << buffer_pool_->Hits() <<
+        ", misses = " << buffer_pool_->Misses());
+  }
+
+  if (write_ahead_log_ != nullptr) {
+    ERROR_MSG("Log records = " << write_ahead_log_->Records() <<
+        ", syncs = " << write_ahead_log_->Syncs());
+  }
 }
 
-bool StorageAdapter::CreateRelation(const std::string& name,
-    const std::vector<std::string>& fields,
-    const std::vector<enum FIELD_TYPE>& field_types) const {
-  if (name.empty()) {
-    DEBUG_MSG("Empty relation name");
-    return false;
+void StorageAdapter::ResetIoStats() {
+  io_operators_.clear();
+  io_memory_blocks_.clear();
+  disk_->resetAccessStats();
+}
+
+int StorageAdapter::RegisterIoOperator(const std::string& name) {
+  io_operators_.push_back(name);
+  return io_operators_.size();
+}
+
+std::string StorageAdapter::IoReport(const std::string& statement) const {
+  std::map<std::string, DiskAccessStats> relations =
+      disk_->getRelationAccessStats();
+  std::map<int, DiskAccessStats> tags = disk_->getTagAccessStats();
+
+  DiskAccessStats total;
+  for (auto& relation : relations) {
+    total.reads += relation.second.reads;
+    total.writes += relation.second.writes;
+    total.blocks_read += relation.second.blocks_read;
+    total.blocks_written += relation.second.blocks_written;
+    total.time += relation.second.time;
   }
 
-  if (fields.empty() || fields.size() != field_types.size()) {
-    DEBUG_MSG("Number of fields not matching.");
-    return false;
+  std::ostringstream json;
+  json << "{\"statement\":" << JsonString(statement) << ",";
+  WriteJsonStats(json, total);
+
+  json << ",\"relations\":[";
+  for (auto relation = relations.begin(); relation != relations.end();
+      relation++) {
+    json << (relation == relations.begin() ? "" : ",") <<
+        "{\"relation\":" << JsonString(relation->first) << ",";
+    WriteJsonStats(json, relation->second);
+    json << "}";
   }
 
-  Schema schema(fields, field_types);
-  Relation *relation = schema_manager_->createRelation(name, schema);
-  if (relation == nullptr) {
-    DEBUG_MSG("Unable to create relation");
-    return false;
+  // Every operator is listed, with or without I/O
+  json << "],\"operators\":[{\"id\":0,\"operator\":\"Statement\",";
+  WriteJsonStats(json, tags[0]);
+  json << "}";
+  for (int tag = 1; tag <= io_operators_.size(); tag++) {
+    json << ",{\"id\":" << tag << ",\"operator\":" <<
+        JsonString(io_operators_[tag - 1]) << ",";
+    WriteJsonStats(json, tags[tag]);
+    json << "}";
   }
 
-  return true;
+  json << "]}";
+  return json.str();
+}
+
+DiskAccessStats StorageAdapter::IoOperatorStats(int tag) const {
+  std::map<int, DiskAccessStats> tags = disk_->getTagAccessStats();
+  return tags[tag];
+}
+
+int StorageAdapter::IoOperatorMemoryBlocks(int tag) const {
+  auto blocks = io_memory_blocks_.find(tag);
+  return blocks == io_memory_blocks_.end() ? 0 : blocks->second.size();
+}
+
+bool StorageAdapter::CreateRelation(const std::string& name,
+    const std::vector<std::string>& fields,
+    const std::vector<enum FIELD_TYPE>& field_types) const {
+  return createRelation(name, fields, field_types, compressed_tables_);
 }
 
 bool StorageAdapter::DeleteRelation(const std::string& name) const {
@@ -114,6 +438,11 @@ bool StorageAdapter::DeleteRelation(const std::string& name) const {
   return schema_manager_->deleteRelation(name);
 }
 
+Relation *StorageAdapter::GetRelation(
+    const std::string& relation_name) const {
+  return schema_manager_->getRelation(relation_name);
+}
+
 bool StorageAdapter::CreateEmptyTuple(const std::string& relation_name,
     Tuple& tuple) const {
   Relation *relation = schema_manager_->getRelation(relation_name);
@@ -135,7 +464,7 @@ Tuple StorageAdapter::CreateTuple(const std::string& relation_name,
     return Tuple::getDummyTuple();
   }
 
-  Schema schema = relation->getSchema();
+  const Schema& schema = relation->getSchemaRef();
   if (values.size() != schema.getNumOfFields()) {
     return Tuple::getDummyTuple();
   }
@@ -185,55 +514,78 @@ bool StorageAdapter::CreateTupleAndAppend(const std::string& relation_name,
     return false;
   }
 
-  appendTupleToRelation(relation, tuple);
-  return true;
+  return appendTupleToRelation(relation, tuple);
 }
 
 bool StorageAdapter::CreateTupleAndAppend(const std::string& relation_name,
     const std::vector<std::string>& field_names,
     const std::vector<std::string>& values) const {
+  return CreateTuplesAndAppend(relation_name, field_names,
+      TupleList(1, values));
+}
+
+bool StorageAdapter::CreateTuplesAndAppend(const std::string& relation_name,
+    const std::vector<std::string>& field_names, const TupleList& rows) const {
   Relation *relation = schema_manager_->getRelation(relation_name);
   if (relation == nullptr) {
     DEBUG_MSG("Invalid relation name");
     return false;
   }
 
-  Schema schema = relation->getSchema();
-  if (field_names.size() != values.size() ||
-      field_names.size() != schema.getNumOfFields()) {
+  const Schema& schema = relation->getSchemaRef();
+  if (field_names.size() != schema.getNumOfFields()) {
     DEBUG_MSG("Invalid fields for relation");
     return false;
   }
 
-  int index = 0;
-  Tuple tuple = relation->createTuple();
+  std::vector<int> offsets;
   for (auto field : field_names) {
-    if (!MatchFieldType(schema, field, values[index])) {
+    if (!schema.fieldNameExists(field)) {
+      DEBUG_MSG("Invalid field for relation: " << field);
       return false;
     }
 
-    if (schema.getFieldType(field) == INT) {
-      std::string integer_value = values[index];
-      if (values[index] == "NULL") {
-        integer_value = std::to_string(-1);
-      }
+    offsets.push_back(schema.getFieldOffset(field));
+  }
 
-      if (!tuple.setField(field, std::stoi(integer_value))) {
-        DEBUG_MSG("Invalid values for relation");
+  // Every row is checked before the first one is appended
+  std::vector<Tuple> tuples;
+  tuples.reserve(rows.size());
+  for (const auto& values : rows) {
+    if (values.size() != offsets.size()) {
+      DEBUG_MSG("Invalid fields for relation");
+      return false;
+    }
+
+    tuples.push_back(relation->createTuple());
+    for (int index = 0; index < offsets.size(); index++) {
+      if (!SetFieldValue(schema, offsets[index], values[index],
+          tuples.back())) {
         return false;
       }
-    } else if (schema.getFieldType(field) == STR20 &&
-        !tuple.setField(field, values[index])) {
-      return false;
     }
+  }
 
-    index++;
+  for (Tuple& tuple : tuples) {
+    if (!appendTupleToRelation(relation, tuple)) {
+      DEBUG_MSG("");
+      return false;
+    }
   }
 
-  appendTupleToRelation(relation, tuple);
   return true;
 }
 
+bool StorageAdapter::SetTupleField(Tuple& tuple, const int offset,
+    const std::string& value) const {
+  return SetFieldValue(tuple.getSchemaRef(), offset, value, tuple);
+}
+
+bool StorageAdapter::AppendTuple(Relation *relation,
+    const Tuple& tuple) const {
+  return appendTupleToRelation(relation, tuple);
+}
+
 bool StorageAdapter::DeleteTuples(const std::string& relation_name,
     const int start_index) const {
   Relation *relation = schema_manager_->getRelation(relation_name);
@@ -242,6 +594,10 @@ bool StorageAdapter::DeleteTuples(const std::string& relation_name,
     return false;
   }
 
+  append_buffer_->Discard(relation, start_index);
+  buffer_pool_->Discard(relation, start_index);
+  buffer_pool_->Flush(relation);
+  free_space_map_->Discard(relation, start_index);
   relation->deleteBlocks(start_index);
   return true;
 }
@@ -262,7 +618,7 @@ bool StorageAdapter::IsValidColumnName(const std::string& table_name,
     return false;
   }
 
-  Schema schema = relation->getSchema();
+  const Schema& schema = relation->getSchemaRef();
   if (!schema.fieldNameExists(attribute_name)) {
     ERROR_MSG("Invalid attribute name '" << attribute_name << \
         "' for table '" << table_name << "'");
@@ -280,7 +636,7 @@ bool StorageAdapter::AttributeType(const std::string& table_name,
     return false;
   }
 
-  type = relation->getSchema().getFieldType(attribute_name);
+  type = relation->getSchemaRef().getFieldType(attribute_name);
   if (type != INT && type != STR20) {
     DEBUG_MSG("");
     return false;
@@ -290,10 +646,17 @@ bool StorageAdapter::AttributeType(const std::string& table_name,
 }
 
 int StorageAdapter::MainMemorySize() const {
-  return main_memory_->getMemorySize();
+  return main_memory_->getMemorySize() - buffer_pool_->Size() -
+      read_ahead_->Size() - append_buffer_->Size();
+}
+
+Block *StorageAdapter::MainMemoryBlock(int memory_index) const {
+  useMemoryBlocks(memory_index, 1);
+  return main_memory_->getBlock(memory_index);
 }
 
 void StorageAdapter::SetMainMemoryBlock(int memory_index, Block *block) const {
+  useMemoryBlocks(memory_index, 1);
   main_memory_->setBlock(memory_index, *block);
 }
 
@@ -304,6 +667,16 @@ int StorageAdapter::RelationBlockSize(const std::string relation_name) const {
     return 0;
   }
 
+  return RelationBlockSize(relation);
+}
+
+int StorageAdapter::RelationBlockSize(Relation *relation) const {
+  if (relation == nullptr) {
+    DEBUG_MSG("Relation is null");
+    return 0;
+  }
+
+  append_buffer_->Flush(relation);
   return relation->getNumOfBlocks();
 }
 
@@ -314,6 +687,18 @@ int StorageAdapter::RelationTupleSize(const std::string relation_name) const {
     return 0;
   }
 
+  return RelationTupleSize(relation);
+}
+
+int StorageAdapter::RelationTupleSize(Relation *relation) const {
+  if (relation == nullptr) {
+    DEBUG_MSG("Relation is null");
+    return 0;
+  }
+
+  // A tail or a dirty frame may hold tuples the disk does not count yet
+  append_buffer_->Flush(relation);
+  buffer_pool_->Flush(relation);
   return relation->getNumOfTuples();
 }
 
@@ -328,29 +713,149 @@ bool StorageAdapter::ReadRelationBlocks(const std::string relation_name,
     return false;
   }
 
-  int adjusted_relation_num_blocks = relation_start_index + num_blocks >=
-      relation->getNumOfBlocks() ?
-          relation->getNumOfBlocks() - relation_start_index : num_blocks;
+  return ReadRelationBlocks(relation, relation_start_index,
+      memory_start_index, num_blocks, blocks);
+}
 
-  int adjusted_memory_num_blocks = memory_start_index + num_blocks >=
-      MainMemorySize() ?
-          MainMemorySize() - memory_start_index : num_blocks;
+bool StorageAdapter::ReadRelationBlocks(Relation *relation,
+    const int relation_start_index, const int memory_start_index,
+    const int num_blocks, std::vector<Block *>& blocks) const {
+  blocks.clear();
 
-  int adjusted_num_blocks = std::min(adjusted_relation_num_blocks,
-      adjusted_memory_num_blocks);
+  if (relation == nullptr) {
+    DEBUG_MSG("Relation is null");
+    return false;
+  }
 
+  append_buffer_->Flush(relation);
+  int adjusted_num_blocks = adjustedBlockCount(relation,
+      relation_start_index, memory_start_index, num_blocks);
   if (adjusted_num_blocks < 1) {
     DEBUG_MSG("");
     return false;
   }
 
-  if (!relation->getBlocks(relation_start_index, memory_start_index,
-      adjusted_num_blocks)) {
+  if (!buffer_pool_->ReadBlocks(relation, relation_start_index,
+      memory_start_index, adjusted_num_blocks)) {
     DEBUG_MSG("Index out of bound. Index: " << relation_start_index <<
-        ", Relation: " << relation_name);
+        ", Relation: " << relation->getRelationName());
+    return false;
+  }
+
+  useMemoryBlocks(memory_start_index, adjusted_num_blocks);
+  for (int it = memory_start_index;
+      it < memory_start_index + adjusted_num_blocks; it++) {
+    blocks.push_back(main_memory_->getBlock(it));
+  }
+
+  return true;
+}
+
+bool StorageAdapter::StartReadAhead(Relation *relation,
+    const int relation_start_index, const int num_blocks,
+    ReadAheadBatch& batch) const {
+  batch = ReadAheadBatch();
+  if (relation == nullptr || relation_start_index < 0) {
+    DEBUG_MSG("");
+    return false;
+  }
+
+  append_buffer_->Flush(relation);
+  int wanted_blocks = std::min(num_blocks,
+      relation->getNumOfBlocks() - relation_start_index);
+  if (wanted_blocks < 1) {
     return false;
   }
 
+  int memory_index = 0;
+  int reserved_blocks = read_ahead_->Reserve(wanted_blocks, memory_index);
+  if (reserved_blocks < 1) {
+    return false;
+  }
+
+  batch.relation = relation;
+  batch.block_index = relation_start_index;
+  batch.memory_index = memory_index;
+  batch.num_blocks = reserved_blocks;
+  batch.queued.assign(reserved_blocks, false);
+
+  // Every run of blocks missing from the buffer pool is one disk access
+  int offset = 0;
+  while (offset < reserved_blocks) {
+    if (buffer_pool_->Cached(relation, relation_start_index + offset)) {
+      offset++;
+      continue;
+    }
+
+    int run = 1;
+    while (offset + run < reserved_blocks &&
+        !buffer_pool_->Cached(relation, relation_start_index + offset + run)) {
+      run++;
+    }
+
+    batch.jobs.push_back(read_ahead_->Submit(relation,
+        relation_start_index + offset, memory_index + offset, run));
+    for (int index = offset; index < offset + run; index++) {
+      batch.queued[index] = true;
+    }
+
+    offset += run;
+  }
+
+  return true;
+}
+
+bool StorageAdapter::FinishReadAhead(ReadAheadBatch& batch,
+    const int memory_start_index, const int num_blocks,
+    std::vector<Block *>& blocks) const {
+  blocks.clear();
+
+  bool read = true;
+  for (auto job : batch.jobs) {
+    read = read_ahead_->Wait(job) && read;
+  }
+
+  Relation *relation = batch.relation;
+  int adjusted_num_blocks = adjustedBlockCount(relation, batch.block_index,
+      memory_start_index, num_blocks);
+
+  // A block read ahead is taken unless the pool got hold of it meanwhile;
+  // the others are read through the pool, in runs as long as possible
+  bool result = adjusted_num_blocks > 0;
+  int pending = 0;
+  for (int offset = 0; result && offset <= adjusted_num_blocks; offset++) {
+    bool usable = offset < adjusted_num_blocks && read &&
+        offset < batch.num_blocks && batch.queued[offset] &&
+        !buffer_pool_->Cached(relation, batch.block_index + offset);
+    if (offset < adjusted_num_blocks && !usable) {
+      pending++;
+      continue;
+    }
+
+    if (pending > 0) {
+      result = buffer_pool_->ReadBlocks(relation,
+          batch.block_index + offset - pending,
+          memory_start_index + offset - pending, pending);
+      pending = 0;
+    }
+
+    if (result && usable) {
+      main_memory_->setBlock(memory_start_index + offset,
+          *main_memory_->getBlock(batch.memory_index + offset));
+      buffer_pool_->Adopt(relation, batch.block_index + offset,
+          memory_start_index + offset);
+    }
+  }
+
+  read_ahead_->Release(batch.memory_index, batch.num_blocks);
+  batch = ReadAheadBatch();
+
+  if (!result) {
+    DEBUG_MSG("");
+    return false;
+  }
+
+  useMemoryBlocks(memory_start_index, adjusted_num_blocks);
   for (int it = memory_start_index;
       it < memory_start_index + adjusted_num_blocks; it++) {
     blocks.push_back(main_memory_->getBlock(it));
@@ -359,39 +864,90 @@ bool StorageAdapter::ReadRelationBlocks(const std::string relation_name,
   return true;
 }
 
+void StorageAdapter::CancelReadAhead(ReadAheadBatch& batch) const {
+  for (auto job : batch.jobs) {
+    read_ahead_->Wait(job);
+  }
+
+  if (batch.num_blocks > 0) {
+    read_ahead_->Release(batch.memory_index, batch.num_blocks);
+  }
+
+  batch = ReadAheadBatch();
+}
+
 bool StorageAdapter::InsertBlocksToRelation(const std::string relation_name,
     const int memory_start_index, const int relation_start_index,
     const int num_blocks) const {
+  Relation *relation = schema_manager_->getRelation(relation_name);
+  if (relation == nullptr) {
+    ERROR_MSG("Invalid relation name: " << relation_name);
+    return false;
+  }
+
+  return InsertBlocksToRelation(relation, memory_start_index,
+      relation_start_index, num_blocks);
+}
+
+bool StorageAdapter::InsertBlocksToRelation(Relation *relation,
+    const int memory_start_index, const int relation_start_index,
+    const int num_blocks) const {
+  if (relation == nullptr) {
+    DEBUG_MSG("Relation is null");
+    return false;
+  }
+
   if (memory_start_index > MainMemorySize()) {
     ERROR_MSG("Invalid main memory index: " << memory_start_index);
     return false;
   }
 
+  append_buffer_->Drop(relation);
+  if (!buffer_pool_->WriteBlocks(relation, relation_start_index,
+      memory_start_index, num_blocks)) {
+    return false;
+  }
+
+  useMemoryBlocks(memory_start_index, num_blocks);
+  updateFreeSpace(relation, memory_start_index, relation_start_index,
+      num_blocks);
+  return true;
+}
+
+bool StorageAdapter::AppendBlocksToRelation(const std::string relation_name,
+    const int memory_start_index, const int num_blocks) const {
   Relation *relation = schema_manager_->getRelation(relation_name);
   if (relation == nullptr) {
     ERROR_MSG("Invalid relation name: " << relation_name);
     return false;
   }
 
-  return relation->setBlocks(relation_start_index,
-      memory_start_index, num_blocks);
+  return AppendBlocksToRelation(relation, memory_start_index, num_blocks);
 }
 
-bool StorageAdapter::AppendBlocksToRelation(const std::string relation_name,
+bool StorageAdapter::AppendBlocksToRelation(Relation *relation,
     const int memory_start_index, const int num_blocks) const {
+  if (relation == nullptr) {
+    DEBUG_MSG("Relation is null");
+    return false;
+  }
+
   if (memory_start_index > MainMemorySize()) {
     ERROR_MSG("Invalid main memory index: " << memory_start_index);
     return false;
   }
 
-  Relation *relation = schema_manager_->getRelation(relation_name);
-  if (relation == nullptr) {
-    ERROR_MSG("Invalid relation name: " << relation_name);
+  append_buffer_->Drop(relation);
+  int relation_start_index = relation->getNumOfBlocks();
+  if (!relation->setBlocks(relation_start_index, memory_start_index,
+      num_blocks)) {
     return false;
   }
 
-  return relation->setBlocks(relation->getNumOfBlocks(),
-      memory_start_index, num_blocks);
+  useMemoryBlocks(memory_start_index, num_blocks);
+  updateFreeSpace(relation, memory_start_index, relation_start_index,
+      num_blocks);
+  return true;
 }
 
 bool StorageAdapter::DeleteRelationBlocks(const std::string relation_name,
@@ -402,15 +958,19 @@ bool StorageAdapter::DeleteRelationBlocks(const std::string relation_name,
     return false;
   }
 
+  append_buffer_->Discard(relation, start_index);
+  buffer_pool_->Discard(relation, start_index);
+  buffer_pool_->Flush(relation);
+  free_space_map_->Discard(relation, start_index);
   return relation->deleteBlocks(start_index);
 }
 
 bool StorageAdapter::CreateDummyRelation(const std::string name_prefix,
     std::vector<std::string> field_names, std::string& relation_name) {
-  relation_name = name_prefix + std::to_string(rand());
+  relation_name = temporaryRelationName(name_prefix);
   std::vector<enum FIELD_TYPE> field_types(field_names.size(), STR20);
 
-  if (!CreateRelation(relation_name, field_names, field_types)) {
+  if (!createRelation(relation_name, field_names, field_types, false)) {
     DEBUG_MSG("");
     return false;
   }
@@ -421,9 +981,9 @@ bool StorageAdapter::CreateDummyRelation(const std::string name_prefix,
 bool StorageAdapter::CreateDummyRelation(const std::string name_prefix,
     std::vector<std::string>& field_names,
     std::vector<enum FIELD_TYPE>& field_types, std::string& relation_name) {
-  relation_name = name_prefix + std::to_string(rand());
+  relation_name = temporaryRelationName(name_prefix);
 
-  if (!CreateRelation(relation_name, field_names, field_types)) {
+  if (!createRelation(relation_name, field_names, field_types, false)) {
     DEBUG_MSG("");
     return false;
   }
@@ -432,11 +992,16 @@ bool StorageAdapter::CreateDummyRelation(const std::string name_prefix,
 }
 
 bool StorageAdapter::DeleteDummyRelation(std::string relation_name) {
+  Relation *relation = schema_manager_->getRelation(relation_name);
+  append_buffer_->Discard(relation, 0);
+  buffer_pool_->Discard(relation, 0);
+  free_space_map_->Discard(relation, 0);
   return schema_manager_->deleteRelation(relation_name);
 }
 
 void StorageAdapter::ClearBlock(int index) const {
   if (index < MainMemorySize()) {
+    useMemoryBlocks(index, 1);
     Block *block = main_memory_->getBlock(index);
     block->clear();
   }
@@ -444,19 +1009,31 @@ void StorageAdapter::ClearBlock(int index) const {
 
 bool StorageAdapter::AppendTupleUsing(const std::string relation_name,
     Tuple& tuple, const int index) const {
-  if (index >= MainMemorySize()) {
-    DEBUG_MSG("Overflow. Invalid memory block.");
+  Relation *relation = schema_manager_->getRelation(relation_name);
+  if (relation == nullptr) {
+    DEBUG_MSG("Invalid relation name: " << relation_name);
     return false;
   }
 
-  Relation *relation = schema_manager_->getRelation(relation_name);
+  return AppendTupleUsing(relation, tuple, index);
+}
+
+bool StorageAdapter::AppendTupleUsing(Relation *relation,
+    Tuple& tuple, const int index) const {
   if (relation == nullptr) {
-    DEBUG_MSG("Invalid relation name: " << relation_name);
+    DEBUG_MSG("Relation is null");
+    return false;
+  }
+
+  if (index >= MainMemorySize()) {
+    DEBUG_MSG("Overflow. Invalid memory block.");
     return false;
   }
 
+  append_buffer_->Drop(relation);
+  useMemoryBlocks(index, 1);
   Block *block = main_memory_->getBlock(index);
-  if (block->isFull()) {
+  if (!block->isEmpty() && !block->hasRoomFor(tuple)) {
     relation->setBlock(relation->getNumOfBlocks(), index);
     block->clear();
   }
@@ -467,17 +1044,29 @@ bool StorageAdapter::AppendTupleUsing(const std::string relation_name,
 
 bool StorageAdapter::PushLastBlock(const std::string relation_name,
     const int index) const {
-  if (index >= MainMemorySize()) {
-    DEBUG_MSG("Overflow. Invalid memory block.");
+  Relation *relation = schema_manager_->getRelation(relation_name);
+  if (relation == nullptr) {
+    DEBUG_MSG("Invalid relation name: " << relation_name);
     return false;
   }
 
-  Relation *relation = schema_manager_->getRelation(relation_name);
+  return PushLastBlock(relation, index);
+}
+
+bool StorageAdapter::PushLastBlock(Relation *relation,
+    const int index) const {
   if (relation == nullptr) {
-    DEBUG_MSG("Invalid relation name: " << relation_name);
+    DEBUG_MSG("Relation is null");
     return false;
   }
 
+  if (index >= MainMemorySize()) {
+    DEBUG_MSG("Overflow. Invalid memory block.");
+    return false;
+  }
+
+  append_buffer_->Drop(relation);
+  useMemoryBlocks(index, 1);
   Block *block = main_memory_->getBlock(index);
   if (!block->isEmpty()) {
     relation->setBlock(relation->getNumOfBlocks(), index);
@@ -495,7 +1084,7 @@ bool StorageAdapter::RelationFieldNames(std::string relation_name,
     return false;
   }
 
-  Schema schema = relation->getSchema();
+  const Schema& schema = relation->getSchemaRef();
   field_names = schema.getFieldNames();
   if (field_names.size() == 0) {
     DEBUG_MSG("");
@@ -514,22 +1103,25 @@ bool StorageAdapter::Tuples(const std::string relation_name,
     return false;
   }
 
+  append_buffer_->Flush(relation);
   int block_count = relation->getNumOfBlocks();
   int last_count = 0;
 
   while (block_count > 0) {
     int current_block_count = block_count > MainMemorySize() ?
         MainMemorySize() : block_count;
-    if (!relation->getBlocks(last_count, 0, current_block_count)) {
+    if (!buffer_pool_->ReadBlocks(relation, last_count, 0,
+        current_block_count)) {
       DEBUG_MSG("");
       return false;
     }
 
     std::vector<Tuple> tuples = main_memory_->getTuples(0, current_block_count);
-    for (auto tuple : tuples) {
+    const Schema& schema = relation->getSchemaRef();
+    for (const Tuple& tuple : tuples) {
       std::vector<std::string> fields;
       for (int index = 0; index < tuple.getNumOfFields(); index++) {
-        if (tuple.getSchema().getFieldType(index) == INT) {
+        if (schema.getFieldType(index) == INT) {
           int value = tuple.getField(index).integer;
           std::string integer_value = std::to_string(value);
           if (value == -1) {
@@ -537,7 +1129,7 @@ bool StorageAdapter::Tuples(const std::string relation_name,
           }
 
           fields.push_back(integer_value);
-        } else if (tuple.getSchema().getFieldType(index) == STR20) {
+        } else if (schema.getFieldType(index) == STR20) {
           fields.push_back(*(tuple.getField(index).str));
         } else {
           DEBUG_MSG("");
@@ -564,7 +1156,8 @@ void StorageAdapter::PrintTupleList(const std::string relation_name,
     return;
   }
 
-  std::vector<std::string> field_names = relation->getSchema().getFieldNames();
+  std::vector<std::string> field_names =
+      relation->getSchemaRef().getFieldNames();
 
   DEBUG_MSG_SINGLE_LINE("\n");
   DEBUG_MSG_SINGLE_LINE(
@@ -595,45 +1188,159 @@ void StorageAdapter::PrintTupleList(const std::string relation_name,
 
 // Private methods
 void StorageAdapter::reset() {
-  available_memory_index_ = 0;
+  // The read-ahead thread is stopped before the disk goes
+  delete read_ahead_;
+  append_buffer_->FlushAll();
+  delete append_buffer_;
+  delete free_space_map_;
+  buffer_pool_->FlushAll();
+  delete buffer_pool_;
   delete disk_;
+  // The disk journals the pages it writes when it goes
+  delete write_ahead_log_;
+  write_ahead_log_ = nullptr;
   delete main_memory_;
   delete schema_manager_;
 }
 
-void StorageAdapter::appendTupleToRelation(Relation* relation,
-    Tuple& tuple) const {
+bool StorageAdapter::writeChangedBlocks() const {
+  return append_buffer_->FlushAll() && buffer_pool_->FlushAll();
+}
+
+bool StorageAdapter::createRelation(const std::string& name,
+    const std::vector<std::string>& fields,
+    const std::vector<enum FIELD_TYPE>& field_types,
+    const bool compressed) const {
+  if (name.empty()) {
+    DEBUG_MSG("Empty relation name");
+    return false;
+  }
+
+  if (fields.empty() || fields.size() != field_types.size()) {
+    DEBUG_MSG("Number of fields not matching.");
+    return false;
+  }
+
+  Schema schema(fields, field_types);
+  schema.setCompressed(compressed);
+  Relation *relation = schema_manager_->createRelation(name, schema);
+  if (relation == nullptr) {
+    DEBUG_MSG("Unable to create relation");
+    return false;
+  }
+
+  return true;
+}
+
+std::string StorageAdapter::temporaryRelationName(
+    const std::string& name_prefix) {
+  // A table name never contains '_', so only an earlier temporary relation
+  // left in the database file can hold the name
+  std::string relation_name;
+  do {
+    relation_name = name_prefix + std::to_string(temporary_relation_count_++);
+  } while (schema_manager_->relationExists(relation_name));
+
+  return relation_name;
+}
+
+bool StorageAdapter::appendTupleToRelation(Relation* relation,
+    const Tuple& tuple) const {
   if (relation == nullptr) {
     DEBUG_MSG("Relation is null");
-    return;
+    return false;
   }
 
-  Block *block;
-  if (relation->getNumOfBlocks() == 0) {
-    LOG_MSG("The relation is empty. creating new block...");
-    block = main_memory_->getBlock(available_memory_index_);
-    block->clear();
-    block->appendTuple(tuple);
-    relation->setBlock(relation->getNumOfBlocks(), available_memory_index_);
-  } else {
-    LOG_MSG("The relation is not empty.");
-    relation->getBlock(relation->getNumOfBlocks() - 1, available_memory_index_);
-    block = main_memory_->getBlock(available_memory_index_);
-
-    if (block->isFull()) {
-      LOG_MSG("Block is full, creating new block...");
-      block->clear();
-      block->appendTuple(tuple);
-      relation->setBlock(relation->getNumOfBlocks(), available_memory_index_);
-    } else {
-      LOG_MSG("Block is not full, appending...");
-      block->appendTuple(tuple);
-      relation->setBlock(relation->getNumOfBlocks() - 1,
-          available_memory_index_);
+  // The last block stays in the append buffer until it is full or flushed
+  if (!append_buffer_->Append(relation, tuple)) {
+    DEBUG_MSG("Unable to append to " << relation->getRelationName());
+    return false;
+  }
+
+  return true;
+}
+
+void StorageAdapter::updateFreeSpace(Relation *relation,
+    const int memory_start_index, const int relation_start_index,
+    const int num_blocks) const {
+  for (int offset = 0; offset < num_blocks; offset++) {
+    free_space_map_->Update(relation, relation_start_index + offset,
+        *main_memory_->getBlock(memory_start_index + offset));
+  }
+}
+
+bool StorageAdapter::needsCompaction(Relation *relation) const {
+  int num_blocks = RelationBlockSize(relation);
+  long capacity = (long) num_blocks *
+      relation->getSchemaRef().getTuplesPerBlock();
+  long used = capacity - free_space_map_->FreeSlots(relation);
+  if (relation->getSchemaRef().isCompressed()) {
+    // The slots of a compressed block depend on its values
+    used = RelationTupleSize(relation);
+    capacity = used + free_space_map_->FreeSlots(relation);
+  }
+
+  int first_block = free_space_map_->FirstBlock(relation);
+  return used * 100 < capacity * compaction_threshold_ && first_block >= 0 &&
+      first_block < num_blocks - 1;
+}
+
+bool StorageAdapter::compactRelation(Relation *relation) {
+  // The tuples of the last block are appended again, which puts them into
+  // the first holes, until the relation is dense enough or no hole is left
+  // before the last block. Every block moved fills holes, so the statement
+  // that made the relation sparse brings it back above the threshold.
+  while (needsCompaction(relation)) {
+    int num_blocks = RelationBlockSize(relation);
+    long free_slots = free_space_map_->FreeSlots(relation);
+    std::vector<Block *> blocks;
+    if (!ReadRelationBlocks(relation, num_blocks - 1, 0, 1, blocks)) {
+      DEBUG_MSG("");
+      return false;
+    }
+
+    std::vector<Tuple> tuples;
+    for (const Tuple& tuple : *blocks[0]) {
+      if (!tuple.isNull()) {
+        tuples.push_back(tuple);
+      }
+    }
+
+    blocks[0]->clear();
+    if (!DeleteRelationBlocks(relation->getRelationName(), num_blocks - 1)) {
+      DEBUG_MSG("");
+      return false;
+    }
+
+    for (const Tuple& tuple : tuples) {
+      if (!appendTupleToRelation(relation, tuple)) {
+        DEBUG_MSG("");
+        return false;
+      }
+    }
+
+    // No hole took a tuple, as in compressed blocks too full for the values
+    if (RelationBlockSize(relation) >= num_blocks &&
+        free_space_map_->FreeSlots(relation) >= free_slots) {
+      return true;
     }
   }
 
-  block->clear();
+  return true;
+}
+
+int StorageAdapter::adjustedBlockCount(Relation *relation,
+    const int relation_start_index, const int memory_start_index,
+    const int num_blocks) const {
+  int adjusted_relation_num_blocks = relation_start_index + num_blocks >=
+      relation->getNumOfBlocks() ?
+          relation->getNumOfBlocks() - relation_start_index : num_blocks;
+
+  int adjusted_memory_num_blocks = memory_start_index + num_blocks >=
+      MainMemorySize() ?
+          MainMemorySize() - memory_start_index : num_blocks;
+
+  return std::min(adjusted_relation_num_blocks, adjusted_memory_num_blocks);
 }
 
 void StorageAdapter::clearMainMemoryBlocks() const {
@@ -642,3 +1349,12 @@ void StorageAdapter::clearMainMemoryBlocks() const {
     block->clear();
   }
 }
+
+void StorageAdapter::useMemoryBlocks(const int memory_start_index,
+    const int num_blocks) const {
+  std::set<int>& blocks = io_memory_blocks_[Disk::getAccessTag()];
+  for (int index = memory_start_index;
+      index < memory_start_index + num_blocks; index++) {
+    blocks.insert(index);
+  }
+}
@@ -1,27 +1,109 @@
 #ifndef SRC_STORAGE_ADAPTER_H
 #define SRC_STORAGE_ADAPTER_H
 
+#include <chrono>
+#include <map>
+#include <set>
 #include <string>
 #include <vector>
 
+#include "storage/append_buffer.h"
+#include "storage/buffer_pool.h"
+#include "storage/free_space_map.h"
+#include "storage/read_ahead.h"
 #include "storage/storage_manager_headers.h"
+#include "storage/write_ahead_log.h"
 
 typedef std::vector<std::vector<std::string> > TupleList;
 
+// Sizes and settings of the storage manager, chosen at startup
+struct StorageConfig {
+  StorageConfig();
+
+  int memory_blocks;
+  int fields_per_block;
+  // Main memory blocks kept by the buffer pool, besides memory_blocks
+  int buffer_frames;
+  // Main memory blocks sequential scans read ahead into, after the frames
+  int read_ahead_blocks;
+  // Main memory blocks holding the last block of the relations being
+  // inserted into, after the read-ahead blocks
+  int append_blocks;
+  // Relations whose blocks are filled below this percentage are compacted
+  int compaction_threshold;
+  // The blocks of the tables created are stored compressed
+  bool compressed_tables;
+  // Logs the statements that change the database file instead of writing
+  // its blocks after every statement; the log is synced every
+  // group_commit_size statements and emptied every checkpoint_interval
+  bool write_ahead_log;
+  int group_commit_size;
+  int checkpoint_interval;
+  DiskLatencyModel disk_latency;
+  // Keeps the relations in this file when set
+  std::string database_file;
+  // Starts from the image written by SaveImage(): its tracks are read into
+  // memory, or it replaces the database file
+  std::string restore_file;
+};
+
+// Tags the disk accesses of the calling thread while it is in scope, so the
+// I/O report accounts them to an operator
+class DiskAccessScope {
+ public:
+  explicit DiskAccessScope(int tag);
+  ~DiskAccessScope();
+
+ private:
+  int previous_tag_;
+};
+
 class StorageAdapter {
  public:
   // Singleton method
   static StorageAdapter *Get();
 
-  bool Initialize();
+  // Recreates an empty storage; reopens the relations of the database file
+  bool Initialize(const StorageConfig& config);
+  // Called after every statement: writes the changed blocks, or with the
+  // write-ahead log checkpoints every checkpoint_interval statements
+  bool Sync();
+  // Writes the tables and their blocks to an image file, with the tracks on
+  // consecutive pages, for restore_file to start from
+  bool SaveImage(const std::string& file_name);
+  // Writes the changed blocks and the page tables, syncs the database file
+  // and empties the log
+  bool Checkpoint();
+  // Appends a statement that changed the database to the log, if there is one
+  bool LogStatement(const std::string& statement);
+  // The statements to run again, found in the log when it was opened
+  std::vector<std::string> RecoveredStatements() const;
+  // Moves the tuples of the last blocks of sparse relations into the holes
+  // of their earlier blocks, until each is dense enough again
+  bool CompactRelations();
 
   void ResetDiskStats();
   void PrintDiskStats();
 
+  // The I/O report breaks the disk accesses since ResetIoStats() down by
+  // relation and by operator, as one line of JSON. Operators register the
+  // name they are reported with and tag their accesses with the id returned;
+  // the untagged accesses are reported as the statement's.
+  void ResetIoStats();
+  int RegisterIoOperator(const std::string& name);
+  std::string IoReport(const std::string& statement) const;
+  // The disk accesses of one operator, and the main memory blocks it placed
+  // blocks in or appended tuples to, since ResetIoStats()
+  DiskAccessStats IoOperatorStats(int tag) const;
+  int IoOperatorMemoryBlocks(int tag) const;
+
   bool CreateRelation(const std::string& name,
                       const std::vector<std::string>& fields,
                       const std::vector<enum FIELD_TYPE>& field_types) const;
   bool DeleteRelation(const std::string& name) const;
+  // Returns nullptr if the relation does not exist. The pointer stays valid
+  // until the relation is deleted, so operators can resolve a relation once.
+  Relation *GetRelation(const std::string& relation_name) const;
   bool CreateEmptyTuple(const std::string& relation_name, Tuple& tuple) const;
   Tuple CreateTuple(const std::string& relation_name,
       const std::vector<std::string>& values, bool& created) const;
@@ -30,6 +112,16 @@ class StorageAdapter {
   bool CreateTupleAndAppend(const std::string& relation_name,
       const std::vector<std::string>& field_names,
       const std::vector<std::string>& values) const;
+  // Appends one tuple per row, with the values in field_names order. Nothing
+  // is appended unless all the rows are valid.
+  bool CreateTuplesAndAppend(const std::string& relation_name,
+      const std::vector<std::string>& field_names,
+      const TupleList& rows) const;
+  // Checks and sets a field from its value as written in INSERT
+  bool SetTupleField(Tuple& tuple, const int offset,
+      const std::string& value) const;
+  // Appends a tuple of the relation, through the append buffer
+  bool AppendTuple(Relation *relation, const Tuple& tuple) const;
   bool DeleteTuples(const std::string& relation_name,
       const int start_index) const;
   bool DeleteAllTuples(const std::string& relation_name) const;
@@ -41,17 +133,39 @@ class StorageAdapter {
       const std::string& attribute_name, enum FIELD_TYPE& type);
 
   int MainMemorySize() const;
+  Block *MainMemoryBlock(int memory_index) const;
   void SetMainMemoryBlock(int memory_index, Block *block) const;
   int RelationBlockSize(const std::string relation_name) const;
+  int RelationBlockSize(Relation *relation) const;
   int RelationTupleSize(const std::string relation_name) const;
+  int RelationTupleSize(Relation *relation) const;
   bool ReadRelationBlocks(const std::string relation_name,
       const int relation_start_index, const int memory_start_index,
       const int num_blocks, std::vector<Block *>& blocks) const;
+  bool ReadRelationBlocks(Relation *relation,
+      const int relation_start_index, const int memory_start_index,
+      const int num_blocks, std::vector<Block *>& blocks) const;
+  // Starts reading up to num_blocks blocks from relation_start_index on the
+  // read-ahead thread; only the blocks the buffer pool does not hold are read.
+  // Returns false when no read-ahead memory is free or no block is left.
+  bool StartReadAhead(Relation *relation, const int relation_start_index,
+      const int num_blocks, ReadAheadBatch& batch) const;
+  // Waits for the batch and places num_blocks blocks from its first one in
+  // memory like ReadRelationBlocks(); the blocks it did not get to are read
+  // here. Releases the read-ahead memory either way.
+  bool FinishReadAhead(ReadAheadBatch& batch, const int memory_start_index,
+      const int num_blocks, std::vector<Block *>& blocks) const;
+  void CancelReadAhead(ReadAheadBatch& batch) const;
   bool InsertBlocksToRelation(const std::string relation_name,
       const int memory_start_index, const int relation_start_index,
       const int num_blocks) const;
+  bool InsertBlocksToRelation(Relation *relation,
+      const int memory_start_index, const int relation_start_index,
+      const int num_blocks) const;
   bool AppendBlocksToRelation(const std::string relation_name,
       const int memory_start_index, const int num_blocks) const;
+  bool AppendBlocksToRelation(Relation *relation,
+      const int memory_start_index, const int num_blocks) const;
   bool DeleteRelationBlocks(const std::string relation_name,
       const int start_index) const;
 
@@ -64,7 +178,10 @@ class StorageAdapter {
   void ClearBlock(int index) const;
   bool AppendTupleUsing(const std::string relation_name, Tuple& tuple,
       const int index) const;
+  bool AppendTupleUsing(Relation *relation, Tuple& tuple,
+      const int index) const;
   bool PushLastBlock(const std::string relation_name, const int index) const;
+  bool PushLastBlock(Relation *relation, const int index) const;
   bool RelationFieldNames(std::string relation_name,
       std::vector<std::string>& field_names);
 
@@ -79,17 +196,47 @@ class StorageAdapter {
   ~StorageAdapter();
 
   void reset();
-  void appendTupleToRelation(Relation* relation, Tuple& tuple) const;
+  bool writeChangedBlocks() const;
+  std::string temporaryRelationName(const std::string& name_prefix);
+  bool createRelation(const std::string& name,
+      const std::vector<std::string>& fields,
+      const std::vector<enum FIELD_TYPE>& field_types,
+      const bool compressed) const;
+  bool appendTupleToRelation(Relation* relation, const Tuple& tuple) const;
+  void updateFreeSpace(Relation *relation, const int memory_start_index,
+      const int relation_start_index, const int num_blocks) const;
+  bool needsCompaction(Relation *relation) const;
+  bool compactRelation(Relation *relation);
   void clearMainMemoryBlocks() const;
+  void useMemoryBlocks(const int memory_start_index,
+      const int num_blocks) const;
+  int adjustedBlockCount(Relation *relation, const int relation_start_index,
+      const int memory_start_index, const int num_blocks) const;
 
-  // Memory manager
-  int available_memory_index_;
+  std::chrono::steady_clock::time_point disk_start_time_;
 
-  clock_t disk_start_time_;
+  // Numbers the temporary relations of this run
+  unsigned long temporary_relation_count_;
+  // The operators of the I/O report, by access tag - 1
+  std::vector<std::string> io_operators_;
+  // The main memory blocks used, by access tag
+  mutable std::map<int, std::set<int> > io_memory_blocks_;
 
   Disk *disk_;
   MainMemory *main_memory_;
   SchemaManager *schema_manager_;
+  BufferPool *buffer_pool_;
+  ReadAhead *read_ahead_;
+  FreeSpaceMap *free_space_map_;
+  // nullptr without the write-ahead log
+  WriteAheadLog *write_ahead_log_;
+  std::vector<std::string> recovered_statements_;
+  int checkpoint_interval_;
+  // Statements logged since the last checkpoint
+  int logged_statements_;
+  AppendBuffer *append_buffer_;
+  int compaction_threshold_;
+  bool compressed_tables_;
 
   // Singleton instance
   static StorageAdapter *storage_adapter_;
@@ -0,0 +1,231 @@
+#include "storage/write_ahead_log.h"
+
+#include <cstdint>
+#include <cstring>
+#include <set>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "base/debug.h"
+
+const char log_magic[8] = {'T', 'i', 'n', 'y', 'W', 'A', 'L', '1'};
+const char statement_record = 'S';
+const char page_record = 'P';
+
+// FNV-1a, to find a record cut short by a crash
+uint32_t inline Checksum(const char *data, size_t size) {
+  uint32_t hash = 2166136261u;
+  for (size_t index = 0; index < size; index++) {
+    hash = (hash ^ (unsigned char) data[index]) * 16777619u;
+  }
+
+  return hash;
+}
+
+bool inline WriteAll(int file, const char *data, size_t size) {
+  while (size > 0) {
+    ssize_t written = ::write(file, data, size);
+    if (written <= 0) {
+      return false;
+    }
+
+    data += written;
+    size -= written;
+  }
+
+  return true;
+}
+
+WriteAheadLog::WriteAheadLog(int group_size)
+  : file_(-1),
+    group_size_(group_size),
+    unsynced_(0),
+    records_(0),
+    syncs_(0) {
+}
+
+WriteAheadLog::~WriteAheadLog() {
+  if (file_ >= 0) {
+    Sync();
+    ::close(file_);
+  }
+}
+
+bool WriteAheadLog::Open(const std::string& database_file,
+    std::vector<std::string>& statements) {
+  std::string file_name = database_file + ".wal";
+  file_ = ::open(file_name.c_str(), O_RDWR | O_CREAT, 0644);
+  if (file_ < 0) {
+    ERROR_MSG("Unable to open the log: " << file_name);
+    return false;
+  }
+
+  std::string log;
+  char buffer[DISK_PAGE_SIZE];
+  ssize_t size;
+  while ((size = ::read(file_, buffer, sizeof(buffer))) > 0) {
+    log.append(buffer, size);
+  }
+
+  if (size < 0) {
+    ERROR_MSG("Unable to read the log: " << file_name);
+    return false;
+  }
+
+  if (log.empty()) {
+    unsynced_ = 1;
+    return WriteAll(file_, log_magic, sizeof(log_magic)) && Sync();
+  }
+
+  if (log.compare(0, sizeof(log_magic), log_magic, sizeof(log_magic)) != 0) {
+    ERROR_MSG(file_name << " is not a log");
+    return false;
+  }
+
+  // The first copy of a page is the one of the checkpoint; a record cut
+  // short by a crash ends the log
+  size_t position = sizeof(log_magic);
+  std::set<int> restored_pages;
+  int database = -1;
+  bool restored = true;
+  while (restored && position + 2 * sizeof(uint32_t) < log.size()) {
+    uint32_t length, checksum;
+    memcpy(&length, log.data() + position, sizeof(length));
+    memcpy(&checksum, log.data() + position + sizeof(length), sizeof(checksum));
+    const char *record = log.data() + position + 2 * sizeof(uint32_t);
+    if (length == 0 ||
+        length > log.size() - position - 2 * sizeof(uint32_t) ||
+        Checksum(record, length) != checksum) {
+      break;
+    }
+
+    std::string payload(record + 1, length - 1);
+    if (record[0] == statement_record) {
+      statements.push_back(payload);
+    } else if (record[0] == page_record &&
+        payload.size() == sizeof(int) + DISK_PAGE_SIZE) {
+      int page;
+      memcpy(&page, payload.data(), sizeof(page));
+      if (restored_pages.insert(page).second) {
+        restored = restorePage(database_file, page,
+            payload.data() + sizeof(page), database);
+      }
+    }
+
+    position += 2 * sizeof(uint32_t) + length;
+  }
+
+  if (database >= 0) {
+    restored = fsync(database) == 0 && restored;
+    ::close(database);
+  }
+
+  if (!restored) {
+    ERROR_MSG("Unable to put the logged pages back into " << database_file);
+    return false;
+  }
+
+  // Records are appended after the last whole one
+  if (ftruncate(file_, position) != 0 || lseek(file_, 0, SEEK_END) < 0) {
+    ERROR_MSG("Unable to truncate the log: " << file_name);
+    return false;
+  }
+
+  return true;
+}
+
+bool WriteAheadLog::Append(const std::string& statement) {
+  if (!append(statement_record, statement)) {
+    DEBUG_MSG("");
+    return false;
+  }
+
+  unsynced_++;
+  return unsynced_ < group_size_ || Sync();
+}
+
+bool WriteAheadLog::Sync() {
+  if (unsynced_ == 0) {
+    return true;
+  }
+
+  if (fsync(file_) != 0) {
+    DEBUG_MSG("Unable to sync the log");
+    return false;
+  }
+
+  syncs_++;
+  unsynced_ = 0;
+  return true;
+}
+
+bool WriteAheadLog::Truncate() {
+  if (ftruncate(file_, sizeof(log_magic)) != 0 ||
+      lseek(file_, 0, SEEK_END) < 0) {
+    DEBUG_MSG("Unable to truncate the log");
+    return false;
+  }
+
+  unsynced_ = 1;
+  return Sync();
+}
+
+void WriteAheadLog::ResetStats() {
+  records_ = 0;
+  syncs_ = 0;
+}
+
+unsigned long WriteAheadLog::Records() const {
+  return records_;
+}
+
+unsigned long WriteAheadLog::Syncs() const {
+  return syncs_;
+}
+
+bool WriteAheadLog::savePage(int page, const char* data) {
+  std::string payload(reinterpret_cast<const char *>(&page), sizeof(page));
+  payload.append(data, DISK_PAGE_SIZE);
+  if (!append(page_record, payload)) {
+    DEBUG_MSG("");
+    return false;
+  }
+
+  // The page is overwritten right after, so it cannot wait for the group
+  unsynced_++;
+  return Sync();
+}
+
+// Private methods
+bool WriteAheadLog::append(const char type, const std::string& payload) {
+  std::string record(2 * sizeof(uint32_t), '\0');
+  record += type;
+  record += payload;
+
+  uint32_t length = record.size() - 2 * sizeof(uint32_t);
+  uint32_t checksum = Checksum(record.data() + 2 * sizeof(uint32_t), length);
+  memcpy(&record[0], &length, sizeof(length));
+  memcpy(&record[sizeof(length)], &checksum, sizeof(checksum));
+  if (!WriteAll(file_, record.data(), record.size())) {
+    DEBUG_MSG("Unable to write to the log");
+    return false;
+  }
+
+  records_++;
+  return true;
+}
+
+bool WriteAheadLog::restorePage(const std::string& database_file,
+    const int page, const char *data, int& database) {
+  if (database < 0) {
+    database = ::open(database_file.c_str(), O_RDWR | O_CREAT, 0644);
+    if (database < 0) {
+      DEBUG_MSG("Unable to open " << database_file);
+      return false;
+    }
+  }
+
+  return pwrite(database, data, DISK_PAGE_SIZE,
+      (off_t) page * DISK_PAGE_SIZE) == DISK_PAGE_SIZE;
+}
@@ -0,0 +1,57 @@
+#ifndef SRC_STORAGE_WRITE_AHEAD_LOG_H
+#define SRC_STORAGE_WRITE_AHEAD_LOG_H
+
+#include <string>
+#include <vector>
+
+#include "storage/storage_manager_headers.h"
+
+// The redo log of a database file, kept next to it with a .wal suffix. Every
+// statement that changes the database is appended once it ran, and the
+// records are synced in groups, so one fsync makes a group of statements
+// durable. Between checkpoints the blocks stay in main memory or are written
+// in place; the disk journals a page of the file here before its first
+// overwrite, syncing the log first. Recovery puts those pages back, which
+// returns the file to the last checkpoint, and the statements logged since
+// are run again: a LOAD reads its file again, and the statements of a group
+// not synced before a crash are lost. A checkpoint syncs the file and empties
+// the log.
+class WriteAheadLog : public DiskJournal {
+ public:
+  // Syncs the log every group_size statements
+  explicit WriteAheadLog(int group_size);
+  virtual ~WriteAheadLog();
+
+  // Opens the log of the database file, creating it if needed. The pages it
+  // saved are put back into the database file, and the statements logged
+  // since the last checkpoint are returned in order to be run again.
+  bool Open(const std::string& database_file,
+      std::vector<std::string>& statements);
+  // Appends a statement that ran; it is durable once its group is synced
+  bool Append(const std::string& statement);
+  // Syncs the statements appended since the last sync
+  bool Sync();
+  // Empties the log, once the database file holds every statement in it
+  bool Truncate();
+
+  void ResetStats();
+  unsigned long Records() const;
+  unsigned long Syncs() const;
+
+  // Saves a page of the database file and syncs the log
+  bool savePage(int page, const char* data) override;
+
+ private:
+  bool append(const char type, const std::string& payload);
+  bool restorePage(const std::string& database_file, const int page,
+      const char *data, int& database);
+
+  int file_;
+  int group_size_;
+  // Statements appended since the last sync
+  int unsynced_;
+  unsigned long records_;
+  unsigned long syncs_;
+};
+
+#endif // SRC_STORAGE_WRITE_AHEAD_LOG_H
@@ -9,13 +9,24 @@ class Tuple;
 
 /* A disk or memory block contains a number of records/tuples that belong to the same relation. 
  * A tuple CANNOT be splitted and stored in more than one blocks. 
- * Each block is defined to hold as most FIELDS_PER_BLOCK fields. 
+ * Each block is defined to hold as most FIELDS_PER_BLOCK fields (see setFieldsPerBlock()). 
  * Therefore, the max number of tuples held in a block can be calculated from the size of a tuple, 
  *   which is the number of fields in a tuple.
  * You can get the number by calling Schema::getTuplesPerBlock().
  *
  * The max number of tuples held in a block = FIELDS_PER_BLOCK / num_of_fields_in_tuple
  *
+ * A block of a compressed relation (see Schema::setCompressed()) holds as many tuples as fit,
+ *   once encoded, in the bytes of a full uncompressed block, and at most MAX_COMPRESSION_RATIO
+ *   times more. The encoding stores the valid tuples column by column: an INT column as its
+ *   smallest value and the difference of every value from it, a STR20 column as a dictionary
+ *   of its distinct values and the position of every value in it, both packed in as few bits
+ *   as the largest one needs. The disk stores a compressed block this way when it is smaller,
+ *   and the block is decoded when it is read into memory.
+ *   Whether a tuple fits depends on the tuples already in the block: use hasRoomFor().
+ *   Compressed tuples written to a relation of the same fields that is not compressed keep
+ *   their encoding, so a block of such a relation may hold more than getTuplesPerBlock().
+ *
  * Usage: Blocks already reside in the memory and disk. You don't need to create blocks manually.
  *        Most time when you need to use the Block class is to access a block of the main memory
  *        and to get or modify the tuples in the memory block.
@@ -24,21 +35,39 @@ class Tuple;
 class Block {
   private:
     vector<Tuple> tuples;
+    static int fields_per_block;
     Block(); // for internal use only: DO NOT use this constructor. Use the blocks in Memory or Relation
     static Block getDummyBlock(); // for internal use: returns an empty block
+    // for internal use: returns true if the tuples fit in a block
+    static bool fits(const vector<Tuple>& tuples);
+    // for internal use: encodes the tuples of a compressed block into data, if not NULL;
+    // returns the bytes of the encoding
+    static int encodeCompressed(const vector<Tuple>& tuples, char* data);
 
   public:
     friend class MainMemory;  // allocates blocks
     //friend class Relation; // allocates blocks
     friend class Disk;
 
-    bool isFull() const;
+    // Changes the number of fields a block holds; set it before creating any relation
+    // returns false if a relation of MAX_NUM_OF_FIELDS_IN_RELATION fields does not fit,
+    //   or a full block does not fit in a page of the disk
+    static bool setFieldsPerBlock(int fields_per_block);
+    static int getFieldsPerBlock();
+
+    bool isFull() const; // returns true if no tuple can be appended
+    // returns true if the tuple can take the first invalid slot, or be appended
+    bool hasRoomFor(const Tuple& tuple) const;
     bool isEmpty() const;
     void clear(); //empty the block
     int getNumTuples() const; // returns current number of tuples inside this block
     Tuple getTuple(int tuple_offset) const; // gets the tuple value at tuple_index;
                                             //returns empty Tuple if tuple_index out of bound
     vector<Tuple> getTuples() const; // returns all the tuples inside this block
+    // iterate over the tuples inside this block without copying them;
+    // the iterators are valid until the block is changed
+    vector<Tuple>::const_iterator begin() const;
+    vector<Tuple>::const_iterator end() const;
     bool setTuple(int tuple_offset, const Tuple& tuple); // sets new tuple value at tuple_offset;
                                                          //returns false if tuple_offset out of bound
     // remove all the tuples; sets new tuples for the block;
@@ -1,55 +1,205 @@
 #ifndef _DISK_H
 #define _DISK_H
 
+#include <map>
+#include <mutex>
+#include <string>
 #include <vector>
 using namespace std;
 
-#define NUM_TRACKS 100
+#define DISK_PAGE_SIZE 4096 // bytes of one block in the page file
+#define DISK_EXTENT_SIZE 8 // consecutive pages a track is given at once
 
-/* Simplified assumptions are made for disks. A disk contains many tracks. 
- * We assume each relation reside on a single track of blocks on disk. 
- * Everytime to read or write blocks of a relation takes time:
+class Block;
+class Tuple;
+
+/* The latency model decides how much simulated time a disk access costs and
+ * whether the caller has to actually wait for it.
+ * The cost of reading or writing num_blocks consecutive blocks is:
+ *
+ * (seek_time + rotation_latency + transfer_time_per_block
+ *    + sequential_transfer_time_per_block * (num_blocks - 1))
  *
- * (AVG_SEEK_TIME + AVG_ROTATION_LATENCY + AVG_TRANSFER_TIME_PER_BLOCK * num_of_consecutive_blocks)
+ * or only (sequential_transfer_time_per_block * num_blocks) if the blocks
+ * start where the head stopped after the previous access.
+ * The disk I/O counter and the disk timer always advance by the same amounts,
+ * the mode only decides what happens to the calling thread:
+ *   VIRTUAL: account the time only and return immediately
+ *   SLEEP:   yield the thread for the simulated time
+ *   SPIN:    busy-wait on a steady clock for the simulated time
+ * Usage: The default model is the Megatron 747 disk below; SPIN if
+ *        SIMULATED_DISK_LATENCY_ON is 1, VIRTUAL otherwise.
+ *        Use Disk::setLatencyModel() to change it before running any query.
+ */
+class DiskLatencyModel {
+  public:
+    enum Mode { VIRTUAL, SLEEP, SPIN };
+
+    Mode mode;
+    double seek_time; // in milliseconds
+    double rotation_latency; // in milliseconds
+    double transfer_time_per_block; // the first block of every access
+    double sequential_transfer_time_per_block; // each following block
+
+    DiskLatencyModel();
+    static DiskLatencyModel getHardDiskModel(); // the Megatron 747 disk
+    static DiskLatencyModel getSolidStateModel(); // cheap sequential blocks
+
+    // returns the simulated time of accessing num_blocks consecutive blocks
+    double getAccessTime(int num_blocks) const;
+    // the same, without the seek if the head is already at the first block
+    double getAccessTime(int num_blocks, bool head_in_place) const;
+    // blocks the calling thread for delay milliseconds according to the mode
+    void wait(double delay) const;
+};
+
+/* The disk I/O of one relation or one access tag: the accesses and blocks
+ * read and written, and the simulated time they took in milliseconds.
+ */
+struct DiskAccessStats {
+  unsigned long int reads;
+  unsigned long int writes;
+  unsigned long int blocks_read;
+  unsigned long int blocks_written;
+  double time;
+
+  DiskAccessStats();
+};
+
+/* A journal the disk saves pages of the page file to before overwriting them.
+ * Once started, the disk saves every page the file had at that time the
+ * first time it overwrites the page, except the pages of the free extents,
+ * so putting the saved pages back returns the file to that time.
+ */
+class DiskJournal {
+  public:
+    virtual ~DiskJournal() {}
+    // returns true once the page is saved where it survives a crash;
+    // the disk only writes the page after that
+    virtual bool savePage(int page, const char* data)=0;
+};
+
+/* Simplified assumptions are made for disks. A disk contains many tracks,
+ * one per relation. The blocks of a track are stored in extents of
+ * DISK_EXTENT_SIZE consecutive pages; a track takes a free extent whenever it
+ * grows past its last one and gives back the extents it no longer needs when
+ * it shrinks, so a track has no size limit and the extents of a dropped
+ * relation are reused by the next ones.
+ * An access to consecutive blocks of a relation is charged by the latency
+ * model once for every run of them stored on consecutive pages; only a run
+ * that does not start where the head stopped pays the seek and the rotation.
  *
  * The number of disk I/O is calculated by the number of blocks read or written.
+ * By default the tracks are kept in memory and are lost when the program exits.
+ * After open(), every block of a track is a DISK_PAGE_SIZE page in a file:
+ *   page 0 is the file header;
+ *   the extents of the tracks and the catalog of the schema manager are
+ *     stored in a chain of metadata pages, rewritten by sync();
+ *   the other pages hold one block each: the number of tuple slots, and for
+ *     every slot a valid flag followed by the field buffer of the tuple.
+ * An image is a page file of its own holding the tracks and the catalog of a
+ *   disk, with the extents of every track on consecutive pages; it is written
+ *   in one pass and read back into memory, or copied and opened as a page file.
+ * Blocks are read and written with positioned I/O. Disk I/Os and the disk timer
+ * are counted the same way in both modes; sync() is not counted.
+ * Every access is also accounted to its relation, by name, and to the access
+ *   tag of the calling thread, so the I/O of a statement can be broken down;
+ *   a thread tags its accesses with setAccessTag(), 0 by default.
+ * One access is served at a time: the disk holds a lock while it reads, writes,
+ *   waits for the latency or changes the tracks, so a relation can be read on
+ *   a background thread while the main thread keeps using the disk.
  * Usage: At the beginning of your program, you need to initialize a disk.
+ *       To keep the relations in a file, call open() before creating any relation,
+ *         then SchemaManager::loadCatalog() to get back the relations stored in it.
  *       You don't need to access Disk directly except for getting disk I/O counts
  *       When you need to access a relation, use the Relation class
  */
 class Disk {
   private:
-    //Properties are defined based on the Megatron 747 disk sold in 2001.
-    
-    //One block holds 16384 bytes (although a block only holds 8 fields in here)
-    //Thus, a relation of 60 tuples/blocks occupies as much as 960K
-    //If memory has 1/6 of the relation size, then the memory has only 160K space
-    //However, we want to simulate the speed of a 300M relation and a 50M memory
-    //So we increase the transfer time of a block by 320 folds
-    static const double avg_seek_time=6.46;
-    static const double avg_rotation_latency=4.17;
-    static const double avg_transfer_time_per_block=0.20 * 320;
-
-    vector<Block> tracks[NUM_TRACKS];
+    DiskLatencyModel latency_model;
+    // held by every access to the tracks; the schema manager also holds it
+    // while it changes the catalog, which the pages are decoded with
+    mutable recursive_mutex lock;
+
+    vector<vector<Block> > tracks;
     unsigned long int diskIOs;
     double timer;
+    vector<string> track_names; // the relation on every track, for the stats
+    map<string,DiskAccessStats> relation_stats;
+    map<int,DiskAccessStats> tag_stats;
+    static thread_local int access_tag;
+
+    // for the page file; file is -1 when the tracks are kept in memory
+    int file;
+    int num_pages; // pages of the disk, in the file including the header
+    vector<vector<int> > track_extents; // the first page of every extent of a track
+    vector<vector<int> > track_tuples; // valid tuples in every block of a track
+    vector<int> free_extents; // the first pages of the extents no track uses
+    int head; // the page after the last one accessed; -1 before any access
+    vector<int> meta_pages; // the chain storing the page tables and the catalog
+    string catalog; // owned by the schema manager
+    bool dirty; // the page tables or the catalog changed since the last sync()
+    DiskJournal* journal; // NULL if the pages are not journaled
+    mutable vector<bool> unsaved; // the pages to save to the journal before their next write
     
     // for internal use: extend the track to 'block_index'-1; no disk latency
     bool extendTrack(int schema_index, int block_index, const Tuple& t);
     // for internal use: shrink the track to 'block_index'-1; no disk latency
     bool shrinkTrack(int schema_index, int block_index);
+    // for internal use: drop all the blocks of the track; no disk latency
+    void clearTrack(int schema_index);
+    // for internal use: grow the disk to at least 'num_tracks' empty tracks
+    void addTracks(int num_tracks);
     // for internal use: increment Disk I/O count
     void incrementDiskIOs(int count);
-    void incrementDiskTimer(int num_blocks);
+    // charges the access to the blocks and moves the head past them;
+    // returns the time charged
+    double incrementDiskTimer(int schema_index, int block_index, int num_blocks);
+    // for internal use: adds an access to the stats of its relation and tag
+    void accountAccess(int schema_index, bool write, int num_blocks, double time);
+    // for internal use: names the relation on the track in the stats
+    void setTrackName(int schema_index, const string& relation_name);
+
+    // for internal use: access a track without disk latency;
+    // 't' is an empty tuple of the relation, used to decode the pages
+    int getTrackSize(int schema_index) const;
+    int getTrackTuples(int schema_index) const;
+    Block readBlock(int schema_index, int block_index, const Tuple& t) const;
+    bool writeBlock(int schema_index, int block_index, const Block& b, const Tuple& t);
+
+    // for internal use: the extents
+    int getPage(int schema_index, int block_index) const;
+    int allocateExtent();
+
+    // for internal use: the page file
+    bool readPage(int page, char* data) const;
+    bool writePage(int page, const char* data) const;
+    static bool encodeBlock(const Block& b, const Tuple& t, char* data);
+    static Block decodeBlock(const char* data, const Tuple& t);
+    bool readMetadata(int first_page);
+    bool writeMetadata();
+
+    // for internal use: the catalog of the schema manager
+    string getCatalog() const;
+    void setCatalog(const string& catalog);
+
+    // for internal use: write the tracks and 'catalog' to a new page file;
+    // 'tuples' has an empty tuple of the relation on every track; no disk latency
+    bool saveImage(string file_name, const string& catalog, const vector<Tuple>& tuples);
+    // for internal use: read every track of the page file into memory and close it
+    bool closeIntoMemory(const vector<Tuple>& tuples);
     
-    Block getBlock(int schema_index, int block_index);
-    vector<Block> getBlocks(int schema_index, int block_index, int num_blocks);
-    bool setBlock(int schema_index, int block_index, const Block& b);
-    bool setBlocks(int schema_index, int block_index, const vector<Block>& vb);
+    Block getBlock(int schema_index, int block_index, const Tuple& t);
+    vector<Block> getBlocks(int schema_index, int block_index, int num_blocks, const Tuple& t);
+    bool setBlock(int schema_index, int block_index, const Block& b, const Tuple& t);
+    bool setBlocks(int schema_index, int block_index, const vector<Block>& vb, const Tuple& t);
     
   public:
     friend class Relation;
-    Disk();
+    friend class SchemaManager; // adds and drops tracks; stores the catalog
+    Disk(); // a disk with no tracks; the schema manager adds one per relation
+    ~Disk(); // syncs and closes the page file
+    int getNumOfTracks() const;
     // Reset the disk I/O counter.
     // Every time before you do a SQL operation, reset the counter.
     void resetDiskIOs();
@@ -60,6 +210,32 @@ class Disk {
     void resetDiskTimer();
     // After the operation is done, get the elapse disk time in milliseconds
     double getDiskTimer() const;
+
+    // Tag the accesses of the calling thread from now on
+    static void setAccessTag(int tag);
+    static int getAccessTag();
+    // Reset the accesses accounted by relation and by tag
+    void resetAccessStats();
+    // The accesses since the last resetAccessStats(), by relation name and by tag
+    map<string,DiskAccessStats> getRelationAccessStats() const;
+    map<int,DiskAccessStats> getTagAccessStats() const;
+
+    // Replace the latency model; the I/O counter and timer are not reset
+    void setLatencyModel(const DiskLatencyModel& model);
+    DiskLatencyModel getLatencyModel() const;
+
+    // Keep the tracks in a page file; the file is created if it does not exist
+    // returns false if the file cannot be used or some track is not empty
+    bool open(string file_name);
+    bool isOpen() const; // returns true if the tracks are kept in a page file
+    // Write the extents of the tracks and the catalog to the page file
+    // returns true if there is no page file
+    bool sync();
+    // sync() and wait until the page file is on stable storage
+    bool flush();
+    // Save the pages of the file as they are now to the journal before they are
+    // overwritten; a NULL journal stops journaling. Call it again to start over.
+    void startJournal(DiskJournal* journal);
 };
 
 #endif
@@ -1,8 +1,11 @@
 #ifndef _FIELD_H
 #define _FIELD_H
 
+#include <string>
 using namespace std;
 
+#define STR20_CAPACITY 22 // 20 characters, plus the quotes if the value is kept quoted
+
 /* A field type can either be INT or STR20
  * Usage: When you specify the schema, you need the following definition of field types.
  *        When you access a field, check the schema about the field type first,
@@ -11,9 +14,19 @@ using namespace std;
 
 enum FIELD_TYPE { INT = 1, STR20 };
 
+/* A STR20 value is stored inline: a length byte followed by the characters.
+ * Usage: *(field.str) returns the value as a string.
+ */
+struct Str20 {
+    unsigned char length;
+    char chars[STR20_CAPACITY];
+
+    string operator*() const { return string(chars,length); }
+};
+
 union Field {
 public:
-    string* str;
+    Str20 str;
     int integer;
 
     Field() {}
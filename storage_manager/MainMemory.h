@@ -11,6 +11,7 @@ using namespace std;
 class Block;
 
 /* The simulated memory holds NUM_OF_BLOCKS_IN_MEMORY blocks numbered with 0,1,2,... 
+ * unless another size is given when the memory is created.
  * You can get total number of blocks in the memory by calling MainMemory::getMemorySize(). 
  * Before accessing data of a relation, you have to copy the disk blocks of a relation 
  * to the simulated main memory. 
@@ -27,13 +28,14 @@ class Block;
 
 class MainMemory {
   private:
-    Block blocks[NUM_OF_BLOCKS_IN_MEMORY]; // an array of blocks
+    vector<Block> blocks; // an array of blocks
     bool setBlock(int memory_block_index, const vector<Block>::const_iterator first,
                   const vector<Block>::const_iterator last);
   public:
     friend class Relation;
 
     MainMemory();
+    MainMemory(int num_blocks); // a memory of num_blocks blocks
     int getMemorySize() const; // returns total number of blocks in the memory (including empty ones)
 
     Block* getBlock(int memory_block_index); //returns NULL if out of bound
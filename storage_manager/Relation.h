@@ -3,8 +3,6 @@
 
 #include <vector>
 
-#define MAX_NUM_CREATING_RELATIONS 100
-
 using namespace std;
 
 class SchemaManager;  //must do forward declaration
@@ -49,6 +47,8 @@ class Relation {
 
     string getRelationName() const;
     Schema getSchema() const; // returns the schema of the tuple    
+    // returns the schema without copying it; valid until the relation is deleted
+    const Schema& getSchemaRef() const;
     int getNumOfBlocks() const;
     int getNumOfTuples() const;
     bool isNull() const;
@@ -4,6 +4,7 @@
 #include <vector>
 #include <map>
 
+#include "Config.h"
 #include "Field.h"
 #include "Tuple.h"
 
@@ -27,16 +28,22 @@ class Schema {
   vector<string> field_names;
   vector<enum FIELD_TYPE> field_types;
   map<string,int> field_offsets; // Maps a field name to a field offset.
+  // Where each field starts in the buffer of a tuple: INT takes sizeof(int) bytes,
+  // STR20 takes sizeof(Str20) bytes
+  int field_positions[MAX_NUM_OF_FIELDS_IN_RELATION];
+  int tuple_size; // bytes of the fields in the buffer of a tuple
+  bool compressed; // the blocks of the relation are compressed (see Block.h)
 
   void clear();
 
   public:
   friend class SchemaManager; // accesses clear()
+  friend class Tuple; // accesses field_positions
 
   Schema();
   Schema(const vector<string>& field_names, const vector<enum FIELD_TYPE>& field_types);
 
-  bool operator==(const Schema& s) const; // test equality
+  bool operator==(const Schema& s) const; // test equality of the fields
   bool operator!=(const Schema& s) const; // test equality
 
   bool isEmpty() const; //returns true if it is empty
@@ -50,6 +57,9 @@ class Schema {
   int getNumOfFields() const;
   int getTuplesPerBlock() const; //A block storing data of a relation of this schema holds no more
                                  //than this number of tuples/records
+  bool isCompressed() const;
+  void setCompressed(bool compressed); // set it before creating the relation
+  int getBlockBytes() const; // bytes of a full uncompressed block in a page of the disk
   void printSchema() const;
   void printSchema(ostream& out) const;
   void printFieldNames() const; //prints field names in defined order
@@ -1,8 +1,9 @@
 #ifndef _SCHEMA_MANAGER_H
 #define _SCHEMA_MANAGER_H
 
-#include <map>
+#include <deque>
 #include <set>
+#include <unordered_map>
 #include <vector>
 
 using namespace std;
@@ -16,6 +17,11 @@ using namespace std;
  *        Create a relation through here (and not elsewhere) by giving relation name and schema
  *        Every relation name must be unique.
  *        Once a relation is created, the schema cannot be changed
+ *        There is no limit on the number of relations; the slot of a deleted relation
+ *          is given to the next created one, and a relation pointer stays valid until
+ *          the relation is deleted
+ *        If the disk keeps its tracks in a page file, the relations and schemas are stored
+ *          there too, and loadCatalog() gets them back in a later run
  */
 class MainMemory;
 class Disk;
@@ -26,10 +32,19 @@ class SchemaManager {
   private:
     MainMemory* mem;
     Disk* disk;
-    map<string,int> relation_name_to_index;
-    Relation relations[MAX_NUM_CREATING_RELATIONS];
-    Schema schemas[MAX_NUM_CREATING_RELATIONS];
-    int offset;
+    unordered_map<string,int> relation_name_to_index;
+    deque<Relation> relations; // indexed by the disk track; a deque never moves its elements
+    deque<Schema> schemas;
+    vector<int> free_indices; // the slots of deleted relations
+
+    // for internal use: creates the relation in slot 'index', growing the slots and the disk tracks
+    Relation* addRelation(string relation_name, const Schema& schema, int index);
+
+    // for internal use: stores the relations and schemas on the disk if the disk has a page file
+    void saveCatalog();
+    string encodeCatalog() const;
+    // for internal use: an empty tuple of the relation on every disk track
+    vector<Tuple> getTrackTuples() const;
 
   public:
     friend class Tuple; // accesses schema
@@ -43,6 +58,17 @@ class SchemaManager {
     Relation* createRelation(string relation_name,const Schema& schema);
     Relation* getRelation(string relation_name); //returns NULL if the relation is not found
     bool deleteRelation(string relation_name); //returns false if the relation is not found
+
+    // creates the relations stored in the page file of the disk; call it once after Disk::open()
+    // returns false if a relation has been created already or the catalog is broken
+    bool loadCatalog();
+
+    // writes the relations and all their blocks to an image file, replacing it;
+    // returns false if the file is the page file of the disk
+    bool saveImage(string file_name) const;
+    // creates the relations of an image and reads their blocks into the memory of the disk;
+    // call it instead of Disk::open() and loadCatalog() before any relation is created
+    bool loadImage(string file_name);
     
     void printSchemas() const; //print all relations and their schema
     void printSchemas(ostream &out) const;
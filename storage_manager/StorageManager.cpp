@@ -1,6 +1,14 @@
 #include <iostream>
+#include <sstream>
+#include <chrono>
+#include <cstring>
 #include <ctime>
 #include <climits>
+#include <mutex>
+#include <thread>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "Block.h"
 #include "Config.h"
 #include "Disk.h"
@@ -13,7 +21,129 @@
 
 using namespace std;
 
-Disk::Disk() { resetDiskIOs(); resetDiskTimer(); }
+DiskLatencyModel::DiskLatencyModel() {
+  mode=(SIMULATED_DISK_LATENCY_ON==1?SPIN:VIRTUAL);
+  //Properties are defined based on the Megatron 747 disk sold in 2001.
+
+  //One block holds 16384 bytes (although a block only holds 8 fields in here)
+  //Thus, a relation of 60 tuples/blocks occupies as much as 960K
+  //If memory has 1/6 of the relation size, then the memory has only 160K space
+  //However, we want to simulate the speed of a 300M relation and a 50M memory
+  //So we increase the transfer time of a block by 320 folds
+  seek_time=6.46;
+  rotation_latency=4.17;
+  transfer_time_per_block=0.20 * 320;
+  sequential_transfer_time_per_block=0.20 * 320;
+}
+
+DiskLatencyModel DiskLatencyModel::getHardDiskModel() {
+  return DiskLatencyModel();
+}
+
+DiskLatencyModel DiskLatencyModel::getSolidStateModel() {
+  DiskLatencyModel model=getHardDiskModel();
+  //No moving head: a random access only pays the command latency and the
+  //transfer of its first block; the blocks following it in the same access
+  //are streamed. Transfer times are scaled 320 folds like the hard disk.
+  model.seek_time=0.08;
+  model.rotation_latency=0;
+  model.transfer_time_per_block=0.05 * 320;
+  model.sequential_transfer_time_per_block=0.01 * 320;
+  return model;
+}
+
+double DiskLatencyModel::getAccessTime(int num_blocks) const {
+  if (num_blocks<=0) return 0;
+  return seek_time+rotation_latency+transfer_time_per_block
+         +sequential_transfer_time_per_block*(num_blocks-1);
+}
+
+double DiskLatencyModel::getAccessTime(int num_blocks, bool head_in_place) const {
+  if (num_blocks<=0) return 0;
+  if (head_in_place) return sequential_transfer_time_per_block*num_blocks;
+  return getAccessTime(num_blocks);
+}
+
+void DiskLatencyModel::wait(double delay) const {
+  if (mode==SLEEP) {
+    this_thread::sleep_for(chrono::duration<double,milli>(delay));
+  } else if (mode==SPIN) {
+    //A steady clock rather than clock(): the CPU time of the process also
+    //advances with the other threads
+    chrono::steady_clock::time_point end_time=chrono::steady_clock::now()
+        +chrono::duration_cast<chrono::steady_clock::duration>(
+            chrono::duration<double,milli>(delay));
+    while (chrono::steady_clock::now() < end_time){
+    ;
+    }
+  }
+}
+
+DiskAccessStats::DiskAccessStats() {
+  reads=0;
+  writes=0;
+  blocks_read=0;
+  blocks_written=0;
+  time=0;
+}
+
+thread_local int Disk::access_tag=0;
+
+//Identifies a page file and its format version
+static const char DISK_FILE_MAGIC[8]={'T','i','n','y','S','Q','L','4'};
+
+static void appendInt(string& s, int i) {
+  s.append((const char*)&i,sizeof(int));
+}
+
+static bool readInt(const string& s, size_t& pos, int& i) {
+  if (pos+sizeof(int)>s.size()) return false;
+  memcpy(&i,s.data()+pos,sizeof(int));
+  pos+=sizeof(int);
+  return true;
+}
+
+//Set in the slot count of a page holding a compressed block
+static const unsigned short COMPRESSED_BLOCK_FLAG=0x8000;
+
+//Packs the lowest 'width' bits of value from bit 'bit' of data on; data starts zeroed
+static void packBits(char* data, long bit, int width, unsigned int value) {
+  for (int i=0;i<width;i++,bit++) {
+    if ((value>>i)&1) data[bit/8]|=(char)(1<<(bit%8));
+  }
+}
+
+static unsigned int unpackBits(const char* data, long bit, int width) {
+  unsigned int value=0;
+  for (int i=0;i<width;i++,bit++) {
+    if ((data[bit/8]>>(bit%8))&1) value|=1u<<i;
+  }
+  return value;
+}
+
+//The bits needed by the numbers from 0 to max
+static int bitWidth(unsigned long long max) {
+  int width=0;
+  for (;max>0;max>>=1) width++;
+  return width;
+}
+
+Disk::Disk() {
+  resetDiskIOs();
+  resetDiskTimer();
+  file=-1;
+  num_pages=0;
+  head=-1;
+  dirty=false;
+  journal=NULL;
+}
+
+Disk::~Disk() {
+  if (file>=0) {
+    sync();
+    ::close(file);
+  }
+}
 
 /*
 bool Disk::extendTrack(int schema_index, int block_index, const Tuple& t) {
@@ -42,90 +172,514 @@ bool Disk::extendTrack(int schema_index, int block_index, const Tuple& t) {
 */
 
 bool Disk::extendTrack(int schema_index, int block_index, const Tuple& t) {
+  lock_guard<recursive_mutex> guard(lock);
   if (block_index<0) {
     cerr << "extendTrack ERROR: block index " << block_index << " out of disk bound" << endl;
     return false;
   }   
-  vector<Block>& track=tracks[schema_index];
-  int j=track.size();
+  int j=getTrackSize(schema_index);
   if (block_index>j) {
     if (j>0) {
-      while (!track[j-1].isFull()) { // first fill the last block with invalid tuples
-        track[j-1].appendTuple(t);
+      Block b=readBlock(schema_index,j-1,t);
+      if (!b.isFull()) {
+        while (!b.isFull()) { // first fill the last block with invalid tuples
+          b.appendTuple(t);
+        }
+        if (!writeBlock(schema_index,j-1,b,t)) return false;
       }
     }
     // fill the gap with invalid tuples
     for (int i=j;i<block_index-1;i++) {
-      track.push_back(Block::getDummyBlock());
-      while (!track[i].isFull()) {
-        track[i].appendTuple(t);
+      Block b=Block::getDummyBlock();
+      while (!b.isFull()) {
+        b.appendTuple(t);
       }
+      if (!writeBlock(schema_index,i,b,t)) return false;
     }
     // fill the last block with only one invalid tuple
-    track.push_back(Block::getDummyBlock());
-    track[block_index-1].appendTuple(t);
+    Block b=Block::getDummyBlock();
+    b.appendTuple(t);
+    if (!writeBlock(schema_index,block_index-1,b,t)) return false;
   }
   return true;
 }
 
 bool Disk::shrinkTrack(int schema_index, int block_index) {
-  if (block_index<0 || block_index >= tracks[schema_index].size()) {
+  lock_guard<recursive_mutex> guard(lock);
+  if (block_index<0 || block_index >= getTrackSize(schema_index)) {
     cerr << "shrinkTrack ERROR: block index " << block_index << " out of disk bound" << endl;
     return false;
   }  
-  tracks[schema_index].erase(tracks[schema_index].begin()+block_index,tracks[schema_index].end());
+  // the extents past the ones holding the remaining blocks are freed
+  vector<int>& extents=track_extents[schema_index];
+  int num_extents=(block_index+DISK_EXTENT_SIZE-1)/DISK_EXTENT_SIZE;
+  free_extents.insert(free_extents.end(),extents.begin()+num_extents,extents.end());
+  extents.resize(num_extents);
+  if (file<0) {
+    tracks[schema_index].erase(tracks[schema_index].begin()+block_index,tracks[schema_index].end());
+    return true;
+  }
+  track_tuples[schema_index].resize(block_index);
+  dirty=true;
+  return true;
+}
+
+void Disk::clearTrack(int schema_index) {
+  if (getTrackSize(schema_index)>0)
+    shrinkTrack(schema_index,0);
+}
+
+void Disk::addTracks(int num_tracks) {
+  lock_guard<recursive_mutex> guard(lock);
+  if (num_tracks<=tracks.size()) return;
+  tracks.resize(num_tracks);
+  track_extents.resize(num_tracks);
+  track_names.resize(num_tracks);
+  track_tuples.resize(num_tracks);
+  dirty=true;
+}
+
+int Disk::getTrackSize(int schema_index) const {
+  if (file<0) return tracks[schema_index].size();
+  return track_tuples[schema_index].size();
+}
+
+int Disk::getTrackTuples(int schema_index) const {
+  int total_tuples=0;
+  if (file<0) {
+    const vector<Block>& data=tracks[schema_index];
+    for (vector<Block>::const_iterator vit=data.begin();vit!=data.end();vit++) {
+      total_tuples+=vit->getNumTuples();
+    }
+  } else {
+    const vector<int>& counts=track_tuples[schema_index];
+    for (vector<int>::const_iterator vit=counts.begin();vit!=counts.end();vit++) {
+      total_tuples+=*vit;
+    }
+  }
+  return total_tuples;
+}
+
+Block Disk::readBlock(int schema_index, int block_index, const Tuple& t) const {
+  if (file<0) return tracks[schema_index][block_index];
+  char data[DISK_PAGE_SIZE];
+  if (!readPage(getPage(schema_index,block_index),data)) {
+    return Block::getDummyBlock();
+  }
+  return decodeBlock(data,t);
+}
+
+bool Disk::writeBlock(int schema_index, int block_index, const Block& b, const Tuple& t) {
+  if (block_index<0 || block_index>getTrackSize(schema_index)) {
+    cerr << "writeBlock ERROR: block index " << block_index << " out of disk bound" << endl;
+    return false;
+  }
+  char data[DISK_PAGE_SIZE];
+  if (file>=0 && !encodeBlock(b,t,data)) return false;
+  if (block_index==getTrackSize(schema_index) && block_index%DISK_EXTENT_SIZE==0) {
+    track_extents[schema_index].push_back(allocateExtent());
+  }
+  if (file<0) {
+    if (block_index==tracks[schema_index].size())
+      tracks[schema_index].push_back(b);
+    else
+      tracks[schema_index][block_index]=b;
+    return true;
+  }
+  if (block_index==track_tuples[schema_index].size()) {
+    track_tuples[schema_index].push_back(0);
+  }
+  if (!writePage(getPage(schema_index,block_index),data)) return false;
+  if (track_tuples[schema_index][block_index]!=b.getNumTuples()) {
+    track_tuples[schema_index][block_index]=b.getNumTuples();
+    dirty=true;
+  }
+  return true;
+}
+
+int Disk::getPage(int schema_index, int block_index) const {
+  return track_extents[schema_index][block_index/DISK_EXTENT_SIZE]
+         +block_index%DISK_EXTENT_SIZE;
+}
+
+int Disk::allocateExtent() {
+  dirty=true;
+  if (free_extents.empty()) {
+    num_pages+=DISK_EXTENT_SIZE;
+    return num_pages-DISK_EXTENT_SIZE;
+  }
+  int page=free_extents.back();
+  free_extents.pop_back();
+  return page;
+}
+
+bool Disk::readPage(int page, char* data) const {
+  if (pread(file,data,DISK_PAGE_SIZE,(off_t)page*DISK_PAGE_SIZE)!=DISK_PAGE_SIZE) {
+    cerr << "readPage ERROR: cannot read page " << page << endl;
+    return false;
+  }
   return true;
 }
 
-Block Disk::getBlock(int schema_index, int block_index) {
-  if (block_index<0 || block_index>=tracks[schema_index].size())  {
+bool Disk::writePage(int page, const char* data) const {
+  if (journal!=NULL && page<unsaved.size() && unsaved[page]) {
+    char saved[DISK_PAGE_SIZE];
+    if (!readPage(page,saved) || !journal->savePage(page,saved)) {
+      cerr << "writePage ERROR: cannot save page " << page << " to the journal" << endl;
+      return false;
+    }
+    unsaved[page]=false;
+  }
+  if (pwrite(file,data,DISK_PAGE_SIZE,(off_t)page*DISK_PAGE_SIZE)!=DISK_PAGE_SIZE) {
+    cerr << "writePage ERROR: cannot write page " << page << endl;
+    return false;
+  }
+  return true;
+}
+
+bool Disk::encodeBlock(const Block& b, const Tuple& t, char* data) {
+  memset(data,0,DISK_PAGE_SIZE);
+  int tuple_size=t.getSize();
+  unsigned short num_slots=b.tuples.size();
+  int plain_size=sizeof(num_slots)+num_slots*(1+tuple_size);
+  // a block of compressed tuples is stored plain when that is smaller; it may hold more
+  // tuples than a plain block even in an uncompressed relation of the same fields
+  if (num_slots>0 && (t.getSchemaRef().isCompressed() ||
+                      b.tuples.front().getSchemaRef().isCompressed())) {
+    int size=Block::encodeCompressed(b.tuples,NULL);
+    if (size<plain_size && size<=DISK_PAGE_SIZE) {
+      Block::encodeCompressed(b.tuples,data);
+      return true;
+    }
+  }
+  if (plain_size>DISK_PAGE_SIZE) {
+    cerr << "encodeBlock ERROR: block does not fit in a page of " << DISK_PAGE_SIZE << " bytes" << endl;
+    return false;
+  }
+  memcpy(data,&num_slots,sizeof(num_slots));
+  char* slot=data+sizeof(num_slots);
+  for (vector<Tuple>::const_iterator it=b.tuples.begin();it!=b.tuples.end();it++) {
+    slot[0]=(it->isNull()?0:1);
+    if (!it->isNull()) memcpy(slot+1,it->data,tuple_size);
+    slot+=1+tuple_size;
+  }
+  return true;
+}
+
+Block Disk::decodeBlock(const char* data, const Tuple& t) {
+  Block b;
+  int tuple_size=t.getSize();
+  unsigned short num_slots;
+  memcpy(&num_slots,data,sizeof(num_slots));
+  if (num_slots&COMPRESSED_BLOCK_FLAG) {
+    // the validity bits, then every column of the valid tuples
+    num_slots&=~COMPRESSED_BLOCK_FLAG;
+    const Schema& schema=t.getSchemaRef();
+    int pos=sizeof(num_slots);
+    vector<int> valid;
+    for (int i=0;i<num_slots;i++) {
+      Tuple tuple(t.schema_manager,t.schema_index);
+      if (unpackBits(data+pos,i,1)) valid.push_back(i);
+      else tuple.null();
+      b.tuples.push_back(tuple);
+    }
+    pos+=(num_slots+7)/8;
+    for (int f=0;f<schema.getNumOfFields();f++) {
+      int width;
+      if (schema.getFieldType(f)==INT) {
+        int base;
+        memcpy(&base,data+pos,sizeof(int));
+        width=(unsigned char)data[pos+sizeof(int)];
+        pos+=sizeof(int)+1;
+        for (int i=0;i<valid.size();i++) {
+          b.tuples[valid[i]].setField(f,(int)(base+(long long)unpackBits(data+pos,(long)i*width,width)));
+        }
+      } else {
+        unsigned short num_values;
+        memcpy(&num_values,data+pos,sizeof(num_values));
+        pos+=sizeof(num_values);
+        vector<string> values;
+        for (int j=0;j<num_values;j++) {
+          int length=(unsigned char)data[pos];
+          values.push_back(string(data+pos+1,length));
+          pos+=1+length;
+        }
+        width=bitWidth(num_values>0?num_values-1:0);
+        for (int i=0;i<valid.size();i++) {
+          unsigned int code=unpackBits(data+pos,(long)i*width,width);
+          if (code<values.size()) b.tuples[valid[i]].setField(f,values[code]);
+        }
+      }
+      pos+=(valid.size()*width+7)/8;
+    }
+    return b;
+  }
+  const char* slot=data+sizeof(num_slots);
+  for (int i=0;i<num_slots;i++) {
+    Tuple tuple(t.schema_manager,t.schema_index);
+    if (slot[0]==0)
+      tuple.null();
+    else
+      memcpy(tuple.data,slot+1,tuple_size);
+    b.tuples.push_back(tuple);
+    slot+=1+tuple_size;
+  }
+  return b;
+}
+
+//The metadata is one byte string: the catalog, the extents of the tracks
+//and the free extents. It is split over a chain of pages, each starting with
+//the next page of the chain (-1 at the end) and the bytes used in the page.
+bool Disk::readMetadata(int first_page) {
+  string metadata;
+  char data[DISK_PAGE_SIZE];
+  meta_pages.clear();
+  for (int page=first_page;page!=-1;) {
+    if (page<=0 || page>=num_pages || meta_pages.size()>=num_pages) {
+      cerr << "readMetadata ERROR: broken metadata page chain" << endl;
+      return false;
+    }
+    if (!readPage(page,data)) return false;
+    meta_pages.push_back(page);
+    int used;
+    memcpy(&page,data,sizeof(int));
+    memcpy(&used,data+sizeof(int),sizeof(int));
+    if (used<0 || used>DISK_PAGE_SIZE-2*sizeof(int)) {
+      cerr << "readMetadata ERROR: broken metadata page" << endl;
+      return false;
+    }
+    metadata.append(data+2*sizeof(int),used);
+  }
+
+  size_t pos=0;
+  int size,page,tuples;
+  if (!readInt(metadata,pos,size) || size<0 || pos+size>metadata.size()) {
+    cerr << "readMetadata ERROR: broken catalog" << endl;
+    return false;
+  }
+  catalog=metadata.substr(pos,size);
+  pos+=size;
+  int num_tracks;
+  if (!readInt(metadata,pos,num_tracks) || num_tracks<0) {
+    cerr << "readMetadata ERROR: broken track count" << endl;
+    return false;
+  }
+  addTracks(num_tracks);
+  for (int i=0;i<tracks.size();i++) {
+    track_extents[i].clear();
+    track_tuples[i].clear();
+    if (!readInt(metadata,pos,size)) size=-1;
+    int num_extents=(size+DISK_EXTENT_SIZE-1)/DISK_EXTENT_SIZE;
+    for (int j=0;j<num_extents;j++) {
+      if (!readInt(metadata,pos,page) || page<=0 || page+DISK_EXTENT_SIZE>num_pages) {
+        size=-1;
+        break;
+      }
+      track_extents[i].push_back(page);
+    }
+    for (int j=0;j<size;j++) {
+      if (!readInt(metadata,pos,tuples)) {
+        size=-1;
+        break;
+      }
+      track_tuples[i].push_back(tuples);
+    }
+    if (size<0) {
+      cerr << "readMetadata ERROR: broken extents of track " << i << endl;
+      return false;
+    }
+  }
+  free_extents.clear();
+  if (!readInt(metadata,pos,size)) size=-1;
+  for (int j=0;j<size;j++) {
+    if (!readInt(metadata,pos,page) || page<=0 || page+DISK_EXTENT_SIZE>num_pages) {
+      size=-1;
+      break;
+    }
+    free_extents.push_back(page);
+  }
+  if (size<0) {
+    cerr << "readMetadata ERROR: broken free extent list" << endl;
+    return false;
+  }
+  return true;
+}
+
+bool Disk::writeMetadata() {
+  string metadata;
+  appendInt(metadata,catalog.size());
+  metadata+=catalog;
+  appendInt(metadata,tracks.size());
+  for (int i=0;i<tracks.size();i++) {
+    appendInt(metadata,track_tuples[i].size());
+    for (int j=0;j<track_extents[i].size();j++) {
+      appendInt(metadata,track_extents[i][j]);
+    }
+    for (int j=0;j<track_tuples[i].size();j++) {
+      appendInt(metadata,track_tuples[i][j]);
+    }
+  }
+  appendInt(metadata,free_extents.size());
+  for (int j=0;j<free_extents.size();j++) {
+    appendInt(metadata,free_extents[j]);
+  }
+
+  // the chain only grows; the pages it does not need are kept with no bytes
+  const int capacity=DISK_PAGE_SIZE-2*sizeof(int);
+  int needed=(metadata.size()+capacity-1)/capacity;
+  while (meta_pages.size()<needed || meta_pages.empty()) {
+    meta_pages.push_back(num_pages++);
+  }
+  char data[DISK_PAGE_SIZE];
+  size_t pos=0;
+  for (int i=0;i<meta_pages.size();i++) {
+    memset(data,0,DISK_PAGE_SIZE);
+    int next=(i+1<meta_pages.size()?meta_pages[i+1]:-1);
+    int used=min((size_t)capacity,metadata.size()-pos);
+    memcpy(data,&next,sizeof(int));
+    memcpy(data+sizeof(int),&used,sizeof(int));
+    memcpy(data+2*sizeof(int),metadata.data()+pos,used);
+    pos+=used;
+    if (!writePage(meta_pages[i],data)) return false;
+  }
+
+  // the header is written last
+  int header[5]={DISK_PAGE_SIZE,Block::getFieldsPerBlock(),num_pages,meta_pages[0],DISK_EXTENT_SIZE};
+  memset(data,0,DISK_PAGE_SIZE);
+  memcpy(data,DISK_FILE_MAGIC,sizeof(DISK_FILE_MAGIC));
+  memcpy(data+sizeof(DISK_FILE_MAGIC),header,sizeof(header));
+  return writePage(0,data);
+}
+
+//The image is written beside the file and renamed over it, so a crash leaves
+//the old image whole. A new page file takes the extents in order, so every
+//track is stored on consecutive pages.
+bool Disk::saveImage(string file_name, const string& catalog, const vector<Tuple>& tuples) {
+  lock_guard<recursive_mutex> guard(lock);
+  struct stat image_stat, file_stat;
+  if (file>=0 && ::stat(file_name.c_str(),&image_stat)==0 && fstat(file,&file_stat)==0 &&
+      image_stat.st_dev==file_stat.st_dev && image_stat.st_ino==file_stat.st_ino) {
+    cerr << "saveImage ERROR: " << file_name << " is the page file of the disk" << endl;
+    return false;
+  }
+  string temporary=file_name+".tmp";
+  ::unlink(temporary.c_str());
+  bool saved;
+  {
+    Disk image;
+    saved=image.open(temporary);
+    image.addTracks(tracks.size());
+    for (int i=0;saved && i<tracks.size();i++) {
+      for (int j=0;saved && j<getTrackSize(i);j++) {
+        saved=image.writeBlock(i,j,readBlock(i,j,tuples[i]),tuples[i]);
+      }
+    }
+    image.setCatalog(catalog);
+    saved=saved && image.flush();
+  }
+  if (!saved || ::rename(temporary.c_str(),file_name.c_str())!=0) {
+    cerr << "saveImage ERROR: cannot write " << file_name << endl;
+    ::unlink(temporary.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool Disk::closeIntoMemory(const vector<Tuple>& tuples) {
+  lock_guard<recursive_mutex> guard(lock);
+  if (file<0) return true;
+  for (int i=0;i<tracks.size();i++) {
+    vector<Block> blocks;
+    blocks.reserve(getTrackSize(i));
+    for (int j=0;j<getTrackSize(i);j++) {
+      blocks.push_back(readBlock(i,j,tuples[i]));
+    }
+    tracks[i].swap(blocks);
+    track_tuples[i].clear();
+  }
+  // the extents are kept for the latency of the accesses
+  ::close(file);
+  file=-1;
+  meta_pages.clear();
+  catalog="";
+  dirty=false;
+  return true;
+}
+
+string Disk::getCatalog() const {
+  return catalog;
+}
+
+void Disk::setCatalog(const string& catalog) {
+  lock_guard<recursive_mutex> guard(lock);
+  this->catalog=catalog;
+  dirty=true;
+}
+
+Block Disk::getBlock(int schema_index, int block_index, const Tuple& t) {
+  lock_guard<recursive_mutex> guard(lock);
+  if (block_index<0 || block_index>=getTrackSize(schema_index))  {
     cerr << "getBlock ERROR: block index " << block_index << " out of disk bound" << endl;
     return Block::getDummyBlock();
   }
   incrementDiskIOs(1);
-  incrementDiskTimer(1);
+  accountAccess(schema_index,false,1,incrementDiskTimer(schema_index,block_index,1));
   
-  return tracks[schema_index][block_index];
+  return readBlock(schema_index,block_index,t);
 }
 
-vector<Block> Disk::getBlocks(int schema_index, int block_index, int num_blocks) {
-  if (block_index<0 || block_index>=tracks[schema_index].size())  {
+vector<Block> Disk::getBlocks(int schema_index, int block_index, int num_blocks, const Tuple& t) {
+  lock_guard<recursive_mutex> guard(lock);
+  if (block_index<0 || block_index>=getTrackSize(schema_index))  {
     cerr << "getBlocks ERROR: block index " << block_index << " out of disk bound" << endl;
     return vector<Block>();
   }
   int i;
-  if ((i=block_index+num_blocks-1)>=tracks[schema_index].size()) {
+  if ((i=block_index+num_blocks-1)>=getTrackSize(schema_index)) {
     cerr << "getBlocks ERROR: num of blocks out of disk bound: " << i << endl;
     return vector<Block>();
   }
   incrementDiskIOs(num_blocks);
-  incrementDiskTimer(num_blocks);
+  accountAccess(schema_index,false,num_blocks,
+                incrementDiskTimer(schema_index,block_index,num_blocks));
 
-  vector<Block> v(tracks[schema_index].begin()+block_index,
-                  tracks[schema_index].begin()+block_index+num_blocks);
+  if (file<0) {
+    vector<Block> v(tracks[schema_index].begin()+block_index,
+                    tracks[schema_index].begin()+block_index+num_blocks);
+    return v;
+  }
+  vector<Block> v;
+  for (i=block_index;i<block_index+num_blocks;i++) {
+    v.push_back(readBlock(schema_index,i,t));
+  }
   return v;
 }
 
-bool Disk::setBlock(int schema_index, int block_index, const Block& b) {
+bool Disk::setBlock(int schema_index, int block_index, const Block& b, const Tuple& t) {
+  lock_guard<recursive_mutex> guard(lock);
   if (block_index<0)  {
     cerr << "setBlock ERROR: block index " << block_index << " out of disk bound" << endl;
     return false;
   }
+  // the blocks are charged once they have pages
   incrementDiskIOs(1);
-  incrementDiskTimer(1);
-  tracks[schema_index][block_index]=b;
+  if (!writeBlock(schema_index,block_index,b,t)) return false;
+  accountAccess(schema_index,true,1,incrementDiskTimer(schema_index,block_index,1));
   return true;
 }
 
-bool Disk::setBlocks(int schema_index, int block_index, const vector<Block>& vb) {
+bool Disk::setBlocks(int schema_index, int block_index, const vector<Block>& vb, const Tuple& t) {
+  lock_guard<recursive_mutex> guard(lock);
   if (block_index<0)  {
     cerr << "setBlocks ERROR: block index " << block_index << " out of disk bound" << endl;
     return false;
   }
   incrementDiskIOs(vb.size());
-  incrementDiskTimer(vb.size());
-  copy< vector<Block>::const_iterator, vector<Block>::iterator >
-    (vb.begin(),vb.end(),tracks[schema_index].begin()+block_index);
+  for (int i=0;i<vb.size();i++) {
+    if (!writeBlock(schema_index,block_index+i,vb[i],t)) return false;
+  }
+  accountAccess(schema_index,true,vb.size(),
+                incrementDiskTimer(schema_index,block_index,vb.size()));
   return true;
 }
 
@@ -135,18 +689,65 @@ void Disk::incrementDiskIOs(int count) {
   diskIOs+=count;
 }
 
-void Disk::incrementDiskTimer(int num_blocks) {
-  if (SIMULATED_DISK_LATENCY_ON==1) {
-    clock_t start_time;
-    start_time=clock();
-    clock_t delay=(clock_t)(avg_seek_time+avg_rotation_latency+avg_transfer_time_per_block*num_blocks)
-                  *CLOCKS_PER_SEC/1000;
-    while (clock()-start_time < delay){
-    ;
+double Disk::incrementDiskTimer(int schema_index, int block_index, int num_blocks) {
+  //Every run of the blocks on consecutive pages is one access; the extents of
+  //a track need not follow each other
+  double delay=0;
+  for (int i=0;i<num_blocks;) {
+    int page=getPage(schema_index,block_index+i);
+    int run=1;
+    while (i+run<num_blocks && getPage(schema_index,block_index+i+run)==page+run) run++;
+    delay+=latency_model.getAccessTime(run,page==head);
+    head=page+run;
+    i+=run;
+  }
+  latency_model.wait(delay);
+  timer+=delay;
+  return delay;
+}
+
+void Disk::accountAccess(int schema_index, bool write, int num_blocks, double time) {
+  DiskAccessStats* stats[2]={&relation_stats[track_names[schema_index]],
+                             &tag_stats[access_tag]};
+  for (int i=0;i<2;i++) {
+    if (write) {
+      stats[i]->writes++;
+      stats[i]->blocks_written+=num_blocks;
+    } else {
+      stats[i]->reads++;
+      stats[i]->blocks_read+=num_blocks;
     }
+    stats[i]->time+=time;
   }
+}
+
+void Disk::setTrackName(int schema_index, const string& relation_name) {
+  lock_guard<recursive_mutex> guard(lock);
+  track_names[schema_index]=relation_name;
+}
 
-  timer+=avg_seek_time+avg_rotation_latency+avg_transfer_time_per_block*num_blocks;
+void Disk::setAccessTag(int tag) {
+  access_tag=tag;
+}
+
+int Disk::getAccessTag() {
+  return access_tag;
+}
+
+void Disk::resetAccessStats() {
+  lock_guard<recursive_mutex> guard(lock);
+  relation_stats.clear();
+  tag_stats.clear();
+}
+
+map<string,DiskAccessStats> Disk::getRelationAccessStats() const {
+  lock_guard<recursive_mutex> guard(lock);
+  return relation_stats;
+}
+
+map<int,DiskAccessStats> Disk::getTagAccessStats() const {
+  lock_guard<recursive_mutex> guard(lock);
+  return tag_stats;
 }
 
 void Disk::resetDiskIOs() {
@@ -164,10 +765,118 @@ void Disk::resetDiskTimer() {
 double Disk::getDiskTimer() const {
   return timer;
 }
+
+void Disk::setLatencyModel(const DiskLatencyModel& model) {
+  latency_model=model;
+}
+
+int Disk::getNumOfTracks() const {
+  return tracks.size();
+}
+
+DiskLatencyModel Disk::getLatencyModel() const {
+  return latency_model;
+}
+
+bool Disk::open(string file_name) {
+  if (file>=0) {
+    cerr << "open ERROR: a page file is already open" << endl;
+    return false;
+  }
+  for (int i=0;i<tracks.size();i++) {
+    if (!tracks[i].empty()) {
+      cerr << "open ERROR: track " << i << " is not empty" << endl;
+      return false;
+    }
+  }
+  file=::open(file_name.c_str(),O_RDWR|O_CREAT,0644);
+  if (file<0) {
+    cerr << "open ERROR: cannot open " << file_name << endl;
+    return false;
+  }
+
+  // the tracks are empty, so no extent is in use
+  free_extents.clear();
+  head=-1;
+
+  char data[DISK_PAGE_SIZE];
+  ssize_t size=pread(file,data,DISK_PAGE_SIZE,0);
+  if (size==0) { // a new page file
+    num_pages=1;
+    dirty=true;
+    return sync();
+  }
+
+  int header[5];
+  memcpy(header,data+sizeof(DISK_FILE_MAGIC),sizeof(header));
+  if (size!=DISK_PAGE_SIZE || memcmp(data,DISK_FILE_MAGIC,sizeof(DISK_FILE_MAGIC))!=0) {
+    cerr << "open ERROR: " << file_name << " is not a page file" << endl;
+  } else if (header[0]!=DISK_PAGE_SIZE || header[1]!=Block::getFieldsPerBlock() ||
+             header[4]!=DISK_EXTENT_SIZE) {
+    cerr << "open ERROR: " << file_name << " was created with a different disk configuration" << endl;
+  } else {
+    num_pages=header[2];
+    if (readMetadata(header[3])) {
+      dirty=false;
+      return true;
+    }
+  }
+  for (int i=0;i<tracks.size();i++) {
+    track_extents[i].clear();
+    track_tuples[i].clear();
+  }
+  free_extents.clear();
+  num_pages=0;
+  meta_pages.clear();
+  catalog="";
+  ::close(file);
+  file=-1;
+  return false;
+}
+
+bool Disk::isOpen() const {
+  return file>=0;
+}
+
+bool Disk::sync() {
+  lock_guard<recursive_mutex> guard(lock);
+  if (file<0 || !dirty) return true;
+  if (!writeMetadata()) return false;
+  dirty=false;
+  return true;
+}
+
+bool Disk::flush() {
+  lock_guard<recursive_mutex> guard(lock);
+  if (!sync()) return false;
+  if (file>=0 && fsync(file)!=0) {
+    cerr << "flush ERROR: cannot sync the page file" << endl;
+    return false;
+  }
+  return true;
+}
+
+void Disk::startJournal(DiskJournal* journal) {
+  lock_guard<recursive_mutex> guard(lock);
+  this->journal=journal;
+  // the pages past the end of the file were never written
+  int written_pages=0;
+  if (journal!=NULL && file>=0) {
+    written_pages=min(num_pages,(int)(lseek(file,0,SEEK_END)/DISK_PAGE_SIZE));
+  }
+  unsaved.assign(written_pages,true);
+  // the free extents hold nothing to put back
+  for (int i=0;i<free_extents.size();i++) {
+    for (int j=0;j<DISK_EXTENT_SIZE && free_extents[i]+j<unsaved.size();j++) {
+      unsaved[free_extents[i]+j]=false;
+    }
+  }
+}
     
-Schema::Schema() {}
+Schema::Schema() { tuple_size=0; compressed=false; }
 
 Schema::Schema(const vector<string>& field_names, const vector<enum FIELD_TYPE>& field_types){
+  compressed=false;
   if(field_names.size()!=field_types.size()){
     cerr<<"Schema ERROR: size of field_names and size of field_types do not match"<<endl;
     return;
@@ -198,6 +907,7 @@ Schema::Schema(const vector<string>& field_names, const vector<enum FIELD_TYPE>&
   }
   this->field_names = field_names;
   this->field_types = field_types;
+  tuple_size=0;
   for(int i=0;i<field_names.size();i++){
      field_offsets[field_names[i]] = i;
      if (field_types[i]!=INT && field_types[i]!=STR20) {
@@ -205,6 +915,8 @@ Schema::Schema(const vector<string>& field_names, const vector<enum FIELD_TYPE>&
        clear();
        return;
      }
+     field_positions[i]=tuple_size;
+     tuple_size+=(field_types[i]==INT?sizeof(int):sizeof(Str20));
   }
 }
 
@@ -233,6 +945,8 @@ void Schema::clear() {
   field_offsets.clear();
   this->field_names.clear();
   this->field_types.clear();
+  tuple_size=0;
+  compressed=false;
 }
 
 //returns the field names in defined order
@@ -287,7 +1001,21 @@ int Schema::getNumOfFields() const {
 }
 
 int Schema::getTuplesPerBlock() const {
-  return FIELDS_PER_BLOCK/field_names.size();
+  int tuples_per_block=Block::getFieldsPerBlock()/field_names.size();
+  return compressed?tuples_per_block*MAX_COMPRESSION_RATIO:tuples_per_block;
+}
+
+bool Schema::isCompressed() const {
+  return compressed;
+}
+
+void Schema::setCompressed(bool compressed) {
+  this->compressed=compressed;
+}
+
+int Schema::getBlockBytes() const {
+  int tuples_per_block=Block::getFieldsPerBlock()/field_names.size();
+  return sizeof(unsigned short)+tuples_per_block*(1+tuple_size);
 }
 
 void Schema::printSchema() const {
@@ -323,13 +1051,8 @@ ostream &operator<<(ostream &out, const Schema &s) {
 Tuple::Tuple(SchemaManager* schema_manager, int schema_index){
   this->schema_manager=schema_manager;
   this->schema_index=schema_index;
-  if (this->schema_manager!=NULL) {
-    Schema& schema=schema_manager->schemas[schema_index];
-    int numberOfFields=schema.getNumOfFields();
-    for (int i=0;i<numberOfFields;i++) {
-      fields.push_back(Field());
-    }
-  }
+  this->valid=(schema_manager!=NULL);
+  memset(data,0,sizeof(data));
 }
 
 Tuple Tuple::getDummyTuple() {
@@ -337,13 +1060,17 @@ Tuple Tuple::getDummyTuple() {
 }
 
 bool Tuple::isNull() const {
-  return fields.size()==0;
+  return !valid;
 }
 
 Schema Tuple::getSchema() const {
   return schema_manager->schemas[schema_index];
 }
 
+const Schema& Tuple::getSchemaRef() const {
+  return schema_manager->schemas[schema_index];
+}
+
 int Tuple::getNumOfFields() const {
   Schema& schema=schema_manager->schemas[schema_index];
   return schema.getNumOfFields();
@@ -354,8 +1081,12 @@ int Tuple::getTuplesPerBlock() const {
   return schema.getTuplesPerBlock();
 }
 
+int Tuple::getSize() const {
+  return schema_manager->schemas[schema_index].tuple_size;
+}
+
 void Tuple::null() {
-  fields.clear();
+  valid=false;
 }
 
 bool Tuple::setField(int offset,string s){
@@ -366,8 +1097,13 @@ bool Tuple::setField(int offset,string s){
   } else if (schema.getFieldType(offset)!=STR20) {
     cerr<<"setField ERROR: field type not STR20!"<<endl;
     return false;
+  } else if (s.size()>STR20_CAPACITY) {
+    cerr<<"setField ERROR: string longer than "<<STR20_CAPACITY<<" characters!"<<endl;
+    return false;
   } else {
-    fields[offset].str=new string(s);
+    Str20* str=(Str20*)(data+schema.field_positions[offset]);
+    str->length=s.size();
+    memcpy(str->chars,s.data(),s.size());
   }
   return true;
 }
@@ -381,7 +1117,7 @@ bool Tuple::setField(int offset,int i){
     cerr<<"setField ERROR: field type not INT!"<<endl;
     return false;
   } else {
-    fields[offset].integer=i;
+    memcpy(data+schema.field_positions[offset],&i,sizeof(int));
   }
   return true;
 }
@@ -392,14 +1128,7 @@ bool Tuple::setField(string field_name,string s){
     cerr<<"setField ERROR: field name " << field_name << " not found"<<endl;
     return false;
   }
-  int offset=schema.getFieldOffset(field_name);
-  if (schema.getFieldType(offset)!=STR20) {
-    cerr<<"setField ERROR: field type not STR20!"<<endl;
-    return false;
-  } else {
-    fields[offset].str=new string(s);
-  }
-  return true;
+  return setField(schema.getFieldOffset(field_name),s);
 }
 
 bool Tuple::setField(string field_name,int i){
@@ -408,34 +1137,30 @@ bool Tuple::setField(string field_name,int i){
     cerr<<"setField ERROR: field name " << field_name << " not found"<<endl;
     return false;
   }
-  int offset=schema.getFieldOffset(field_name);
-  if (schema.getFieldType(offset)!=INT) {
-    cerr<<"setField ERROR: field type not INT!"<<endl;
-    return false;
-  } else {
-    fields[offset].integer=i;
-  }
-  return true;
+  return setField(schema.getFieldOffset(field_name),i);
 }
 
 union Field Tuple::getField(int offset) const{
-  if(offset<fields.size() && offset>=0){
-    return fields[offset];
+  Field field;
+  if(valid && offset>=0 && offset<getNumOfFields()){
+    Schema& schema=schema_manager->schemas[schema_index];
+    const char* position=data+schema.field_positions[offset];
+    if (schema.field_types[offset]==INT) {
+      memcpy(&field.integer,position,sizeof(int));
+    } else {
+      const Str20* str=(const Str20*)position;
+      field.str.length=str->length;
+      memcpy(field.str.chars,str->chars,str->length);
+    }
   } else {
     cerr<<"getField ERROR: offset "<<offset<<" is out of bound!"<<endl;
-    return Field();
   }
+  return field;
 }
 
 union Field Tuple::getField(string field_name) const{
   Schema& schema=schema_manager->schemas[schema_index];
-  int offset=schema.getFieldOffset(field_name);
-  if(offset<fields.size() && offset>=0){
-    return fields[offset];
-  } else {
-    cerr<<"getField ERROR: offset "<<offset<<" is out of bound!"<<endl;
-    return Field();
-  }
+  return getField(schema.getFieldOffset(field_name));
 }
 
 void Tuple::printTuple() const{
@@ -457,11 +1182,13 @@ void Tuple::printTuple(bool print_field_names, ostream &out) const {
     schema.printFieldNames(out);
     out << endl;
   }
-  for (int i=0;i<fields.size();i++) {
+  int num_fields=(valid?schema.getNumOfFields():0);
+  for (int i=0;i<num_fields;i++) {
+    Field field=getField(i);
     if (schema.getFieldType(i)==INT)
-      out << fields[i].integer << "\t";
+      out << field.integer << "\t";
     else
-      out << *(fields[i].str) << "\t";
+      out << *(field.str) << "\t";
   }
 }
 
@@ -470,16 +1197,128 @@ ostream &operator<<(ostream &out, const Tuple &t) {
   return out;
 }
 
+int Block::fields_per_block=FIELDS_PER_BLOCK;
+
 Block::Block() {}
 
+bool Block::setFieldsPerBlock(int fields_per_block) {
+  //a full block of STR20 tuples of one field each has to fit in a page
+  int max_fields=(DISK_PAGE_SIZE-sizeof(unsigned short))/(1+sizeof(Str20));
+  if (fields_per_block<MAX_NUM_OF_FIELDS_IN_RELATION || fields_per_block>max_fields) {
+    cerr << "setFieldsPerBlock ERROR: " << fields_per_block << " is not in ["
+         << MAX_NUM_OF_FIELDS_IN_RELATION << "," << max_fields << "]" << endl;
+    return false;
+  }
+  Block::fields_per_block=fields_per_block;
+  return true;
+}
+
+int Block::getFieldsPerBlock() {
+  return fields_per_block;
+}
+
 Block Block::getDummyBlock() {
   return Block();
 }
 
 bool Block::isFull() const {
   if (tuples.empty()) return false;
-  if (tuples.size()==tuples.front().getTuplesPerBlock()) return true;
-  return false;
+  // a block of compressed tuples read into a plain relation can hold more
+  if (tuples.size()>=tuples.front().getTuplesPerBlock()) return true;
+  if (!tuples.front().getSchemaRef().isCompressed()) return false;
+  // a copy of a valid tuple is the cheapest tuple to add
+  vector<Tuple>::const_reverse_iterator last=tuples.rbegin();
+  while (last!=tuples.rend()-1 && last->isNull()) last++;
+  vector<Tuple> more(tuples);
+  more.push_back(*last);
+  return !fits(more);
+}
+
+bool Block::hasRoomFor(const Tuple& tuple) const {
+  int offset=0;
+  while (offset<tuples.size() && !tuples[offset].isNull()) offset++;
+  if (!tuple.getSchemaRef().isCompressed()) {
+    return offset<tuples.size() || offset<tuple.getTuplesPerBlock();
+  }
+  vector<Tuple> more(tuples);
+  if (offset<more.size()) more[offset]=tuple;
+  else more.push_back(tuple);
+  return fits(more);
+}
+
+bool Block::fits(const vector<Tuple>& tuples) {
+  if (tuples.empty()) return true;
+  const Schema& schema=tuples.front().getSchemaRef();
+  if (tuples.size()>schema.getTuplesPerBlock()) return false;
+  if (!schema.isCompressed() ||
+      tuples.size()<=Block::getFieldsPerBlock()/schema.getNumOfFields()) return true;
+  return encodeCompressed(tuples,NULL)<=schema.getBlockBytes();
+}
+
+//The page starts with the number of slots, with COMPRESSED_BLOCK_FLAG set, and a bit
+//for every slot telling if its tuple is valid. For every field follow, for an INT field
+//the smallest value and the bits of every difference from it, and for a STR20 field the
+//number of distinct values, the values with their lengths and the bits of the position
+//of every value among them; the bits of the valid tuples are packed one after another.
+int Block::encodeCompressed(const vector<Tuple>& tuples, char* data) {
+  const Schema& schema=tuples.front().getSchemaRef();
+  unsigned short num_slots=tuples.size()|COMPRESSED_BLOCK_FLAG;
+  if (data) memcpy(data,&num_slots,sizeof(num_slots));
+  int size=sizeof(num_slots);
+  vector<const Tuple*> valid;
+  for (int i=0;i<tuples.size();i++) {
+    if (tuples[i].isNull()) continue;
+    if (data) packBits(data+size,i,1,1);
+    valid.push_back(&tuples[i]);
+  }
+  size+=(tuples.size()+7)/8;
+  vector<unsigned int> codes(valid.size());
+  for (int f=0;f<schema.getNumOfFields();f++) {
+    int width;
+    if (schema.getFieldType(f)==INT) {
+      vector<int> values(valid.size());
+      int base=0,top=0;
+      for (int i=0;i<valid.size();i++) {
+        values[i]=valid[i]->getField(f).integer;
+        if (i==0 || values[i]<base) base=values[i];
+        if (i==0 || values[i]>top) top=values[i];
+      }
+      width=bitWidth((long long)top-base);
+      for (int i=0;i<valid.size();i++) {
+        codes[i]=(unsigned int)((long long)values[i]-base);
+      }
+      if (data) {
+        memcpy(data+size,&base,sizeof(int));
+        data[size+sizeof(int)]=(char)width;
+      }
+      size+=sizeof(int)+1;
+    } else {
+      map<string,unsigned int> positions;
+      vector<string> values;
+      for (int i=0;i<valid.size();i++) {
+        pair<map<string,unsigned int>::iterator,bool> entry=
+          positions.insert(make_pair(*(valid[i]->getField(f).str),values.size()));
+        if (entry.second) values.push_back(entry.first->first);
+        codes[i]=entry.first->second;
+      }
+      unsigned short num_values=values.size();
+      width=bitWidth(num_values>0?num_values-1:0);
+      if (data) memcpy(data+size,&num_values,sizeof(num_values));
+      size+=sizeof(num_values);
+      for (int j=0;j<values.size();j++) {
+        if (data) {
+          data[size]=(char)values[j].size();
+          memcpy(data+size+1,values[j].data(),values[j].size());
+        }
+        size+=1+values[j].size();
+      }
+    }
+    if (data) {
+      for (int i=0;i<valid.size();i++) packBits(data+size,(long)i*width,width,codes[i]);
+    }
+    size+=(valid.size()*width+7)/8;
+  }
+  return size;
 }
 
 bool Block::isEmpty() const {
@@ -500,10 +1339,7 @@ int Block::getNumTuples() const {
 }
 
 Tuple Block::getTuple(int tuple_offset) const { // gets the tuple value at tuple_index; returns empty Tuple if tuple_index out of bound
-  if (!tuples.empty() && tuple_offset>=tuples.front().getTuplesPerBlock()) {
-    cerr << "getTuple ERROR: tuple offet " << tuple_offset << " out of bound of the block" << endl;
-    return Tuple::getDummyTuple();
-  }
+  // a block read from a page of compressed tuples may hold more than getTuplesPerBlock()
   if (tuple_offset<0 || tuple_offset>=tuples.size()) {
     cerr << "getTuple ERROR: tuple offet " << tuple_offset << " out of bound" << endl;
     return Tuple::getDummyTuple();
@@ -515,10 +1351,18 @@ vector<Tuple> Block::getTuples() const {
   return tuples;
 }
 
+vector<Tuple>::const_iterator Block::begin() const {
+  return tuples.begin();
+}
+
+vector<Tuple>::const_iterator Block::end() const {
+  return tuples.end();
+}
+
 bool Block::setTuple(int tuple_offset, const Tuple& tuple) { // sets new tuple value at tuple_index; returns false if tuple_index out of bound
   Schema s = tuple.getSchema();
   if (!tuples.empty()) {
-    if (tuple_offset>=tuples.front().getTuplesPerBlock()) {
+    if (tuple_offset>=tuples.front().getTuplesPerBlock() && tuple_offset>=tuples.size()) {
       cerr << "setTuple ERROR: tuple offet " << tuple_offset << " out of bound of the block" << endl;
       return false;
     }
@@ -529,10 +1373,25 @@ bool Block::setTuple(int tuple_offset, const Tuple& tuple) { // sets new tuple v
       }
     }
   }
-  if (tuple_offset<0 || tuple_offset>=s.getTuplesPerBlock()) {
+  if (tuple_offset<0 || (tuple_offset>=s.getTuplesPerBlock() && tuple_offset>=tuples.size())) {
     cerr << "setTuple ERROR: tuple offet " << tuple_offset << " out of bound" << endl;
     return false;
   }
+  if (s.isCompressed()) {
+    vector<Tuple> stored(tuples);
+    if (tuple_offset<stored.size()) stored[tuple_offset]=tuple;
+    else {
+      stored.resize(tuple_offset,tuple);
+      for (int i=tuples.size();i<tuple_offset;i++) stored[i].null();
+      stored.push_back(tuple);
+    }
+    if (!fits(stored)) {
+      cerr << "setTuple ERROR: the tuple does not fit in the block" << endl;
+      return false;
+    }
+    tuples.swap(stored);
+    return true;
+  }
   if (tuple_offset >= tuples.size()) {
     //If there is a gap before the offset, filled it with invalid tuples
     Tuple t(tuple.schema_manager,tuple.schema_index);
@@ -547,7 +1406,7 @@ bool Block::setTuple(int tuple_offset, const Tuple& tuple) { // sets new tuple v
 }
 
 bool Block::setTuples(const vector<Tuple>& tuples) {
-  if (tuples.size()>tuples.front().getTuplesPerBlock()) {
+  if (!fits(tuples)) {
     cerr << "setTuples ERROR: number of tuples exceed space limit of the block" << endl;
     return false;
   }
@@ -556,20 +1415,22 @@ bool Block::setTuples(const vector<Tuple>& tuples) {
 }
 
 bool Block::setTuples(const vector<Tuple>::const_iterator first, const vector<Tuple>::const_iterator last) {
-  if (last-first > first->getTuplesPerBlock()) {
+  vector<Tuple> tuples(first,last);
+  if (!fits(tuples)) {
     cerr << "setTuples ERROR: number of tuples exceed space limit of the block" << endl;
     return false;
   }
-  this->tuples.assign(first,last);
+  this->tuples.swap(tuples);
   return true;
 }
 
 bool Block::appendTuple(const Tuple& tuple) {
-  if (isFull()) {
+  this->tuples.push_back(tuple);
+  if (!fits(this->tuples)) {
+    this->tuples.pop_back();
     cerr << "appendTuple ERROR: the block is full" << endl;
     return false;
   }
-  this->tuples.push_back(tuple);
   return true;
 }
 
@@ -651,23 +1512,21 @@ Schema Relation::getSchema() const {
   return schema_manager->schemas[schema_index];
 }
 
+const Schema& Relation::getSchemaRef() const {
+  return schema_manager->schemas[schema_index];
+}
+
 //NOTE: Because the operation should not have disk latency,
 //      it is implemented in Relation instead of in Disk
 int Relation::getNumOfBlocks() const {
-  vector<Block>& data=disk->tracks[schema_index];
-  return data.size();
+  return disk->getTrackSize(schema_index);
 }
 
 // returns actual number of tuples in the relation
 //NOTE: Because the operation should not have disk latency,
 //      it is implemented in Relation instead of in Disk
 int Relation::getNumOfTuples() const {
-  vector<Block>& data=disk->tracks[schema_index];
-  int total_tuples=0;
-  for (vector<Block>::const_iterator vit=data.begin();vit!=data.end();vit++) {
-    total_tuples+=vit->getNumTuples();
-  }
-  return total_tuples;
+  return disk->getTrackTuples(schema_index);
 }
 
 bool Relation::isNull() const {
@@ -681,7 +1540,7 @@ Tuple Relation::createTuple() const {
 bool Relation::getBlock(int relation_block_index, int memory_block_index) const {
   //delay();
   //DIOs++;
-  if (memory_block_index<0 || memory_block_index>=NUM_OF_BLOCKS_IN_MEMORY) {
+  if (memory_block_index<0 || memory_block_index>=mem->getMemorySize()) {
     cerr << "getBlock ERROR: block index " << memory_block_index << " out of bound in memory" << endl;
     return false;
   }
@@ -692,7 +1551,8 @@ bool Relation::getBlock(int relation_block_index, int memory_block_index) const
   }
   */
   //mem->setBlock(memory_block_index,data[relation_block_index]);
-  Block b = disk->getBlock(schema_index,relation_block_index);
+  Tuple t(schema_manager,schema_index);
+  Block b = disk->getBlock(schema_index,relation_block_index,t);
   if (!b.isEmpty()) {
     mem->setBlock(memory_block_index,b);
     return true;
@@ -707,12 +1567,12 @@ bool Relation::getBlocks(int relation_block_index, int memory_block_index, int n
     cerr << "getBlocks ERROR: num of blocks " << num_blocks << " too few" << endl;
     return false;
   }
-  if (memory_block_index<0 || memory_block_index>=NUM_OF_BLOCKS_IN_MEMORY) {
+  if (memory_block_index<0 || memory_block_index>=mem->getMemorySize()) {
     cerr << "getBlocks ERROR: block index " << memory_block_index << " out of bound in memory" << endl;
     return false;
   }
   int i;
-  if ((i=memory_block_index+num_blocks-1)>=NUM_OF_BLOCKS_IN_MEMORY) {
+  if ((i=memory_block_index+num_blocks-1)>=mem->getMemorySize()) {
     cerr << "getBlocks ERROR: access to block out of memory bound" << i << endl;
     return false;
   }
@@ -728,7 +1588,8 @@ bool Relation::getBlocks(int relation_block_index, int memory_block_index, int n
   mem->setBlock(memory_block_index,data.begin()+relation_block_index,
                 data.begin()+relation_block_index+num_blocks);
   */
-  vector<Block> v=disk->getBlocks(schema_index,relation_block_index,num_blocks);
+  Tuple t(schema_manager,schema_index);
+  vector<Block> v=disk->getBlocks(schema_index,relation_block_index,num_blocks,t);
   mem->setBlock(memory_block_index,v.begin(),v.end());
   return true;  
 }
@@ -736,7 +1597,7 @@ bool Relation::getBlocks(int relation_block_index, int memory_block_index, int n
 bool Relation::setBlock(int relation_block_index, int memory_block_index) {
   //delay();
   //DIOs++;
-  if (memory_block_index<0 || memory_block_index>=NUM_OF_BLOCKS_IN_MEMORY) {
+  if (memory_block_index<0 || memory_block_index>=mem->getMemorySize()) {
     cerr << "setBlock ERROR: block index" << memory_block_index << " out of bound in memory" << endl;
     return false;
   }
@@ -761,7 +1622,7 @@ bool Relation::setBlock(int relation_block_index, int memory_block_index) {
   t.null(); //invalidates the tuple
   if (disk->extendTrack(schema_index,relation_block_index+1,t)) {
     //Actual writing on disk
-    return disk->setBlock(schema_index,relation_block_index,*(mem->getBlock(memory_block_index)));
+    return disk->setBlock(schema_index,relation_block_index,*(mem->getBlock(memory_block_index)),t);
   }
   return false;
 }
@@ -773,12 +1634,12 @@ bool Relation::setBlocks(int relation_block_index, int memory_block_index, int n
     cerr << "setBlocks ERROR: num of blocks " << num_blocks << " too few" << endl;
     return false;
   }
-  if (memory_block_index<0 || memory_block_index>=NUM_OF_BLOCKS_IN_MEMORY) {
+  if (memory_block_index<0 || memory_block_index>=mem->getMemorySize()) {
     cerr << "setBlocks ERROR: block index " << memory_block_index << " out of bound in memory" << endl;
     return false;
   }
   int i;
-  if ((i=memory_block_index+num_blocks-1)>=NUM_OF_BLOCKS_IN_MEMORY) {
+  if ((i=memory_block_index+num_blocks-1)>=mem->getMemorySize()) {
     cerr << "setBlocks ERROR: access to block out of memory bound: " << i << endl;
     return false;
   }
@@ -809,7 +1670,7 @@ bool Relation::setBlocks(int relation_block_index, int memory_block_index, int n
   t.null(); //invalidates the tuple
   if (disk->extendTrack(schema_index,relation_block_index+num_blocks,t)) {
     //Actual writing on disk
-    return disk->setBlocks(schema_index,relation_block_index,vb);
+    return disk->setBlocks(schema_index,relation_block_index,vb,t);
   }
   return false;
 }
@@ -827,16 +1688,15 @@ void Relation::printRelation() const {
 //NOTE: Because the operation should not have disk latency,
 //      it is implemented in Relation instead of in Disk
 void Relation::printRelation(ostream &out) const {
-  vector<Block>& data=disk->tracks[schema_index];
-  int i=0;
+  Tuple t(schema_manager,schema_index);
+  int num_blocks=disk->getTrackSize(schema_index);
   out << "******RELATION DUMP BEGIN******" << endl;
   schema_manager->schemas[schema_index].printFieldNames(out);
   out << endl;
-  for (vector<Block>::const_iterator vit=data.begin();vit!=data.end();vit++) {
+  for (int i=0;i<num_blocks;i++) {
     out << i << ": ";
-    vit->printBlock(out);
+    disk->readBlock(schema_index,i,t).printBlock(out);
     out << endl;
-    i++;
   }
   out << "******RELATION DUMP END******";
 }
@@ -846,17 +1706,27 @@ ostream &operator<<(ostream &out, const Relation &r) {
   return out;
 }
 
-MainMemory::MainMemory() { }
+MainMemory::MainMemory() {
+  blocks.resize(NUM_OF_BLOCKS_IN_MEMORY,Block());
+}
+
+MainMemory::MainMemory(int num_blocks) {
+  if (num_blocks<=0) {
+    cerr << "MainMemory ERROR: " << num_blocks << " blocks; using " << NUM_OF_BLOCKS_IN_MEMORY << endl;
+    num_blocks=NUM_OF_BLOCKS_IN_MEMORY;
+  }
+  blocks.resize(num_blocks,Block());
+}
 
 bool MainMemory::setBlock(int memory_block_index, const vector<Block>::const_iterator first,
               const vector<Block>::const_iterator last) {
-  if (memory_block_index<0 || memory_block_index>=NUM_OF_BLOCKS_IN_MEMORY) {
+  if (memory_block_index<0 || memory_block_index>=getMemorySize()) {
     cerr << "setBlock ERROR: block index " << memory_block_index << " out of memory bound" << endl;
     return false;
   }
   int i=memory_block_index;
   for (vector<Block>::const_iterator it=first;it!=last;it++) {
-    if (i>=NUM_OF_BLOCKS_IN_MEMORY) {
+    if (i>=getMemorySize()) {
       cerr << "setBlock ERROR: number of blocks reaches memory boundary" << endl;
       return false;
     }
@@ -867,19 +1737,19 @@ bool MainMemory::setBlock(int memory_block_index, const vector<Block>::const_ite
 }
               
 int MainMemory::getMemorySize() const { //returns max number of blocks
-  return NUM_OF_BLOCKS_IN_MEMORY;
+  return blocks.size();
 }
 
 Block* MainMemory::getBlock(int memory_block_index) {
-  if (memory_block_index<0 || memory_block_index>=NUM_OF_BLOCKS_IN_MEMORY) {
+  if (memory_block_index<0 || memory_block_index>=getMemorySize()) {
     cerr << "getBlock ERROR: block index " << memory_block_index << " out of memory bound" << endl;
     return NULL;
   }
-  return blocks+memory_block_index;
+  return &blocks[memory_block_index];
 }
 
 bool MainMemory::setBlock(int memory_block_index, const Block& b) {
-  if (memory_block_index<0 || memory_block_index>=NUM_OF_BLOCKS_IN_MEMORY) {
+  if (memory_block_index<0 || memory_block_index>=getMemorySize()) {
     cerr << "setBlock ERROR: block index " << memory_block_index << " out of memory bound" << endl;
     return false;
   }  
@@ -888,7 +1758,7 @@ bool MainMemory::setBlock(int memory_block_index, const Block& b) {
 }
 
 vector<Tuple> MainMemory::getTuples(int memory_block_begin,int num_blocks) const { //gets tuples from a range of blocks
-  if (memory_block_begin<0 || memory_block_begin>=NUM_OF_BLOCKS_IN_MEMORY) {
+  if (memory_block_begin<0 || memory_block_begin>=getMemorySize()) {
     cerr << "getTuples ERROR: block index " << memory_block_begin << " out of memory bound" << endl;
     return vector<Tuple>();
   }
@@ -897,7 +1767,7 @@ vector<Tuple> MainMemory::getTuples(int memory_block_begin,int num_blocks) const
     return vector<Tuple>();     
   }
   int i;
-  if ((i=memory_block_begin+num_blocks-1)>=NUM_OF_BLOCKS_IN_MEMORY ) {
+  if ((i=memory_block_begin+num_blocks-1)>=getMemorySize()) {
     cerr << "getTuples ERROR: access to block out of memory bound: " << i << endl;
     return vector<Tuple>();    
   }
@@ -920,7 +1790,7 @@ vector<Tuple> MainMemory::getTuples(int memory_block_begin,int num_blocks) const
 //writes tuples consecutively starting from a particular memory block;
 //returns false if out of bound in memory
 bool MainMemory::setTuples(int memory_block_begin,const vector<Tuple>& tuples) {
-  if (memory_block_begin<0 || memory_block_begin>=NUM_OF_BLOCKS_IN_MEMORY) {
+  if (memory_block_begin<0 || memory_block_begin>=getMemorySize()) {
     cerr << "setTuples ERROR: block index " << memory_block_begin << " out of memory bound" << endl;
     return false;
   }
@@ -928,7 +1798,7 @@ bool MainMemory::setTuples(int memory_block_begin,const vector<Tuple>& tuples) {
   int num_blocks=tuples.size()/tuples_per_block;
   int num_additional_blocks=(tuples.size()%tuples_per_block>0?1:0);
   if (memory_block_begin + num_blocks + num_additional_blocks >
-       NUM_OF_BLOCKS_IN_MEMORY) {
+       getMemorySize()) {
     cerr << "setTuples ERROR: number of tuples exceed the memory space" << endl;
     return false;
   }
@@ -954,7 +1824,7 @@ void MainMemory::dumpMemory() const {
 
 void MainMemory::dumpMemory(ostream &out) const {
   out << "******MEMORY DUMP BEGIN******" << endl;
-  for (int i=0;i<NUM_OF_BLOCKS_IN_MEMORY;i++) {
+  for (int i=0;i<getMemorySize();i++) {
     out << i << ": ";
     blocks[i].printBlock(out);
     out << endl;
@@ -970,11 +1840,10 @@ ostream &operator<<(ostream &out, const MainMemory &m) {
 SchemaManager::SchemaManager(MainMemory* mem, Disk* disk) {
   this->mem=mem;
   this->disk=disk;
-  offset=0;
 }
 
 Schema SchemaManager::getSchema(string relation_name) const {
-  map<string,int>::const_iterator it=relation_name_to_index.find(relation_name);
+  unordered_map<string,int>::const_iterator it=relation_name_to_index.find(relation_name);
   if (it==relation_name_to_index.end()) {
     cerr << "getSchema ERROR: relation " << relation_name << " does not exist" << endl;
     return Schema();
@@ -984,7 +1853,7 @@ Schema SchemaManager::getSchema(string relation_name) const {
 }
 
 bool SchemaManager::relationExists(string relation_name) const {
-  map<string,int>::const_iterator it=relation_name_to_index.find(relation_name);
+  unordered_map<string,int>::const_iterator it=relation_name_to_index.find(relation_name);
   if (it==relation_name_to_index.end())
     return false;
   return true;
@@ -995,7 +1864,7 @@ Relation* SchemaManager::createRelation(string relation_name,const Schema& schem
     cerr << "createRelation ERROR: empty relation name" << endl;
     return NULL;
   }
-  map<string,int>::iterator it=relation_name_to_index.find(relation_name);
+  unordered_map<string,int>::iterator it=relation_name_to_index.find(relation_name);
   if (it!=relation_name_to_index.end()) {
     cerr << "createRelation ERROR: " << relation_name << " already exists" << endl;
     return NULL;
@@ -1004,19 +1873,18 @@ Relation* SchemaManager::createRelation(string relation_name,const Schema& schem
     cerr << "createRelation ERROR: empty schema" << endl;
     return NULL;
   }
-  if (offset==MAX_NUM_CREATING_RELATIONS) {
-    cerr << "createRelation ERROR: no more relations can be created." << endl;
-    return NULL;
+  int index=relations.size();
+  if (!free_indices.empty()) { // reuse the slot of a deleted relation
+    index=free_indices.back();
+    free_indices.pop_back();
   }
-  relation_name_to_index[relation_name]=offset;
-  relations[offset]=Relation(this,offset,relation_name,mem,disk);
-  schemas[offset]=schema;
-  offset++; // increase the boundary
-  return &relations[offset-1];
+  Relation* relation=addRelation(relation_name,schema,index);
+  saveCatalog();
+  return relation;
 }
 
 Relation* SchemaManager::getRelation(string relation_name) {
-  map<string,int>::iterator it=relation_name_to_index.find(relation_name);
+  unordered_map<string,int>::iterator it=relation_name_to_index.find(relation_name);
   if(it==relation_name_to_index.end()){
     cerr << "getRelation ERROR: relation " << relation_name << " does not exist" << endl;
     return NULL;
@@ -1026,7 +1894,8 @@ Relation* SchemaManager::getRelation(string relation_name) {
 }
 
 bool SchemaManager::deleteRelation(string relation_name) {
-  map<string,int>::iterator it;
+  lock_guard<recursive_mutex> guard(disk->lock);
+  unordered_map<string,int>::iterator it;
   if ((it=relation_name_to_index.find(relation_name))==relation_name_to_index.end()) {
     cerr << "deleteRelation ERROR: relation " << relation_name << " does not exist" << endl;
     return false;
@@ -1035,6 +1904,105 @@ bool SchemaManager::deleteRelation(string relation_name) {
   relations[offset].null();
   schemas[offset].clear();
   relation_name_to_index.erase(it);
+  disk->clearTrack(offset);
+  free_indices.push_back(offset);
+  saveCatalog();
+  return true;
+}
+
+Relation* SchemaManager::addRelation(string relation_name, const Schema& schema, int index) {
+  lock_guard<recursive_mutex> guard(disk->lock);
+  while (relations.size()<=index) {
+    if (relations.size()<index) free_indices.push_back(relations.size());
+    relations.push_back(Relation());
+    schemas.push_back(Schema());
+  }
+  disk->addTracks(index+1);
+  disk->setTrackName(index,relation_name);
+  relation_name_to_index[relation_name]=index;
+  relations[index]=Relation(this,index,relation_name,mem,disk);
+  schemas[index]=schema;
+  return &relations[index];
+}
+
+//The catalog has one line per relation:
+//  schema index, relation name, number of fields, the name and type of every field,
+//  and "compressed" if the blocks of the relation are compressed
+void SchemaManager::saveCatalog() {
+  if (!disk->isOpen()) return;
+  disk->setCatalog(encodeCatalog());
+}
+
+string SchemaManager::encodeCatalog() const {
+  ostringstream catalog;
+  for (int i=0;i<relations.size();i++) {
+    if (relations[i].isNull()) continue;
+    catalog << i << " " << relations[i].getRelationName() << " " << schemas[i].getNumOfFields();
+    for (int j=0;j<schemas[i].getNumOfFields();j++) {
+      catalog << " " << schemas[i].getFieldName(j) << " " << schemas[i].getFieldType(j);
+    }
+    if (schemas[i].isCompressed()) catalog << " compressed";
+    catalog << endl;
+  }
+  return catalog.str();
+}
+
+vector<Tuple> SchemaManager::getTrackTuples() const {
+  vector<Tuple> tuples(disk->getNumOfTracks(),Tuple::getDummyTuple());
+  for (int i=0;i<relations.size();i++) {
+    if (!relations[i].isNull()) tuples[i]=relations[i].createTuple();
+  }
+  return tuples;
+}
+
+bool SchemaManager::saveImage(string file_name) const {
+  lock_guard<recursive_mutex> guard(disk->lock);
+  return disk->saveImage(file_name,encodeCatalog(),getTrackTuples());
+}
+
+bool SchemaManager::loadImage(string file_name) {
+  if (disk->isOpen()) {
+    cerr << "loadImage ERROR: the disk keeps its tracks in a page file" << endl;
+    return false;
+  }
+  // the image is only read; the blocks of its tracks are decoded with the relations
+  if (!disk->open(file_name) || !loadCatalog()) return false;
+  return disk->closeIntoMemory(getTrackTuples());
+}
+
+bool SchemaManager::loadCatalog() {
+  if (!relations.empty()) {
+    cerr << "loadCatalog ERROR: relations have been created already" << endl;
+    return false;
+  }
+  istringstream catalog(disk->getCatalog());
+  string line;
+  while (getline(catalog,line)) {
+    istringstream in(line);
+    int index,num_fields,type;
+    string relation_name,field_name;
+    vector<string> field_names;
+    vector<enum FIELD_TYPE> field_types;
+    in >> index >> relation_name >> num_fields;
+    for (int j=0;j<num_fields && in >> field_name >> type;j++) {
+      field_names.push_back(field_name);
+      field_types.push_back((enum FIELD_TYPE)type);
+    }
+    Schema schema(field_names,field_types);
+    bool broken=!in;
+    string option;
+    if (!broken && in >> option) {
+      schema.setCompressed(option=="compressed");
+      broken=!schema.isCompressed();
+    }
+    if (broken || index<(int)relations.size() || schema.isEmpty() ||
+        relationExists(relation_name) || schema.getNumOfFields()!=num_fields) {
+      cerr << "loadCatalog ERROR: broken catalog entry: " << line << endl;
+      return false;
+    }
+    addRelation(relation_name,schema,index);
+  }
+  // the tracks beyond the last relation are empty
   return true;
 }
 
@@ -1043,18 +2011,16 @@ void SchemaManager::printSchemas() const {
 }
 
 void SchemaManager::printSchemas(ostream &out) const {
-  if (offset>0) {
-    map<string,int>::const_iterator it;
+  if (!relations.empty()) {
     int i;
-    
-    for (i=0;i<offset;i++) {
+    for (i=0;i<relations.size();i++) {
       if (!relations[i].isNull()) {
         out << relations[i].getRelationName() << endl;
         schemas[i].printSchema(out);
         break;
       }
     }
-    for (i++;i<offset;i++) {
+    for (i++;i<relations.size();i++) {
       if (!relations[i].isNull()) {
         out << endl;
         out << relations[i].getRelationName() << endl;
@@ -3,11 +3,14 @@
 
 #include <vector>
 
+#include "Config.h"
 #include "Field.h"
 #include "Schema.h"
 
 using namespace std;
 
+#define MAX_TUPLE_SIZE (MAX_NUM_OF_FIELDS_IN_RELATION*sizeof(Str20))
+
 class SchemaManager;
 
 /* A tuple equals a record/row in a relation/table.
@@ -21,21 +24,31 @@ class SchemaManager;
  *        If you need to delete a tuple inside a memory block, "null" the tuple
  *          by using Tuple::null() or Block::nullTuple() .
  *        You are able to get schema of a particular tuple through here.
+ * The fields are kept inline, so creating or copying a tuple does not allocate memory.
+ * A STR20 field holds at most STR20_CAPACITY characters.
  */
 class Tuple {
   private:
   SchemaManager* schema_manager;
   int schema_index; // points to the schema of the relation which the tuple belongs to
-  vector<union Field> fields;  // stores integer and string fields
+  bool valid; // false if the tuple is invalid
+  // stores integer and string fields one after another, as laid out by the schema;
+  // a tuple holds no pointers and copies with a memcpy
+  char data[MAX_TUPLE_SIZE];
   // DO NOT use the constructor here. Create an empty tuple only through Schema
   Tuple(SchemaManager* schema_manager, int schema_index);
+  int getSize() const; // for internal use: returns the bytes of the fields in the buffer
 
   public:
   friend class Relation; // creates a tuple
   friend class Block; // clears the tuple
+  friend class Disk; // creates a tuple when reading a page
 
   bool isNull() const; //returns true if the tuple is invalid
   Schema getSchema() const; // returns the schema of the tuple
+  // returns the schema shared by the tuples of the relation without copying it;
+  // the reference is valid until the relation is deleted
+  const Schema& getSchemaRef() const;
   int getNumOfFields() const; // returns the number of fields in the tuple
   int getTuplesPerBlock() const; // returns the number: tuples per block
 